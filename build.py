@@ -29,7 +29,8 @@ if __name__ == "__main__":
         '-IC:\\src\\tinyobjloader',
         '-IC:\\src\\volk'
     ]
-    subprocess.run(['clang++'] + gnuOptions + gnuIncludes + cpp + clangOut)
+    gnuLibraries = ['-lgdi32']
+    subprocess.run(['clang++'] + gnuOptions + gnuIncludes + cpp + gnuLibraries + clangOut)
     
     # MSVC compile
     msvcOptions = [
@@ -59,7 +60,7 @@ if __name__ == "__main__":
         for file in cpp:
             command += file + ' '
         bat.write(command + '\n\n')
-        command = 'link /OUT:build/' + name + '_msvc64.exe /DEFAULTLIB:User32 build/msvc/volk.obj build/msvc/main.obj'
+        command = 'link /OUT:build/' + name + '_msvc64.exe /DEFAULTLIB:User32 /DEFAULTLIB:Gdi32 build/msvc/volk.obj build/msvc/main.obj'
         bat.write(command + '\n\n')
         bat.close()
     subprocess.run(commandFile.absolute(), check=True, capture_output=False)
@@ -67,7 +68,12 @@ if __name__ == "__main__":
     
     # GCC compile
     gccOut   = ['-o', dir.joinpath('build', name + '_mingw64.exe').absolute()]
-    subprocess.run(['g++'] + gnuOptions + gnuIncludes + cpp + gccOut)
+    subprocess.run(['g++'] + gnuOptions + gnuIncludes + cpp + gnuLibraries + gccOut)
+    
+    # Tools, one executable per source file
+    for tool in dir.joinpath('tools').glob('*.cpp'):
+        toolOut = ['-o', dir.joinpath('build', tool.stem + '_clang64.exe').absolute()]
+        subprocess.run(['clang++'] + gnuOptions + gnuIncludes + ['-Isrc', str(tool.absolute())] + toolOut)
     
     # compile shaders
     shaders = [x.name for x in dir.joinpath('src/shaders').glob('**/*.frag')] + [x.name for x in dir.joinpath('src/shaders').glob('**/*.vert')]
@@ -0,0 +1,384 @@
+#pragma once
+
+#include "WidgetTree.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Animates widget motion: offset, scale, tint and opacity. A track drives one property of one widget,
+// either through keyframes or as a spring towards a target. Tracks are stepped on a fixed timestep
+// and kept as structure of arrays, one array per field, so the spring step is a flat loop over
+// floats the compiler vectorizes; what is shown is interpolated between the last two steps. Results
+// go to WidgetTree::setMotion(), which rewrites a 48 byte record per widget and no geometry.
+class Animator {
+     static constexpr double STEP = 1. / 120.;
+     // steps beyond these after a stall are dropped rather than caught up
+     static constexpr int MAX_STEPS = 12;
+
+  public:
+     using Id = WidgetTree::Id;
+
+     enum class Property : uint8_t {
+          OFFSET_X,
+          OFFSET_Y,
+          SCALE_X,
+          SCALE_Y,
+          RED,
+          GREEN,
+          BLUE,
+          OPACITY
+     };
+     static constexpr size_t PROPERTIES = 8;
+
+     enum class Ease : uint8_t {
+          LINEAR,
+          IN,
+          OUT,
+          IN_OUT
+     };
+
+     // `ease` shapes the segment arriving at this key. Times are in seconds from the track's start.
+     struct Key {
+          float time;
+          float value;
+          Ease  ease { Ease::LINEAR };
+     };
+
+     struct Spring {
+          float stiffness { 300.f };
+          float damping { 24.f };
+     };
+
+     struct Stats {
+          size_t keyframeTracks;
+          size_t springTracks;
+          size_t steps;
+          size_t widgetsWritten;
+     };
+
+     explicit Animator(WidgetTree* widgets)
+        : widgets_(widgets) {}
+     Animator(const Animator&)            = delete;
+     Animator(Animator&&)                 = delete;
+     Animator& operator=(const Animator&) = delete;
+     Animator& operator=(Animator&&)      = delete;
+
+     // Replaces the property's track. Keys must be in time order; without a key at time 0 the track
+     // starts from the property's current value.
+     void keyframes(Id widget, Property property, std::span<const Key> keys) {
+          if (keys.empty())
+               return;
+          auto current = value(widget, property);
+          stop(widget, property);
+          auto i = keyframes_.widget.size();
+          keyframes_.widget.push_back(widget);
+          keyframes_.property.push_back(property);
+          keyframes_.time.push_back(0.f);
+          keyframes_.first.push_back(static_cast<uint32_t>(keys_.size()));
+          keyframes_.segment.push_back(0);
+          keyframes_.previous.push_back(current);
+          keyframes_.value.push_back(current);
+          if (keys.front().time > 0.f)
+               keys_.push_back({ 0.f, current, Ease::LINEAR });
+          keys_.insert(keys_.end(), keys.begin(), keys.end());
+          keyframes_.count.push_back(static_cast<uint32_t>(keys_.size()) - keyframes_.first[i]);
+          tracks_[key(widget, property)] = { false, static_cast<uint32_t>(i) };
+     }
+
+     // Moves the property from its current value to `to` over `seconds`.
+     void transition(Id widget, Property property, float to, float seconds, Ease ease = Ease::IN_OUT) {
+          Key keys[] { { 0.f, value(widget, property), Ease::LINEAR }, { std::max(seconds, 0.f), to, ease } };
+          keyframes(widget, property, keys);
+     }
+
+     // Pulls the property towards `target`. A spring already running keeps its velocity, so targets
+     // can change every frame without a jolt.
+     void spring(Id widget, Property property, float target) { spring(widget, property, target, Spring {}); }
+     void spring(Id widget, Property property, float target, Spring spring) {
+          if (auto it = tracks_.find(key(widget, property)); it != tracks_.end() && it->second.spring) {
+               auto i                = it->second.index;
+               springs_.target[i]    = target;
+               springs_.stiffness[i] = spring.stiffness;
+               springs_.damping[i]   = spring.damping;
+               return;
+          }
+          auto current = value(widget, property);
+          stop(widget, property);
+          auto i = springs_.widget.size();
+          springs_.widget.push_back(widget);
+          springs_.property.push_back(property);
+          springs_.value.push_back(current);
+          springs_.previous.push_back(current);
+          springs_.velocity.push_back(0.f);
+          springs_.target.push_back(target);
+          springs_.stiffness.push_back(spring.stiffness);
+          springs_.damping.push_back(spring.damping);
+          tracks_[key(widget, property)] = { true, static_cast<uint32_t>(i) };
+     }
+
+     // Stops the property's track and jumps to `value`.
+     void set(Id widget, Property property, float value) {
+          stop(widget, property);
+          write(widget, property, value);
+     }
+
+     // Stops the property's track where it is.
+     void stop(Id widget, Property property) {
+          auto it = tracks_.find(key(widget, property));
+          if (it == tracks_.end())
+               return;
+          auto [spring, index] = it->second;
+          tracks_.erase(it);
+          if (spring)
+               removeSpring(index);
+          else
+               removeKeyframes(index);
+     }
+
+     // Forgets the widget, for one that is destroyed.
+     void forget(Id widget) {
+          for (size_t p = 0; p != PROPERTIES; ++p)
+               stop(widget, static_cast<Property>(p));
+          states_.erase(widget);
+     }
+
+     // The value last shown.
+     float value(Id widget, Property property) {
+          auto it = states_.find(widget);
+          return it == states_.end() ? IDENTITY[static_cast<size_t>(property)] : it->second.values[static_cast<size_t>(property)];
+     }
+
+     size_t active() { return tracks_.size(); }
+
+     // Runs the steps `seconds` of wall time make up and writes the motion of every widget a track
+     // moved. Called once per frame.
+     void advance(double seconds) {
+          stats_.steps          = 0;
+          stats_.widgetsWritten = 0;
+          if (tracks_.empty()) {
+               accumulator_ = 0.;
+               flush();
+               return;
+          }
+          accumulator_ = std::min(accumulator_ + seconds, STEP * MAX_STEPS);
+          for (; accumulator_ >= STEP; accumulator_ -= STEP) {
+               step();
+               ++stats_.steps;
+          }
+          auto alpha = static_cast<float>(accumulator_ / STEP);
+
+          for (size_t i = 0; i != springs_.widget.size(); ++i)
+               write(springs_.widget[i], springs_.property[i], springs_.previous[i] + (springs_.value[i] - springs_.previous[i]) * alpha);
+          for (size_t i = 0; i != keyframes_.widget.size(); ++i)
+               write(keyframes_.widget[i], keyframes_.property[i], keyframes_.previous[i] + (keyframes_.value[i] - keyframes_.previous[i]) * alpha);
+
+          // finished tracks are dropped once their last value is written
+          for (size_t i = springs_.widget.size(); i-- != 0;)
+               if (std::abs(springs_.velocity[i]) < SETTLED && std::abs(springs_.target[i] - springs_.value[i]) < SETTLED) {
+                    write(springs_.widget[i], springs_.property[i], springs_.target[i]);
+                    tracks_.erase(key(springs_.widget[i], springs_.property[i]));
+                    removeSpring(static_cast<uint32_t>(i));
+               }
+          for (size_t i = keyframes_.widget.size(); i-- != 0;)
+               if (keyframes_.segment[i] + 1 >= keyframes_.count[i]) {
+                    write(keyframes_.widget[i], keyframes_.property[i], keyframes_.value[i]);
+                    tracks_.erase(key(keyframes_.widget[i], keyframes_.property[i]));
+                    removeKeyframes(static_cast<uint32_t>(i));
+               }
+          flush();
+     }
+
+     Stats stats() {
+          stats_.keyframeTracks = keyframes_.widget.size();
+          stats_.springTracks   = springs_.widget.size();
+          return stats_;
+     }
+
+  private:
+     static constexpr float                         SETTLED = 1e-3f;
+     static constexpr std::array<float, PROPERTIES> IDENTITY { 0.f, 0.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f };
+
+     struct Location {
+          bool     spring;
+          uint32_t index;
+     };
+
+     struct State {
+          std::array<float, PROPERTIES> values { IDENTITY };
+          bool                          changed { false };
+     };
+
+     struct Springs {
+          std::vector<Id>       widget;
+          std::vector<Property> property;
+          std::vector<float>    value;
+          std::vector<float>    previous;
+          std::vector<float>    velocity;
+          std::vector<float>    target;
+          std::vector<float>    stiffness;
+          std::vector<float>    damping;
+     };
+
+     struct Keyframes {
+          std::vector<Id>       widget;
+          std::vector<Property> property;
+          std::vector<float>    time;
+          std::vector<uint32_t> first;
+          std::vector<uint32_t> count;
+          std::vector<uint32_t> segment;
+          std::vector<float>    value;
+          std::vector<float>    previous;
+     };
+
+     static uint64_t key(Id widget, Property property) { return static_cast<uint64_t>(widget) << 8 | static_cast<uint64_t>(property); }
+
+     static float ease(Ease ease, float t) {
+          switch (ease) {
+               case Ease::IN:
+                    return t * t * t;
+               case Ease::OUT:
+                    return 1.f - (1.f - t) * (1.f - t) * (1.f - t);
+               case Ease::IN_OUT:
+                    return t * t * (3.f - 2.f * t);
+               default:
+                    return t;
+          }
+     }
+
+     void step() {
+          constexpr auto dt = static_cast<float>(STEP);
+          // semi-implicit Euler, one flat loop per field
+          auto  n         = springs_.widget.size();
+          auto* value     = springs_.value.data();
+          auto* previous  = springs_.previous.data();
+          auto* velocity  = springs_.velocity.data();
+          auto* target    = springs_.target.data();
+          auto* stiffness = springs_.stiffness.data();
+          auto* damping   = springs_.damping.data();
+          std::copy(value, value + n, previous);
+          for (size_t i = 0; i != n; ++i)
+               velocity[i] += (stiffness[i] * (target[i] - value[i]) - damping[i] * velocity[i]) * dt;
+          for (size_t i = 0; i != n; ++i)
+               value[i] += velocity[i] * dt;
+
+          auto* time = keyframes_.time.data();
+          std::copy(keyframes_.value.begin(), keyframes_.value.end(), keyframes_.previous.begin());
+          for (size_t i = 0; i != keyframes_.widget.size(); ++i)
+               time[i] += dt;
+          for (size_t i = 0; i != keyframes_.widget.size(); ++i) {
+               auto* keys    = keys_.data() + keyframes_.first[i];
+               auto  count   = keyframes_.count[i];
+               auto& segment = keyframes_.segment[i];
+               while (segment + 1 < count && time[i] >= keys[segment + 1].time)
+                    ++segment;
+               if (segment + 1 >= count) {
+                    keyframes_.value[i] = keys[count - 1].value;
+                    continue;
+               }
+               auto& from          = keys[segment];
+               auto& to            = keys[segment + 1];
+               auto  t             = (time[i] - from.time) / (to.time - from.time);
+               keyframes_.value[i] = from.value + (to.value - from.value) * ease(to.ease, t);
+          }
+     }
+
+     void write(Id widget, Property property, float value) {
+          auto& state                                 = states_[widget];
+          state.values[static_cast<size_t>(property)] = value;
+          if (!state.changed)
+               changed_.push_back(widget);
+          state.changed = true;
+     }
+
+     void flush() {
+          for (auto widget : changed_) {
+               auto it = states_.find(widget);
+               if (it == states_.end())
+                    continue;
+               auto& v = it->second.values;
+               widgets_->setMotion(widget, { v[0], v[1] }, { v[2], v[3] }, { v[4], v[5], v[6], v[7] });
+               it->second.changed = false;
+               ++stats_.widgetsWritten;
+          }
+          changed_.clear();
+     }
+
+     // swaps the last track into the hole
+     void removeSpring(uint32_t i) {
+          auto last = static_cast<uint32_t>(springs_.widget.size() - 1);
+          if (i != last) {
+               tracks_[key(springs_.widget[last], springs_.property[last])].index = i;
+               springs_.widget[i]    = springs_.widget[last];
+               springs_.property[i]  = springs_.property[last];
+               springs_.value[i]     = springs_.value[last];
+               springs_.previous[i]  = springs_.previous[last];
+               springs_.velocity[i]  = springs_.velocity[last];
+               springs_.target[i]    = springs_.target[last];
+               springs_.stiffness[i] = springs_.stiffness[last];
+               springs_.damping[i]   = springs_.damping[last];
+          }
+          springs_.widget.pop_back();
+          springs_.property.pop_back();
+          springs_.value.pop_back();
+          springs_.previous.pop_back();
+          springs_.velocity.pop_back();
+          springs_.target.pop_back();
+          springs_.stiffness.pop_back();
+          springs_.damping.pop_back();
+     }
+
+     void removeKeyframes(uint32_t i) {
+          auto last = static_cast<uint32_t>(keyframes_.widget.size() - 1);
+          dead_ += keyframes_.count[i];
+          if (i != last) {
+               tracks_[key(keyframes_.widget[last], keyframes_.property[last])].index = i;
+               keyframes_.widget[i]   = keyframes_.widget[last];
+               keyframes_.property[i] = keyframes_.property[last];
+               keyframes_.time[i]     = keyframes_.time[last];
+               keyframes_.first[i]    = keyframes_.first[last];
+               keyframes_.count[i]    = keyframes_.count[last];
+               keyframes_.segment[i]  = keyframes_.segment[last];
+               keyframes_.value[i]    = keyframes_.value[last];
+               keyframes_.previous[i] = keyframes_.previous[last];
+          }
+          keyframes_.widget.pop_back();
+          keyframes_.property.pop_back();
+          keyframes_.time.pop_back();
+          keyframes_.first.pop_back();
+          keyframes_.count.pop_back();
+          keyframes_.segment.pop_back();
+          keyframes_.value.pop_back();
+          keyframes_.previous.pop_back();
+          // keys of removed tracks are compacted away once they are most of the array
+          if (dead_ * 2 > keys_.size()) {
+               std::vector<Key> keys;
+               keys.reserve(keys_.size() - dead_);
+               for (size_t t = 0; t != keyframes_.widget.size(); ++t) {
+                    auto first          = keyframes_.first[t];
+                    keyframes_.first[t] = static_cast<uint32_t>(keys.size());
+                    keys.insert(keys.end(), keys_.begin() + first, keys_.begin() + first + keyframes_.count[t]);
+               }
+               keys_.swap(keys);
+               dead_ = 0;
+          }
+     }
+
+     WidgetTree* widgets_;
+     double      accumulator_ { 0. };
+     size_t      dead_ { 0 };
+     Stats       stats_ {};
+
+     Springs                                 springs_;
+     Keyframes                               keyframes_;
+     std::vector<Key>                        keys_;
+     std::unordered_map<uint64_t, Location> tracks_;
+     std::unordered_map<Id, State>          states_;
+     std::vector<Id>                         changed_;
+};
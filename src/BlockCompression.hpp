@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// CPU encoders for the block-compressed texture formats. Both work on 4x4 blocks of RGBA8 texels,
+// edge blocks are padded by clamping to the last row / column of the image.
+class BlockCompression {
+  public:
+     enum Codec {
+          BC1,
+          BC7
+     };
+
+     static constexpr size_t blockBytes(Codec codec) { return codec == BC1 ? 8 : 16; }
+     static constexpr size_t compressedSize(Codec codec, uint32_t width, uint32_t height) {
+          return blockBytes(codec) * ((width + 3) / 4) * ((height + 3) / 4);
+     }
+
+     static std::vector<uint8_t> compress(Codec codec, const uint8_t* rgba, uint32_t width, uint32_t height) {
+          std::vector<uint8_t> out(compressedSize(codec, width, height));
+          compress(codec, rgba, width, height, out.data());
+          return out;
+     }
+
+     static void compress(Codec codec, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* out) {
+          std::array<uint8_t, 64> block;
+          for (uint32_t by = 0; by < height; by += 4)
+               for (uint32_t bx = 0; bx < width; bx += 4) {
+                    for (uint32_t y = 0; y != 4; ++y)
+                         for (uint32_t x = 0; x != 4; ++x) {
+                              auto sx = std::min(bx + x, width - 1);
+                              auto sy = std::min(by + y, height - 1);
+                              std::memcpy(&block[(y * 4 + x) * 4], &rgba[(static_cast<size_t>(sy) * width + sx) * 4], 4);
+                         }
+                    if (codec == BC1)
+                         encodeBC1(block.data(), out);
+                    else
+                         encodeBC7(block.data(), out);
+                    out += blockBytes(codec);
+               }
+     }
+
+     static bool isOpaque(const uint8_t* rgba, size_t texels) {
+          for (size_t i = 0; i != texels; ++i)
+               if (rgba[i * 4 + 3] != 255)
+                    return false;
+          return true;
+     }
+
+     // BC1 without punch-through alpha: endpoints from the principal axis, 4 colour palette.
+     static void encodeBC1(const uint8_t* block, uint8_t* out) {
+          auto [lo, hi] = principalEndpoints<3>(block);
+
+          auto pack565 = [](const std::array<float, 4>& c) {
+               auto r = static_cast<uint16_t>(std::clamp(std::lround(c[0] * 31.f / 255.f), 0l, 31l));
+               auto g = static_cast<uint16_t>(std::clamp(std::lround(c[1] * 63.f / 255.f), 0l, 63l));
+               auto b = static_cast<uint16_t>(std::clamp(std::lround(c[2] * 31.f / 255.f), 0l, 31l));
+               return static_cast<uint16_t>(r << 11 | g << 5 | b);
+          };
+          auto unpack565 = [](uint16_t c) {
+               auto r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+               return std::array<int, 3> { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+          };
+
+          uint16_t c0 = pack565(hi);
+          uint16_t c1 = pack565(lo);
+          if (c0 < c1)
+               std::swap(c0, c1);
+
+          uint32_t indices { 0 };
+          if (c0 != c1) {
+               auto e0 = unpack565(c0);
+               auto e1 = unpack565(c1);
+               std::array<std::array<int, 3>, 4> palette { e0, e1 };
+               for (int i = 0; i != 3; ++i) {
+                    palette[2][i] = (2 * e0[i] + e1[i]) / 3;
+                    palette[3][i] = (e0[i] + 2 * e1[i]) / 3;
+               }
+               for (uint32_t t = 0; t != 16; ++t) {
+                    uint32_t best { 0 };
+                    int      bestError { INT32_MAX };
+                    for (uint32_t p = 0; p != 4; ++p) {
+                         int error { 0 };
+                         for (int i = 0; i != 3; ++i) {
+                              int d = block[t * 4 + i] - palette[p][i];
+                              error += d * d;
+                         }
+                         if (error < bestError) {
+                              bestError = error;
+                              best      = p;
+                         }
+                    }
+                    indices |= best << (2 * t);
+               }
+          }
+          out[0] = static_cast<uint8_t>(c0);
+          out[1] = static_cast<uint8_t>(c0 >> 8);
+          out[2] = static_cast<uint8_t>(c1);
+          out[3] = static_cast<uint8_t>(c1 >> 8);
+          for (int i = 0; i != 4; ++i)
+               out[4 + i] = static_cast<uint8_t>(indices >> (8 * i));
+     }
+
+     // BC7 mode 6: a single RGBA subset with 7 bit endpoints, per-endpoint p-bits and 4 bit indices.
+     static void encodeBC7(const uint8_t* block, uint8_t* out) {
+          static constexpr std::array<int, 16> weights { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+          auto [lo, hi] = principalEndpoints<4>(block);
+
+          auto quantize = [](const std::array<float, 4>& c, std::array<int, 4>& q7) {
+               int bestP { 0 };
+               float bestError { INFINITY };
+               for (int p = 0; p != 2; ++p) {
+                    float error { 0.f };
+                    std::array<int, 4> q;
+                    for (int i = 0; i != 4; ++i) {
+                         q[i]    = std::clamp(static_cast<int>(std::lround((c[i] - p) / 2.f)), 0, 127);
+                         float d = c[i] - static_cast<float>(q[i] << 1 | p);
+                         error += d * d;
+                    }
+                    if (error < bestError) {
+                         bestError = error;
+                         bestP     = p;
+                         q7        = q;
+                    }
+               }
+               return bestP;
+          };
+
+          std::array<int, 4> q0, q1;
+          int                p0 = quantize(lo, q0);
+          int                p1 = quantize(hi, q1);
+
+          std::array<int, 4> e0, e1;
+          for (int i = 0; i != 4; ++i) {
+               e0[i] = q0[i] << 1 | p0;
+               e1[i] = q1[i] << 1 | p1;
+          }
+
+          std::array<int, 16> indices;
+          for (int t = 0; t != 16; ++t) {
+               int bestIndex { 0 };
+               int bestError { INT32_MAX };
+               for (int w = 0; w != 16; ++w) {
+                    int error { 0 };
+                    for (int i = 0; i != 4; ++i) {
+                         int v = ((64 - weights[w]) * e0[i] + weights[w] * e1[i] + 32) >> 6;
+                         int d = block[t * 4 + i] - v;
+                         error += d * d;
+                    }
+                    if (error < bestError) {
+                         bestError = error;
+                         bestIndex = w;
+                    }
+               }
+               indices[t] = bestIndex;
+          }
+
+          // the anchor index is stored with its most significant bit implied zero
+          if (indices[0] & 8) {
+               std::swap(q0, q1);
+               std::swap(p0, p1);
+               for (auto& index : indices)
+                    index = 15 - index;
+          }
+
+          BitWriter writer(out);
+          writer.write(1 << 6, 7);
+          for (int i = 0; i != 4; ++i) {
+               writer.write(q0[i], 7);
+               writer.write(q1[i], 7);
+          }
+          writer.write(p0, 1);
+          writer.write(p1, 1);
+          writer.write(indices[0], 3);
+          for (int t = 1; t != 16; ++t)
+               writer.write(indices[t], 4);
+     }
+
+  private:
+     class BitWriter {
+       public:
+          BitWriter(uint8_t* out)
+             : out_(out) { std::memset(out_, 0, 16); }
+          void write(uint32_t value, uint32_t bits) {
+               for (uint32_t i = 0; i != bits; ++i, ++position_)
+                    out_[position_ >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (position_ & 7));
+          }
+
+       private:
+          uint8_t* out_;
+          uint32_t position_ { 0 };
+     };
+
+     // Endpoints of the block projected onto its principal axis, found with a few rounds of power
+     // iteration on the covariance matrix of the first N channels.
+     template <int N>
+     static std::pair<std::array<float, 4>, std::array<float, 4>> principalEndpoints(const uint8_t* block) {
+          std::array<float, 4> mean {};
+          for (int t = 0; t != 16; ++t)
+               for (int i = 0; i != N; ++i)
+                    mean[i] += block[t * 4 + i] / 16.f;
+
+          std::array<std::array<float, 4>, 4> covariance {};
+          for (int t = 0; t != 16; ++t)
+               for (int i = 0; i != N; ++i)
+                    for (int j = 0; j != N; ++j)
+                         covariance[i][j] += (block[t * 4 + i] - mean[i]) * (block[t * 4 + j] - mean[j]);
+
+          std::array<float, 4> axis { 1.f, 1.f, 1.f, 1.f };
+          for (int round = 0; round != 8; ++round) {
+               std::array<float, 4> next {};
+               for (int i = 0; i != N; ++i)
+                    for (int j = 0; j != N; ++j)
+                         next[i] += covariance[i][j] * axis[j];
+               float length { 0.f };
+               for (int i = 0; i != N; ++i)
+                    length = std::max(length, std::abs(next[i]));
+               if (length == 0.f)
+                    break;
+               for (int i = 0; i != N; ++i)
+                    axis[i] = next[i] / length;
+          }
+
+          float minT { INFINITY }, maxT { -INFINITY };
+          for (int t = 0; t != 16; ++t) {
+               float d { 0.f };
+               for (int i = 0; i != N; ++i)
+                    d += (block[t * 4 + i] - mean[i]) * axis[i];
+               minT = std::min(minT, d);
+               maxT = std::max(maxT, d);
+          }
+
+          float norm { 0.f };
+          for (int i = 0; i != N; ++i)
+               norm += axis[i] * axis[i];
+          if (norm == 0.f)
+               norm = 1.f;
+
+          std::array<float, 4> lo { 255.f, 255.f, 255.f, 255.f }, hi { 255.f, 255.f, 255.f, 255.f };
+          for (int i = 0; i != N; ++i) {
+               lo[i] = std::clamp(mean[i] + axis[i] * minT / norm, 0.f, 255.f);
+               hi[i] = std::clamp(mean[i] + axis[i] * maxT / norm, 0.f, 255.f);
+          }
+          return { lo, hi };
+     }
+};
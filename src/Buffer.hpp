@@ -33,7 +33,16 @@ class Buffer {
           throw std::runtime_error("call to findMemoryType failed");
      }
 
-     static auto createBuffer(Core* core, Device* device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) {
+     static uint32_t findMemoryType(Device* device, uint32_t typeFilter, VkMemoryPropertyFlags preferred, VkMemoryPropertyFlags required) {
+          try {
+               return findMemoryType(device, typeFilter, preferred);
+          }
+          catch (const std::runtime_error&) {
+               return findMemoryType(device, typeFilter, required);
+          }
+     }
+
+     static auto createBuffer(Core* core, Device* device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred = 0) {
           VkBuffer           buffer;
           VkDeviceMemory     bufferMemory;
           VkBufferCreateInfo vkBufferCreateInfo {
@@ -55,7 +64,7 @@ class Buffer {
                .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
                .pNext           = nullptr,
                .allocationSize  = vkMemoryRequirements.size,
-               .memoryTypeIndex = findMemoryType(device, vkMemoryRequirements.memoryTypeBits, properties)
+               .memoryTypeIndex = findMemoryType(device, vkMemoryRequirements.memoryTypeBits, properties | preferred, properties)
           };
           if (vkAllocateMemory(device->logical(), &vkMemoryAllocateInfo, core->allocator(), &bufferMemory) != VK_SUCCESS)
                throw std::runtime_error("call to vkAllocateMemory failed to allocate buffer memory");
@@ -84,7 +93,42 @@ class Buffer {
      static Buffer makeStaging(Core* core, Device* device, CommandPool* commandPool, size_t n) {
           VkDeviceSize bufferSize     = sizeof(T) * n;
           auto [buffer, bufferMemory] = createBuffer(core, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-          return Buffer(core, device, commandPool, buffer, bufferMemory);
+          return Buffer(core, device, commandPool, buffer, bufferMemory, n);
+     }
+
+     // Staging that lands in device local memory when some of it is host visible (resizable BAR,
+     // integrated GPUs), so the copy into the image never leaves video memory.
+     static Buffer makeUpload(Core* core, Device* device, CommandPool* commandPool, size_t n) {
+          VkDeviceSize bufferSize     = sizeof(T) * n;
+          auto [buffer, bufferMemory] = createBuffer(core, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+          return Buffer(core, device, commandPool, buffer, bufferMemory, n);
+     }
+
+     // Vertices rewritten by the host every frame, mapped for as long as they live.
+     static Buffer makeDynamicVertex(Core* core, Device* device, CommandPool* commandPool, size_t n) {
+          VkDeviceSize bufferSize     = sizeof(T) * n;
+          auto [buffer, bufferMemory] = createBuffer(core, device, bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+          return Buffer(core, device, commandPool, buffer, bufferMemory, n);
+     }
+     static Buffer makeDynamicIndex(Core* core, Device* device, CommandPool* commandPool, size_t n) {
+          VkDeviceSize bufferSize     = sizeof(T) * n;
+          auto [buffer, bufferMemory] = createBuffer(core, device, bufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+          return Buffer(core, device, commandPool, buffer, bufferMemory, n);
+     }
+
+     // Storage read by shaders and rewritten by the host, mapped for as long as it lives.
+     static Buffer makeDynamicStorage(Core* core, Device* device, CommandPool* commandPool, size_t n) {
+          VkDeviceSize bufferSize     = sizeof(T) * n;
+          auto [buffer, bufferMemory] = createBuffer(core, device, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+          return Buffer(core, device, commandPool, buffer, bufferMemory, n);
+     }
+
+     // Destination for copies the host reads back; cached memory when there is some, reads from
+     // write-combined memory are slow.
+     static Buffer makeReadback(Core* core, Device* device, CommandPool* commandPool, size_t n) {
+          VkDeviceSize bufferSize     = sizeof(T) * n;
+          auto [buffer, bufferMemory] = createBuffer(core, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+          return Buffer(core, device, commandPool, buffer, bufferMemory, n);
      }
      
      static Buffer makeVertex(Core* core, Device* device, CommandPool* commandPool, std::vector<Vertex>& vertecies) {
@@ -117,6 +161,25 @@ class Buffer {
           vkUnmapMemory(device_->logical(), bufferMemory_);
      }
 
+     // Maps the whole buffer until unmap(); write() must not be used in between.
+     T* map() {
+          void* bufferAdress;
+          if (vkMapMemory(device_->logical(), bufferMemory_, 0, size_, {}, &bufferAdress) != VK_SUCCESS)
+               throw std::runtime_error("call to vkMapMemory failed");
+          return static_cast<T*>(bufferAdress);
+     }
+     void unmap() { vkUnmapMemory(device_->logical(), bufferMemory_); }
+
+     // Writes `n` elements starting at element `offset`, for staging buffers shared by several uploads.
+     void write(const T* data, size_t n, size_t offset) {
+          void* bufferAdress;
+          vkMapMemory(device_->logical(), bufferMemory_, sizeof(T) * offset, sizeof(T) * n, {}, &bufferAdress);
+          {
+               std::memcpy(bufferAdress, data, sizeof(T) * n);
+          }
+          vkUnmapMemory(device_->logical(), bufferMemory_);
+     }
+
      void copyFrom(Buffer<T>& src) {
           commandPool_->singleTimeCommand([this, &src](VkCommandBuffer commandBuffer) {
                VkBufferCopy copyRegion {
@@ -2,6 +2,8 @@
 
 #include "volk.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include <vector>
 #define FMT_HEADER_ONLY
@@ -9,25 +11,43 @@
 
 class Core {
   public:
-     Core();
+     // Without `surfaces` the instance can only draw offscreen, and needs no window system. Window
+     // surfaces exist on Windows only.
+     explicit Core(bool surfaces = true);
      ~Core();
      VkAllocationCallbacks* allocator() { return allocator_; }
      VkInstance             instance() { return instance_; }
+     bool                   surfaces() { return surfaces_; }
 
   private:
      VkAllocationCallbacks*   allocator_ { nullptr };
      VkInstance               instance_;
+     bool                     surfaces_;
+#ifdef _WIN32
      std::vector<const char*> extensions_ { VK_EXT_DEBUG_UTILS_EXTENSION_NAME, VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_WIN32_SURFACE_EXTENSION_NAME };
+#else
+     std::vector<const char*> extensions_ { VK_EXT_DEBUG_UTILS_EXTENSION_NAME };
+#endif
      std::vector<const char*> layers_ { "VK_LAYER_KHRONOS_validation" };
 };
 
-Core::Core() {
+Core::Core(bool surfaces)
+   : surfaces_(surfaces) {
+     if (!surfaces)
+          extensions_ = { VK_EXT_DEBUG_UTILS_EXTENSION_NAME };
      if (volkInitialize() != VK_SUCCESS)
           throw std::runtime_error("call to volkInitialize failed");
 
      uint32_t version {};
      vkEnumerateInstanceVersion(&version);
 
+     // validation where it is installed, as on a development machine
+     uint32_t layerCount {};
+     vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+     std::vector<VkLayerProperties> available(layerCount);
+     vkEnumerateInstanceLayerProperties(&layerCount, available.data());
+     std::erase_if(layers_, [&](const char* layer) { return std::none_of(available.begin(), available.end(), [&](auto& properties) { return std::strcmp(properties.layerName, layer) == 0; }); });
+
      VkApplicationInfo application_info {
           .sType              = VK_STRUCTURE_TYPE_APPLICATION_INFO,
           .pNext              = nullptr,
@@ -5,8 +5,6 @@
 #include <glm/glm.hpp>
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
 
 
 // const auto MODEL_PATH   = "models\\viking_room.obj";
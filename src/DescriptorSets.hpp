@@ -11,21 +11,39 @@ class DescriptorSetLayout {
      VkDescriptorSetLayout descriptorSetLayout_;
 
   public:
-     DescriptorSetLayout(Core* core, Device* device)
+     // Binding 0 is the bindless texture table: a partially bound, update-after-bind array indexed by
+     // the per-vertex texture slot. Binding 1 is the widgets' motion buffer.
+     DescriptorSetLayout(Core* core, Device* device, uint32_t textureCount)
         : core_(core)
-        , device_(device) {
+        , device_(device)
+        , textureCount_(textureCount) {
           std::vector<VkDescriptorSetLayoutBinding> bindings {
                { .binding             = 0,
                   .descriptorType     = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                  .descriptorCount    = 1,
+                  .descriptorCount    = textureCount_,
                   .stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT,
+                  .pImmutableSamplers = nullptr },
+               { .binding             = 1,
+                  .descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                  .descriptorCount    = 1,
+                  .stageFlags         = VK_SHADER_STAGE_VERTEX_BIT,
                   .pImmutableSamplers = nullptr }
           };
+          std::vector<VkDescriptorBindingFlags> bindingFlags {
+               VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT,
+               0
+          };
+          VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo {
+               .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+               .pNext         = nullptr,
+               .bindingCount  = static_cast<uint32_t>(bindingFlags.size()),
+               .pBindingFlags = bindingFlags.data()
+          };
 
           VkDescriptorSetLayoutCreateInfo vkDescriptorSetLayoutCreateInfo {
                .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-               .pNext        = nullptr,
-               .flags        = {},
+               .pNext        = &bindingFlagsCreateInfo,
+               .flags        = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
                .bindingCount = static_cast<uint32_t>(bindings.size()),
                .pBindings    = bindings.data()
           };
@@ -36,6 +54,10 @@ class DescriptorSetLayout {
           vkDestroyDescriptorSetLayout(device_->logical(), descriptorSetLayout_, core_->allocator());
      }
      auto& get() { return descriptorSetLayout_; }
+     auto  textureCount() { return textureCount_; }
+
+  private:
+     uint32_t textureCount_;
 };
 
 class DescriptorPool {
@@ -45,19 +67,21 @@ class DescriptorPool {
      VkDescriptorPool             descriptorPool_;
 
   public:
-     DescriptorPool(Core* core, Device* device, DescriptorSetLayout* descriptorSetLayout)
+     DescriptorPool(Core* core, Device* device, DescriptorSetLayout* descriptorSetLayout, size_t maxSets)
         : core_(core)
         , device_(device)
         , descriptorSetLayout_(descriptorSetLayout) {
           std::vector<VkDescriptorPoolSize> descriptorPoolSizes {
                { .type             = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                  .descriptorCount = static_cast<uint32_t>(2) }
+                  .descriptorCount = static_cast<uint32_t>(maxSets) * descriptorSetLayout_->textureCount() },
+               { .type             = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                  .descriptorCount = static_cast<uint32_t>(maxSets) }
           };
           VkDescriptorPoolCreateInfo descriptorPoolCreateInfo {
                .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
                .pNext         = nullptr,
-               .flags         = {},
-               .maxSets       = static_cast<uint32_t>(2),
+               .flags         = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+               .maxSets       = static_cast<uint32_t>(maxSets),
                .poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size()),
                .pPoolSizes    = descriptorPoolSizes.data()
           };
@@ -70,7 +94,7 @@ class DescriptorPool {
      }
      
 
-     auto createDescriptorSets(size_t maxFramesInFlight, Texture* texture) {
+     auto createDescriptorSets(size_t maxFramesInFlight) {
           std::vector<VkDescriptorSet> descriptorSets(maxFramesInFlight);
           std::vector<VkDescriptorSetLayout> descriptorSetLayouts(maxFramesInFlight, descriptorSetLayout_->get());
           VkDescriptorSetAllocateInfo        descriptorSetAllocateInfo {
@@ -80,30 +104,9 @@ class DescriptorPool {
                       .descriptorSetCount = static_cast<uint32_t>(maxFramesInFlight),
                       .pSetLayouts        = descriptorSetLayouts.data()
           };
-          
+
           if (vkAllocateDescriptorSets(device_->logical(), &descriptorSetAllocateInfo, descriptorSets.data()) != VK_SUCCESS)
                throw std::runtime_error("call to vkAllocateDescriptorSets failed");
-
-          for (size_t i = 0; i != maxFramesInFlight; ++i) {
-               VkDescriptorImageInfo descriptorImageInfo {
-                    .sampler     = texture->sampler(),
-                    .imageView   = texture->view(),
-                    .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-               };
-               std::vector<VkWriteDescriptorSet> writeDescriptorSet {
-                    { .sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                       .pNext            = nullptr,
-                       .dstSet           = descriptorSets[i],
-                       .dstBinding       = 0,
-                       .dstArrayElement  = 0,
-                       .descriptorCount  = 1,
-                       .descriptorType   = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                       .pImageInfo       = &descriptorImageInfo,
-                       .pBufferInfo      = nullptr,
-                       .pTexelBufferView = nullptr }
-               };
-               vkUpdateDescriptorSets(device_->logical(), static_cast<uint32_t>(writeDescriptorSet.size()), writeDescriptorSet.data(), 0, nullptr);
-          }
           return descriptorSets;
      }
   private:
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "Core.hpp"
+
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+class Device {
+  public:
+     enum QueuePriority {
+          GRAPHICS_LOW,
+          GRAPHICS_MEDIUM,
+          GRAPHICS_HIGH,
+          GRAPHICS_REALTIME,
+          TRANSFER_LOW,
+          TRANSFER_MEDIUM,
+          TRANSFER_HIGH,
+          TRANSFER_REALTIME,
+          COMPUTE_LOW,
+          COMPUTE_MEDIUM,
+          COMPUTE_HIGH,
+          COMPUTE_REALTIME
+     };
+
+     Device(Core* core);
+     ~Device();
+
+     auto physical() { return physicalDevice_; }
+     auto logical() { return device_; }
+
+     auto present() { return queue_; }
+     auto graphics() { return queue_; }
+     auto transfer() { return queue_; }
+
+     auto& features() { return features_; }
+     auto& features12() { return features12_; }
+
+     // Largest sampled-image array a single update-after-bind set can hold on this device.
+     uint32_t maxBindlessTextures() {
+          VkPhysicalDeviceVulkan12Properties properties12 {};
+          properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+          VkPhysicalDeviceProperties2 properties {
+               .sType      = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+               .pNext      = &properties12,
+               .properties = {}
+          };
+          vkGetPhysicalDeviceProperties2(physicalDevice_, &properties);
+          return std::min(properties12.maxPerStageDescriptorUpdateAfterBindSampledImages, properties12.maxDescriptorSetUpdateAfterBindSampledImages);
+     }
+     // Nanoseconds per timestamp tick, 0 when the graphics queue cannot write timestamps.
+     float timestampPeriod() {
+          VkPhysicalDeviceProperties properties {};
+          vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+          return properties.limits.timestampComputeAndGraphics ? properties.limits.timestampPeriod : 0.f;
+     }
+     bool  supportsFormat(VkFormat format, VkFormatFeatureFlags required) {
+          VkFormatProperties properties {};
+          vkGetPhysicalDeviceFormatProperties(physicalDevice_, format, &properties);
+          return (properties.optimalTilingFeatures & required) == required;
+     }
+
+  private:
+     void queueSetup() {
+          vkGetDeviceQueue(device_, 0, 0, &queue_);
+     }
+
+     Core*            core_;
+     VkPhysicalDevice physicalDevice_;
+     VkDevice         device_;
+
+     VkQueue queue_;
+
+     VkPhysicalDeviceFeatures         features_ {};
+     VkPhysicalDeviceVulkan12Features features12_ {};
+
+     std::vector<const char*> extensions_ { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+};
+
+Device::Device(Core* core)
+   : core_(core) {
+     // swapchains need the instance's surface extension
+     if (!core_->surfaces())
+          extensions_.clear();
+     uint32_t count = 1;
+     vkEnumeratePhysicalDevices(core_->instance(), &count, &physicalDevice_);
+
+     count = 2;
+     VkQueueFamilyProperties qfp[2];
+     vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &count, qfp);
+
+     fmt::print("vkGetPhysicalDeviceQueueFamilyProperties count: {}\n", count);
+     fmt::print("QueueFamilyProperties[0].queueCount: {}\n", qfp[0].queueCount);
+     fmt::print("QueueFamilyProperties[1].queueCount: {}\n", qfp[1].queueCount);
+
+     float queuePriority = 1.f;
+
+     const std::vector<VkDeviceQueueCreateInfo> deviceQueueCreateInfos = {
+          VkDeviceQueueCreateInfo {
+             .sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+             .pNext            = nullptr,
+             .flags            = {},
+             .queueFamilyIndex = 0,
+             .queueCount       = 1,
+             .pQueuePriorities = &queuePriority }
+     };
+
+     VkPhysicalDeviceVulkan12Features supportedFeatures12 {};
+     supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+     VkPhysicalDeviceFeatures2        supportedFeatures2 {
+          .sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+          .pNext    = &supportedFeatures12,
+          .features = {}
+     };
+     vkGetPhysicalDeviceFeatures2(physicalDevice_, &supportedFeatures2);
+     const auto& supportedFeatures = supportedFeatures2.features;
+
+     if (!supportedFeatures12.runtimeDescriptorArray || !supportedFeatures12.descriptorBindingPartiallyBound || !supportedFeatures12.descriptorBindingSampledImageUpdateAfterBind || !supportedFeatures12.shaderSampledImageArrayNonUniformIndexing)
+          throw std::runtime_error("physical device does not support descriptor indexing");
+
+     features_.samplerAnisotropy    = VK_TRUE;
+     features_.sampleRateShading    = VK_TRUE;
+     features_.fillModeNonSolid     = VK_TRUE;
+     features_.textureCompressionBC = supportedFeatures.textureCompressionBC;
+
+     features12_.sType                                        = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+     features12_.runtimeDescriptorArray                       = VK_TRUE;
+     features12_.descriptorBindingPartiallyBound              = VK_TRUE;
+     features12_.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+     features12_.shaderSampledImageArrayNonUniformIndexing    = VK_TRUE;
+
+     VkPhysicalDeviceFeatures2 enabledFeatures2 {
+          .sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+          .pNext    = &features12_,
+          .features = features_
+     };
+
+     VkDeviceCreateInfo device_create_info {
+          .sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+          .pNext                   = &enabledFeatures2,
+          .flags                   = {},
+          .queueCreateInfoCount    = static_cast<uint32_t>(deviceQueueCreateInfos.size()),
+          .pQueueCreateInfos       = deviceQueueCreateInfos.data(),
+          .enabledLayerCount       = 0,
+          .ppEnabledLayerNames     = nullptr,
+          .enabledExtensionCount   = static_cast<uint32_t>(extensions_.size()),
+          .ppEnabledExtensionNames = extensions_.data(),
+          .pEnabledFeatures        = nullptr
+     };
+     if (vkCreateDevice(physicalDevice_, &device_create_info, core_->allocator(), &device_) != VK_SUCCESS)
+          throw std::runtime_error("call to vkCreateDevice failed");
+
+     queueSetup();
+}
+
+Device::~Device() {
+     vkDestroyDevice(device_, core_->allocator());
+}
@@ -0,0 +1,549 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "CommandPool.hpp"
+#include "Core.hpp"
+#include "Device.hpp"
+#include "Path.hpp"
+#include "Vertex.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+// Immediate style 2D drawing in window pixels. Calls append to a compact command stream; publishing
+// the list runs a batching pass that groups commands by pipeline and clip rectangle and hands the
+// geometry of every batch to the thread that draws, whose DrawListBuffers write it with one vertex and
+// one index copy and draw each batch once. Textures are bindless, so they never split a batch. A
+// command joins an earlier batch with its state only if it overlaps nothing drawn after that batch,
+// which keeps painter's order wherever it is visible. Commands are kept until clear(): static content
+// is recorded once, animated content is cleared and recorded again each frame. The list draws above
+// everything else and ignores depth.
+class DrawList {
+     static constexpr uint32_t NONE = ~0u;
+     // batches searched back for one a command could join
+     static constexpr size_t SEARCH = 16;
+
+     enum class Kind : uint8_t {
+          RECT,
+          ROUNDED_RECT,
+          LINE,
+          IMAGE,
+          GLYPHS,
+          MESH
+     };
+
+     struct Rect {
+          glm::vec2 low;
+          glm::vec2 high;
+
+          bool empty() const { return !(low.x < high.x && low.y < high.y); }
+          bool overlaps(const Rect& other) const { return low.x < other.high.x && other.low.x < high.x && low.y < other.high.y && other.low.y < high.y; }
+          Rect intersect(const Rect& other) const { return { glm::max(low, other.low), glm::min(high, other.high) }; }
+          Rect unite(const Rect& other) const { return { glm::min(low, other.low), glm::max(high, other.high) }; }
+          bool operator==(const Rect&) const = default;
+     };
+
+  public:
+     using Color = uint32_t;
+
+     enum class Pipeline : uint8_t {
+          SHAPES,
+          TEXT
+     };
+     static constexpr size_t PIPELINES = 2;
+
+     // A glyph of a signed distance field atlas, in window pixels.
+     struct Glyph {
+          glm::vec2 low;
+          glm::vec2 high;
+          glm::vec2 uvLow;
+          glm::vec2 uvHigh;
+          uint32_t  texture;
+     };
+
+     // Why a command started a new batch.
+     enum Break {
+          PIPELINE, // the previous batch uses another pipeline
+          CLIP,     // the previous batch uses the same pipeline with another clip rectangle
+          OVERLAP,  // a batch with the same state exists, but something drawn after it is underneath
+          LOOKBACK, // a batch with the same state is further back than the search goes
+          BREAKS
+     };
+
+     struct Stats {
+          size_t                     commands;
+          size_t                     culled;
+          size_t                     batches;
+          size_t                     pipelineBinds;
+          size_t                     scissorChanges;
+          size_t                     vertices;
+          size_t                     indices;
+          std::array<size_t, BREAKS> breaks;
+     };
+
+     struct Draw {
+          Pipeline pipeline;
+          uint16_t clip;
+          VkRect2D scissor;
+          uint32_t firstIndex;
+          uint32_t indexCount;
+     };
+     // The batched list, as a frame packet carries it to the thread that draws.
+     struct Batches {
+          bool                  changed { false }; // otherwise the batches last handed over stay
+          std::vector<Draw>     draws;
+          std::vector<Vertex2D> vertices;
+          std::vector<uint32_t> indices;
+     };
+
+     // Packs an sRGB encoded colour.
+     static constexpr Color rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+          return static_cast<Color>(r) | static_cast<Color>(g) << 8 | static_cast<Color>(b) << 16 | static_cast<Color>(a) << 24;
+     }
+
+     DrawList() {
+          clips_.push_back({ glm::vec2 { std::numeric_limits<float>::lowest() }, glm::vec2 { std::numeric_limits<float>::max() } });
+          clipStack_.push_back(0);
+     }
+     DrawList(const DrawList&)            = delete;
+     DrawList(DrawList&&)                 = delete;
+     DrawList& operator=(const DrawList&) = delete;
+     DrawList& operator=(DrawList&&)      = delete;
+
+     void rect(glm::vec2 position, glm::vec2 size, Color color) {
+          push({ .kind = Kind::RECT, .color = color, .a = position, .b = position + size });
+     }
+     // `radius` is clamped to half the shorter side.
+     void roundedRect(glm::vec2 position, glm::vec2 size, float radius, Color color) {
+          push({ .kind = Kind::ROUNDED_RECT, .color = color, .a = position, .b = position + size, .param = radius });
+     }
+     void line(glm::vec2 from, glm::vec2 to, float width, Color color) {
+          push({ .kind = Kind::LINE, .color = color, .a = from, .b = to, .param = width });
+     }
+     // `texture` is a texture table slot, multiplied by `tint`.
+     void image(glm::vec2 position, glm::vec2 size, uint32_t texture, Color tint = rgba(255, 255, 255), glm::vec2 uvLow = { 0.f, 0.f }, glm::vec2 uvHigh = { 1.f, 1.f }) {
+          push({ .kind = Kind::IMAGE, .color = tint, .texture = texture, .a = position, .b = position + size, .uvLow = uvLow, .uvHigh = uvHigh });
+          if (std::find(textures_.begin(), textures_.end(), texture) == textures_.end())
+               textures_.push_back(texture);
+     }
+
+     // Any number of glyphs as one command, so a page of text batches as a whole.
+     void glyphs(std::span<const Glyph> glyphs, Color color) {
+          if (glyphs.empty())
+               return;
+          Command command { .kind = Kind::GLYPHS, .pipeline = Pipeline::TEXT, .color = color, .a = glyphs[0].low, .b = glyphs[0].high, .first = static_cast<uint32_t>(glyphs_.size()), .count = static_cast<uint32_t>(glyphs.size()) };
+          for (auto& glyph : glyphs) {
+               command.a = glm::min(command.a, glyph.low);
+               command.b = glm::max(command.b, glyph.high);
+               if (std::find(textures_.begin(), textures_.end(), glyph.texture) == textures_.end())
+                    textures_.push_back(glyph.texture);
+          }
+          glyphs_.insert(glyphs_.end(), glyphs.begin(), glyphs.end());
+          push(command);
+     }
+
+     // A tessellated path at `scale` pixels per path unit, its origin at `position`. The mesh is
+     // shared rather than copied, so a PathCache mesh drawn every frame costs nothing to record.
+     void path(std::shared_ptr<const PathMesh> mesh, glm::vec2 position, float scale, Color color) {
+          if (mesh->indices.empty())
+               return;
+          push({ .kind = Kind::MESH, .color = color, .a = position + mesh->low * scale, .b = position + mesh->high * scale, .first = static_cast<uint32_t>(meshes_.size()) });
+          meshes_.push_back({ std::move(mesh), position, scale });
+     }
+
+     // Clips what is drawn until the matching popClip() to the rectangle, within the enclosing clip.
+     void pushClip(glm::vec2 position, glm::vec2 size) {
+          auto clip = clips_[clipStack_.back()].intersect({ position, position + size });
+          // equal rectangles share an index, so they batch together
+          auto it = std::find(clips_.begin(), clips_.end(), clip);
+          if (it == clips_.end()) {
+               if (clips_.size() > std::numeric_limits<uint16_t>::max())
+                    throw std::runtime_error("too many clip rectangles in draw list");
+               it = clips_.insert(clips_.end(), clip);
+          }
+          clipStack_.push_back(static_cast<uint16_t>(it - clips_.begin()));
+     }
+     void popClip() {
+          if (clipStack_.size() > 1)
+               clipStack_.pop_back();
+     }
+
+     void clear() {
+          commands_.clear();
+          glyphs_.clear();
+          meshes_.clear();
+          textures_.clear();
+          clips_.resize(1);
+          clipStack_.resize(1);
+          changed_ = true;
+     }
+     bool empty() { return commands_.empty(); }
+
+     // Texture slots the list samples, for the texture cache.
+     const std::vector<uint32_t>& textures() { return textures_; }
+
+     // Batches the commands if they or the window changed and hands the batches to `batches`, whose
+     // vectors are swapped rather than copied.
+     void publish(Batches& batches, VkExtent2D window) {
+          batches.changed = changed_ || window.width != window_.width || window.height != window_.height;
+          if (!batches.changed)
+               return;
+          window_ = window;
+          build();
+          changed_ = false;
+          batches.draws.clear();
+          for (auto& batch : batches_)
+               batches.draws.push_back({ .pipeline = batch.pipeline, .clip = batch.clip, .scissor = scissor(clips_[batch.clip]), .firstIndex = batch.firstIndex, .indexCount = batch.indexCount });
+          std::swap(batches.vertices, vertices_);
+          std::swap(batches.indices, indices_);
+     }
+
+     // Of the last batching pass.
+     Stats stats() { return stats_; }
+
+  private:
+     struct Command {
+          Kind      kind;
+          Pipeline  pipeline { Pipeline::SHAPES };
+          uint16_t  clip { 0 };
+          Color     color;
+          uint32_t  texture { NONE };
+          glm::vec2 a;             // corner, or line start
+          glm::vec2 b;             // opposite corner, or line end
+          float     param { 0.f }; // corner radius or line width
+          glm::vec2 uvLow { 0.f, 0.f };
+          glm::vec2 uvHigh { 1.f, 1.f };
+          uint32_t  first { 0 }; // range of glyphs_, or index of meshes_
+          uint32_t  count { 0 };
+     };
+
+     struct Mesh {
+          std::shared_ptr<const PathMesh> mesh;
+          glm::vec2                       position;
+          float                           scale;
+     };
+
+     struct Batch {
+          Pipeline pipeline;
+          uint16_t clip;
+          Rect     bounds;
+          uint32_t commands;
+          uint32_t firstIndex;
+          uint32_t indexCount;
+     };
+
+     void push(Command command) {
+          command.clip = clipStack_.back();
+          commands_.push_back(command);
+          changed_ = true;
+     }
+
+     static Rect bounds(const Command& command) {
+          Rect rect { glm::min(command.a, command.b), glm::max(command.a, command.b) };
+          if (command.kind == Kind::LINE) {
+               rect.low  -= command.param / 2.f;
+               rect.high += command.param / 2.f;
+          }
+          return rect;
+     }
+
+     static uint32_t key(Pipeline pipeline, uint16_t clip) { return static_cast<uint32_t>(pipeline) << 16 | clip; }
+
+     VkRect2D scissor(const Rect& clip) {
+          auto low  = glm::clamp(glm::floor(clip.low), glm::vec2 { 0.f }, glm::vec2 { static_cast<float>(window_.width), static_cast<float>(window_.height) });
+          auto high = glm::clamp(glm::ceil(clip.high), low, glm::vec2 { static_cast<float>(window_.width), static_cast<float>(window_.height) });
+          return VkRect2D {
+               .offset = { static_cast<int32_t>(low.x), static_cast<int32_t>(low.y) },
+               .extent = { static_cast<uint32_t>(high.x - low.x), static_cast<uint32_t>(high.y - low.y) }
+          };
+     }
+
+     void build() {
+          batches_.clear();
+          vertices_.clear();
+          indices_.clear();
+          stats_          = Stats {};
+          stats_.commands = commands_.size();
+          std::unordered_map<uint32_t, size_t> lastBatch;
+          std::vector<uint32_t>                batchOf(commands_.size(), NONE);
+          Rect                                 screen { { 0.f, 0.f }, { static_cast<float>(window_.width), static_cast<float>(window_.height) } };
+
+          for (size_t i = 0; i != commands_.size(); ++i) {
+               auto& command = commands_[i];
+               auto  box     = bounds(command).intersect(clips_[command.clip]).intersect(screen);
+               if (box.empty()) {
+                    ++stats_.culled;
+                    continue;
+               }
+               // newest first; a batch the command overlaps may not be jumped over
+               auto   stop    = batches_.size() > SEARCH ? batches_.size() - SEARCH : 0;
+               auto   target  = NONE;
+               bool   blocked = false;
+               bool   found   = false;
+               for (auto b = batches_.size(); b-- > stop;) {
+                    auto& batch = batches_[b];
+                    if (batch.pipeline == command.pipeline && batch.clip == command.clip) {
+                         if (!blocked)
+                              target = static_cast<uint32_t>(b);
+                         found = true;
+                         break;
+                    }
+                    blocked = blocked || batch.bounds.overlaps(box);
+               }
+               if (target == NONE) {
+                    if (!batches_.empty()) {
+                         auto last = lastBatch.find(key(command.pipeline, command.clip));
+                         if (found)
+                              ++stats_.breaks[OVERLAP];
+                         else if (last != lastBatch.end() && last->second < stop)
+                              ++stats_.breaks[LOOKBACK];
+                         else if (batches_.back().pipeline != command.pipeline)
+                              ++stats_.breaks[PIPELINE];
+                         else
+                              ++stats_.breaks[CLIP];
+                    }
+                    target = static_cast<uint32_t>(batches_.size());
+                    batches_.push_back({ .pipeline = command.pipeline, .clip = command.clip, .bounds = box, .commands = 0, .firstIndex = 0, .indexCount = 0 });
+                    lastBatch[key(command.pipeline, command.clip)] = target;
+               }
+               auto& batch  = batches_[target];
+               batch.bounds = batch.bounds.unite(box);
+               ++batch.commands;
+               batchOf[i] = target;
+          }
+
+          // commands in batch order, each batch keeping the order it was recorded in
+          std::vector<uint32_t> start(batches_.size() + 1, 0);
+          for (size_t b = 0; b != batches_.size(); ++b)
+               start[b + 1] = start[b] + batches_[b].commands;
+          std::vector<uint32_t> order(start.back());
+          for (size_t i = 0; i != commands_.size(); ++i)
+               if (batchOf[i] != NONE)
+                    order[start[batchOf[i]]++] = static_cast<uint32_t>(i);
+
+          size_t next = 0;
+          for (auto& batch : batches_) {
+               batch.firstIndex = static_cast<uint32_t>(indices_.size());
+               for (size_t n = 0; n != batch.commands; ++n)
+                    emit(commands_[order[next++]]);
+               batch.indexCount = static_cast<uint32_t>(indices_.size()) - batch.firstIndex;
+          }
+
+          stats_.batches  = batches_.size();
+          stats_.vertices = vertices_.size();
+          stats_.indices  = indices_.size();
+          for (size_t b = 0; b != batches_.size(); ++b) {
+               stats_.pipelineBinds += b == 0 || batches_[b - 1].pipeline != batches_[b].pipeline;
+               stats_.scissorChanges += b == 0 || batches_[b - 1].clip != batches_[b].clip;
+          }
+     }
+
+     void emit(const Command& command) {
+          switch (command.kind) {
+               case Kind::RECT:
+               case Kind::IMAGE:
+                    quad({ glm::min(command.a, command.b), glm::max(command.a, command.b) }, command.uvLow, command.uvHigh, command.color, command.texture);
+                    break;
+               case Kind::ROUNDED_RECT:
+                    roundedRect(command);
+                    break;
+               case Kind::LINE:
+                    line(command);
+                    break;
+               case Kind::GLYPHS:
+                    for (auto i = command.first; i != command.first + command.count; ++i) {
+                         auto& glyph = glyphs_[i];
+                         quad({ glyph.low, glyph.high }, glyph.uvLow, glyph.uvHigh, command.color, glyph.texture);
+                    }
+                    break;
+               case Kind::MESH: {
+                    auto& mesh = meshes_[command.first];
+                    auto  base = static_cast<uint32_t>(vertices_.size());
+                    for (auto& point : mesh.mesh->points)
+                         vertex(mesh.position + point * mesh.scale, {}, command.color, command.texture);
+                    for (auto index : mesh.mesh->indices)
+                         indices_.push_back(base + index);
+               } break;
+          }
+     }
+
+     glm::vec2 toNdc(glm::vec2 p) { return { 2.f * p.x / static_cast<float>(window_.width) - 1.f, 2.f * p.y / static_cast<float>(window_.height) - 1.f }; }
+
+     void vertex(glm::vec2 position, glm::vec2 uv, Color color, uint32_t texture) {
+          vertices_.push_back(Vertex2D { .position = toNdc(position), .textureCoordinate = uv, .color = color, .texture = texture });
+     }
+
+     void quad(Rect rect, glm::vec2 uvLow, glm::vec2 uvHigh, Color color, uint32_t texture) {
+          auto base = static_cast<uint32_t>(vertices_.size());
+          vertex(rect.low, uvLow, color, texture);
+          vertex({ rect.high.x, rect.low.y }, { uvHigh.x, uvLow.y }, color, texture);
+          vertex(rect.high, uvHigh, color, texture);
+          vertex({ rect.low.x, rect.high.y }, { uvLow.x, uvHigh.y }, color, texture);
+          indices_.insert(indices_.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+     }
+
+     // A fan around the centre, a quarter circle of segments per corner.
+     void roundedRect(const Command& command) {
+          Rect rect { glm::min(command.a, command.b), glm::max(command.a, command.b) };
+          auto size   = rect.high - rect.low;
+          auto radius = std::min(command.param, std::min(size.x, size.y) / 2.f);
+          if (radius < .5f) {
+               quad(rect, {}, {}, command.color, command.texture);
+               return;
+          }
+          auto segments = static_cast<uint32_t>(std::clamp(std::ceil(2.f * std::sqrt(radius)), 2.f, 16.f));
+          auto base     = static_cast<uint32_t>(vertices_.size());
+          vertex((rect.low + rect.high) / 2.f, {}, command.color, command.texture);
+          std::array<glm::vec2, 4> centres {
+               glm::vec2 { rect.high.x - radius, rect.low.y + radius },
+               glm::vec2 { rect.high.x - radius, rect.high.y - radius },
+               glm::vec2 { rect.low.x + radius, rect.high.y - radius },
+               glm::vec2 { rect.low.x + radius, rect.low.y + radius }
+          };
+          constexpr float quarter = 1.57079632679f;
+          for (uint32_t corner = 0; corner != 4; ++corner)
+               for (uint32_t s = 0; s <= segments; ++s) {
+                    auto angle = quarter * (static_cast<float>(corner) - 1.f + static_cast<float>(s) / static_cast<float>(segments));
+                    vertex(centres[corner] + radius * glm::vec2 { std::cos(angle), std::sin(angle) }, {}, command.color, command.texture);
+               }
+          auto ring = 4 * (segments + 1);
+          for (uint32_t j = 0; j != ring; ++j)
+               indices_.insert(indices_.end(), { base, base + 1 + j, base + 1 + (j + 1) % ring });
+     }
+
+     void line(const Command& command) {
+          auto direction = command.b - command.a;
+          auto length    = glm::length(direction);
+          if (length == 0.f)
+               return;
+          auto normal = glm::vec2 { -direction.y, direction.x } * (command.param / 2.f / length);
+          auto base   = static_cast<uint32_t>(vertices_.size());
+          vertex(command.a + normal, {}, command.color, command.texture);
+          vertex(command.b + normal, {}, command.color, command.texture);
+          vertex(command.b - normal, {}, command.color, command.texture);
+          vertex(command.a - normal, {}, command.color, command.texture);
+          indices_.insert(indices_.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+     }
+
+     VkExtent2D window_ { 0, 0 };
+     bool       changed_ { true };
+     Stats      stats_ {};
+
+     std::vector<Command>  commands_;
+     std::vector<Glyph>    glyphs_;
+     std::vector<Mesh>     meshes_;
+     std::vector<Rect>     clips_;
+     std::vector<uint16_t> clipStack_;
+     std::vector<uint32_t> textures_;
+     std::vector<Batch>    batches_;
+     std::vector<Vertex2D> vertices_;
+     std::vector<uint32_t> indices_;
+};
+
+// The batches of a draw list on the thread that draws, written to a mapped vertex and index buffer
+// per frame in flight whenever a packet brings new ones.
+class DrawListBuffers {
+     struct Copy {
+          std::optional<Buffer<Vertex2D>> vertices;
+          std::optional<Buffer<uint32_t>> indices;
+          Vertex2D*                       mappedVertices { nullptr };
+          uint32_t*                       mappedIndices { nullptr };
+          size_t                          vertexCapacity { 0 };
+          size_t                          indexCapacity { 0 };
+          uint64_t                        generation { ~0ull };
+     };
+
+  public:
+     DrawListBuffers(Core* core, Device* device, CommandPool* commandPool, size_t maxFramesInFlight)
+        : core_(core)
+        , device_(device)
+        , commandPool_(commandPool)
+        , copies_(maxFramesInFlight) {}
+     ~DrawListBuffers() {
+          for (auto& copy : copies_) {
+               if (copy.vertices)
+                    copy.vertices->unmap();
+               if (copy.indices)
+                    copy.indices->unmap();
+          }
+     }
+     DrawListBuffers(const DrawListBuffers&)            = delete;
+     DrawListBuffers(DrawListBuffers&&)                 = delete;
+     DrawListBuffers& operator=(const DrawListBuffers&) = delete;
+     DrawListBuffers& operator=(DrawListBuffers&&)      = delete;
+
+     // Takes the batches by swapping, `batches` is left with the ones they replace.
+     void apply(DrawList::Batches& batches) {
+          if (!batches.changed)
+               return;
+          std::swap(draws_, batches.draws);
+          std::swap(vertices_, batches.vertices);
+          std::swap(indices_, batches.indices);
+          ++generation_;
+     }
+
+     // Brings frame `frame`'s buffers up to date and draws, inside the render pass with the
+     // descriptor set bound. `pipelines` is indexed by DrawList::Pipeline. Leaves the scissor set to
+     // the last batch's clip.
+     void record(size_t frame, CommandBuffer* commandBuffer, std::span<const VkPipeline> pipelines) {
+          if (draws_.empty())
+               return;
+
+          auto& copy = copies_[frame];
+          if (copy.generation != generation_) {
+               if (copy.vertexCapacity < vertices_.size()) {
+                    if (copy.vertices)
+                         copy.vertices->unmap();
+                    copy.vertexCapacity = std::max(vertices_.size(), copy.vertexCapacity * 2);
+                    copy.vertices.emplace(Buffer<Vertex2D>::makeDynamicVertex(core_, device_, commandPool_, copy.vertexCapacity));
+                    copy.mappedVertices = copy.vertices->map();
+               }
+               if (copy.indexCapacity < indices_.size()) {
+                    if (copy.indices)
+                         copy.indices->unmap();
+                    copy.indexCapacity = std::max(indices_.size(), copy.indexCapacity * 2);
+                    copy.indices.emplace(Buffer<uint32_t>::makeDynamicIndex(core_, device_, commandPool_, copy.indexCapacity));
+                    copy.mappedIndices = copy.indices->map();
+               }
+               std::memcpy(copy.mappedVertices, vertices_.data(), vertices_.size() * sizeof(Vertex2D));
+               std::memcpy(copy.mappedIndices, indices_.data(), indices_.size() * sizeof(uint32_t));
+               copy.generation = generation_;
+          }
+
+          VkBuffer     vertexBuffers[]     = { copy.vertices->get() };
+          VkDeviceSize deviceSizeOffsets[] = { 0 };
+          vkCmdBindVertexBuffers(commandBuffer->get(), 0, 1, vertexBuffers, deviceSizeOffsets);
+          vkCmdBindIndexBuffer(commandBuffer->get(), copy.indices->get(), 0, VK_INDEX_TYPE_UINT32);
+          const DrawList::Draw* previous = nullptr;
+          for (auto& draw : draws_) {
+               if (!previous || previous->pipeline != draw.pipeline)
+                    vkCmdBindPipeline(commandBuffer->get(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[static_cast<size_t>(draw.pipeline)]);
+               if (!previous || previous->clip != draw.clip)
+                    vkCmdSetScissor(commandBuffer->get(), 0, 1, &draw.scissor);
+               vkCmdDrawIndexed(commandBuffer->get(), draw.indexCount, 1, draw.firstIndex, 0, 0);
+               previous = &draw;
+          }
+     }
+
+  private:
+     Core*        core_;
+     Device*      device_;
+     CommandPool* commandPool_;
+     uint64_t     generation_ { 0 };
+
+     std::vector<DrawList::Draw> draws_;
+     std::vector<Vertex2D>       vertices_;
+     std::vector<uint32_t>       indices_;
+     std::vector<Copy>           copies_;
+};
@@ -1,76 +1,319 @@
 #pragma once
 
+#include "InlineFunction.hpp"
+#include "InputLog.hpp"
+#include "InputQueue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <concepts>
-#include <functional>
-#include <memory>
+#include <cstdint>
 #include <mutex>
-#include <unordered_map>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
-template <typename F, typename... ArgT>
-requires std::invocable<F, ArgT...>
+// Listeners live in a generational slot map: slots sit in chunks that never move, each holding its
+// listener inline, and a subscription is a handle naming a slot and its generation. Freed slots are
+// reused, so once the dispatcher has held as many listeners at once, subscribing and unsubscribing
+// allocate nothing. signal() walks the slots without taking a lock or allocating, calling the live
+// ones in slot order. A listener may subscribe or unsubscribe anything, itself included, while it
+// is called; one unsubscribed is not called again by a running signal, though a signal already
+// inside it on another thread finishes the call. An unsubscribed slot is only cleared and reused
+// once every signal that was running when it was unsubscribed has returned, so nothing is destroyed
+// while it may be called, and slots still come back while other threads signal without pause.
+template <typename... ArgT>
 class EventDispatcher {
+     struct Slot;
+
   public:
+     // bytes a listener may capture
+     static constexpr size_t CAPACITY = 48;
+
+     // Move-only; unsubscribes when reset or destroyed. Becomes invalid if the dispatcher goes first.
      class Subscription {
        public:
-          Subscription(EventDispatcher* source, const F& listener)
-             : source_(source) { source_->add_listener(this, listener); }
-          ~Subscription() {
-               if (source_ != nullptr)
-                    source_->remove_listener(this);
+          Subscription() = default;
+          ~Subscription() { reset(); }
+          Subscription(Subscription&& other) noexcept { take(other); }
+          Subscription& operator=(Subscription&& other) noexcept {
+               if (this != &other) {
+                    reset();
+                    take(other);
+               }
+               return *this;
           }
           Subscription(const Subscription&)            = delete;
-          Subscription(Subscription&&)                 = delete;
           Subscription& operator=(const Subscription&) = delete;
-          Subscription& operator=(Subscription&&)      = delete;
 
-          bool is_valid() { return source_ != nullptr; }
+          bool is_valid() const { return source_ != nullptr; }
+
+          void reset() {
+               if (source_ != nullptr)
+                    source_->remove(index_, generation_);
+               source_ = nullptr;
+          }
 
        private:
-          EventDispatcher* source_;
           friend EventDispatcher;
-          void invalidate() { source_ = nullptr; }
+          Subscription(EventDispatcher* source, uint32_t index, uint32_t generation)
+             : source_(source)
+             , index_(index)
+             , generation_(generation) { source_->at(index_).owner = this; }
+
+          void take(Subscription& other) {
+               source_     = std::exchange(other.source_, nullptr);
+               index_      = other.index_;
+               generation_ = other.generation_;
+               if (source_ != nullptr)
+                    source_->at(index_).owner = this;
+          }
+
+          EventDispatcher* source_ { nullptr };
+          uint32_t         index_ { 0 };
+          uint32_t         generation_ { 0 };
      };
-     EventDispatcher()                                  = default;
+
+     EventDispatcher() = default;
      EventDispatcher(const EventDispatcher&)            = delete;
      EventDispatcher(EventDispatcher&&)                 = delete;
      EventDispatcher& operator=(const EventDispatcher&) = delete;
      EventDispatcher& operator=(EventDispatcher&&)      = delete;
      ~EventDispatcher() {
-          std::unique_lock lock(subscribers_mutex_);
-          for (const auto& [Subscription, invocable] : subscribers_)
-               Subscription->invalidate();
+          std::unique_lock lock(mutex_);
+          for (uint32_t index = 0; index != end_.load(std::memory_order_relaxed); ++index)
+               if (auto* owner = at(index).owner)
+                    owner->source_ = nullptr;
+          for (auto& chunk : chunks_)
+               delete[] chunk.load(std::memory_order_relaxed);
+     }
+
+     template <typename F>
+     requires std::invocable<std::decay_t<F>&, ArgT...>
+     [[nodiscard]] Subscription subscribe(F&& listener) {
+          std::unique_lock lock(mutex_);
+          reclaim();
+          if (free_.empty())
+               grow();
+          auto  index = free_.back();
+          auto& slot  = at(index);
+          slot.listener.emplace(std::forward<F>(listener));
+          free_.pop_back();
+          auto generation = slot.state.load(std::memory_order_relaxed) >> 1;
+          slot.state.store(generation << 1 | LIVE, std::memory_order_release);
+          return { this, index, generation };
      }
-     std::unique_ptr<Subscription> subscribe(const F& listener) { return std::make_unique<Subscription>(this, listener); }
 
      void signal(ArgT... arguments) {
-          std::unique_lock lock(subscribers_mutex_);
-          for (const auto& [Subscription, invocable] : subscribers_)
-               invocable(arguments...);
+          // keeps the slots read below from being cleared, counted in the epoch the signal starts in
+          struct Reading {
+               std::atomic<size_t>* readers;
+               Reading(EventDispatcher& dispatcher) {
+                    for (;;) {
+                         auto epoch = dispatcher.epoch_.load();
+                         readers    = &dispatcher.readers_[epoch & 1];
+                         readers->fetch_add(1);
+                         if (dispatcher.epoch_.load() == epoch)
+                              break;
+                         readers->fetch_sub(1);
+                    }
+               }
+               ~Reading() { readers->fetch_sub(1); }
+          } reading { *this };
+          auto end = end_.load(std::memory_order_acquire);
+          for (uint32_t chunk = 0, first = 0; first < end; first += CHUNK << chunk, ++chunk) {
+               auto* slots = chunks_[chunk].load(std::memory_order_acquire);
+               auto  count = std::min(CHUNK << chunk, end - first);
+               for (uint32_t i = 0; i != count; ++i)
+                    if (slots[i].state.load() & LIVE)
+                         slots[i].listener(arguments...);
+          }
      }
 
   private:
-     std::unordered_map<Subscription*, F> subscribers_ {};
-     std::mutex                           subscribers_mutex_ {};
+     static constexpr uint32_t CHUNK = 16; // slots in the first chunk, each next one doubles
+     static constexpr uint32_t LIVE  = 1;
+
+     struct Slot {
+          std::atomic<uint32_t>                   state { 0 }; // generation << 1 | LIVE
+          InlineFunction<void(ArgT...), CAPACITY> listener;
+          Subscription*                           owner { nullptr };
+     };
+
+     std::array<std::atomic<Slot*>, 27>   chunks_ {};
+     std::atomic<uint32_t>                end_ { 0 };
+     std::atomic<uint64_t>                epoch_ { 0 };
+     std::array<std::atomic<size_t>, 2>   readers_ {};
+     std::vector<uint32_t>                free_ {};
+     std::array<std::vector<uint32_t>, 3> retired_ {};
+     std::mutex                           mutex_ {};
+
+     Slot& at(uint32_t index) {
+          auto chunk = static_cast<uint32_t>(std::bit_width(index / CHUNK + 1)) - 1;
+          return chunks_[chunk].load(std::memory_order_acquire)[index - CHUNK * ((1u << chunk) - 1)];
+     }
+     void grow() {
+          auto index = end_.load(std::memory_order_relaxed);
+          auto chunk = static_cast<uint32_t>(std::bit_width(index / CHUNK + 1)) - 1;
+          if (index == CHUNK * ((1u << chunk) - 1))
+               chunks_[chunk].store(new Slot[CHUNK << chunk], std::memory_order_release);
+          free_.push_back(index);
+          end_.store(index + 1, std::memory_order_release);
+     }
+     void remove(uint32_t index, uint32_t generation) {
+          std::unique_lock lock(mutex_);
+          auto&            slot = at(index);
+          if (slot.state.load(std::memory_order_relaxed) != (generation << 1 | LIVE))
+               return;
+          slot.state.store(generation << 1);
+          slot.owner = nullptr;
+          retired_[epoch_.load(std::memory_order_relaxed) % 3].push_back(index);
+          reclaim();
+     }
+     // A signal counts itself in the epoch it starts in before it reads any slot. The epoch only
+     // advances once no signal of the epoch before is counted, so a slot marked dead in epoch E can
+     // only be called by signals of E and E - 1, and once the epoch has reached E + 2 both are gone.
+     void reclaim() {
+          for (int step = 0; step != 2; ++step) {
+               auto epoch = epoch_.load(std::memory_order_relaxed);
+               if (std::all_of(retired_.begin(), retired_.end(), [](auto& retired) { return retired.empty(); }) || readers_[(epoch + 1) & 1].load() != 0)
+                    return;
+               epoch_.store(epoch + 1);
+               // what was retired two epochs before the new one
+               auto& due = retired_[(epoch + 2) % 3];
+               for (auto index : due) {
+                    auto& slot = at(index);
+                    slot.listener.reset();
+                    slot.state.store(((slot.state.load(std::memory_order_relaxed) >> 1) + 1) << 1, std::memory_order_relaxed);
+                    free_.push_back(index);
+               }
+               due.clear();
+          }
+     }
+};
+
+// Events of each registered type are collected over a frame in an array of their own and handed
+// to that type's listeners in one call, as a span, so a listener sees all of a frame's moves at
+// once instead of being called for each. Order is kept within a type, not across types: types are
+// delivered in the order they are registered. post() and deliver() belong to one thread; what a
+// listener posts is delivered on the next deliver().
+template <typename... Events>
+class EventBus {
+     template <typename Event>
+     struct Channel {
+          std::vector<Event>                      pending;
+          std::vector<Event>                      delivering;
+          EventDispatcher<std::span<const Event>> dispatcher;
+     };
+
+  public:
+     template <typename Event>
+     static constexpr bool registered = (std::is_same_v<Event, Events> || ...);
 
-     void add_listener(Subscription* subscriber, const F& listener) {
-          std::unique_lock lock(subscribers_mutex_);
-          subscribers_[subscriber] = listener;
+     template <typename Event>
+     using Subscription = typename EventDispatcher<std::span<const Event>>::Subscription;
+
+     template <typename Event, typename F>
+     requires registered<Event> && std::invocable<std::decay_t<F>&, std::span<const Event>>
+     [[nodiscard]] Subscription<Event> subscribe(F&& listener) {
+          return channel<Event>().dispatcher.subscribe(std::forward<F>(listener));
      }
-     void remove_listener(Subscription* subscriber) {
-          std::unique_lock lock(subscribers_mutex_);
-          subscribers_.erase(subscriber);
+
+     template <typename Event>
+     requires registered<Event>
+     void post(const Event& event) { channel<Event>().pending.push_back(event); }
+
+     // Returns how many events were delivered.
+     size_t deliver() {
+          size_t delivered { 0 };
+          (deliver(channel<Events>(), delivered), ...);
+          return delivered;
+     }
+
+  private:
+     std::tuple<Channel<Events>...> channels_;
+
+     template <typename Event>
+     Channel<Event>& channel() { return std::get<Channel<Event>>(channels_); }
+
+     template <typename Event>
+     static void deliver(Channel<Event>& channel, size_t& delivered) {
+          if (channel.pending.empty())
+               return;
+          // both arrays keep their capacity, so a steady stream of input allocates nothing
+          std::swap(channel.pending, channel.delivering);
+          channel.dispatcher.signal(std::span<const Event>(channel.delivering));
+          delivered += channel.delivering.size();
+          channel.delivering.clear();
      }
 };
 
+// The platform layer pushes input into `queue` as it arrives; dispatch() drains it on the thread
+// that owns the UI and delivers it through `bus`, a batch per event type. Events are also written to
+// `recorder` while one is set, as they are delivered.
 class EventSystem {
   public:
-     EventDispatcher<std::function<void(void)>> closeDispatcher;
-     EventDispatcher<std::function<void(int, int)>, int, int> mouseMoveDispatcher;
      enum MouseButton {
           LEFT,
           MIDDLE,
           RIGHT
      };
-     EventDispatcher<std::function<void(MouseButton, int, int)>, MouseButton, int, int> mouseButtonDispatcher;
-     EventDispatcher<std::function<void(int, int)>, int, int> resizeDispatcher;
+
+     struct Close {};
+     struct Resize {
+          int width;
+          int height;
+     };
+     struct MouseMove {
+          int      x;
+          int      y;
+          uint32_t time;
+     };
+     // a button went down or up
+     struct Click {
+          MouseButton button;
+          int         x;
+          int         y;
+          bool        down;
+     };
+     struct Wheel {
+          int delta; // WHEEL_DELTA per notch
+     };
+
+     using Bus = EventBus<Close, Resize, MouseMove, Click, Wheel>;
+     template <typename Event>
+     using Subscription = Bus::Subscription<Event>;
+
+     Bus               bus;
+     InputQueue        queue;
+     InputLog::Writer* recorder { nullptr };
+
+     size_t dispatch() {
+          queue.drain([this](const InputEvent& event) {
+               if (recorder != nullptr)
+                    recorder->write(event);
+               switch (event.kind) {
+                    case InputEvent::Kind::CLOSE:
+                         bus.post(Close {});
+                         break;
+                    case InputEvent::Kind::RESIZE:
+                         bus.post(Resize { event.x, event.y });
+                         break;
+                    case InputEvent::Kind::MOUSE_MOVE:
+                         bus.post(MouseMove { event.x, event.y, event.time });
+                         break;
+                    case InputEvent::Kind::MOUSE_BUTTON:
+                         bus.post(Click { static_cast<MouseButton>(event.value), event.x, event.y, event.down });
+                         break;
+                    case InputEvent::Kind::MOUSE_WHEEL:
+                         bus.post(Wheel { event.value });
+                         break;
+               }
+          });
+          return bus.deliver();
+     }
 };
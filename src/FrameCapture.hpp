@@ -0,0 +1,230 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "CommandPool.hpp"
+#include "Core.hpp"
+#include "Device.hpp"
+#include "PixelConvert.hpp"
+#include "JobSystem.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// Reads rendered images back without stalling the frame loop. A copy is recorded into the frame's
+// command buffer, targeting one of a small ring of host visible buffers; once that frame's fence has
+// been waited on the buffer is handed to its callback on the job system. When every buffer is still
+// in flight or being consumed the capture is dropped, so a slow consumer costs frames, not frame time.
+// Only 8 bit four channel images (the swapchain and layer formats) are supported.
+class FrameCapture {
+  public:
+     struct Frame {
+          VkExtent2D     extent;
+          VkFormat       format;
+          size_t         rowPitch;
+          const uint8_t* data;
+          uint64_t       number;
+
+          const uint8_t* row(uint32_t y) const { return data + y * rowPitch; }
+
+          // Tightly packed RGBA, swizzled from BGRA images.
+          void toRGBA(uint8_t* dst) const {
+               bool bgra = format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_B8G8R8A8_UNORM;
+               for (uint32_t y = 0; y != extent.height; ++y) {
+                    auto* out = dst + static_cast<size_t>(y) * extent.width * 4;
+                    if (bgra)
+                         PixelConvert::swizzleRB(row(y), out, extent.width);
+                    else
+                         std::memcpy(out, row(y), static_cast<size_t>(extent.width) * 4);
+               }
+          }
+     };
+     using Callback = std::function<void(const Frame&)>;
+
+     // `layout` is kept around the copy; `stage` and `access` describe how the image is written
+     // before it and used after it.
+     struct Source {
+          VkImage              image;
+          VkExtent2D           extent;
+          VkFormat             format;
+          VkImageLayout        layout;
+          VkPipelineStageFlags stage;
+          VkAccessFlags        access;
+     };
+
+     FrameCapture(Core* core, Device* device, CommandPool* commandPool, JobSystem* jobs, size_t ringSize = 3)
+        : core_(core)
+        , device_(device)
+        , commandPool_(commandPool)
+        , jobs_(jobs)
+        , slots_(ringSize) {}
+     ~FrameCapture() {
+          std::unique_lock lock(inbox_->mutex);
+          inbox_->closed = true;
+          inbox_->idle.wait(lock, [this] { return inbox_->running == 0; });
+     }
+     FrameCapture(const FrameCapture&)            = delete;
+     FrameCapture(FrameCapture&&)                 = delete;
+     FrameCapture& operator=(const FrameCapture&) = delete;
+     FrameCapture& operator=(FrameCapture&&)      = delete;
+
+     // Whether record() would find a free buffer, for captures that rather wait than be dropped.
+     bool ready() {
+          return std::any_of(slots_.begin(), slots_.end(), [](const Slot& slot) { return !slot.busy; });
+     }
+
+     // Records the copy into `commandBuffer`, submitted as frame `frame`. Returns false when no buffer
+     // is free, nothing is recorded then.
+     bool record(CommandBuffer* commandBuffer, size_t frame, const Source& source, Callback callback) {
+          auto it = std::find_if(slots_.begin(), slots_.end(), [](const Slot& slot) { return !slot.busy; });
+          if (it == slots_.end()) {
+               ++dropped_;
+               return false;
+          }
+          auto&        slot = *it;
+          VkDeviceSize size = static_cast<VkDeviceSize>(source.extent.width) * source.extent.height * 4;
+          if (slot.capacity < size) {
+               if (slot.buffer)
+                    slot.buffer->unmap();
+               slot.buffer.emplace(Buffer<uint8_t>::makeReadback(core_, device_, commandPool_, size));
+               slot.mapped   = slot.buffer->map();
+               slot.capacity = size;
+          }
+
+          VkImageSubresourceRange subresource {
+               .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+               .baseMipLevel   = 0,
+               .levelCount     = 1,
+               .baseArrayLayer = 0,
+               .layerCount     = 1
+          };
+          VkImageMemoryBarrier toTransfer {
+               .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+               .pNext               = nullptr,
+               .srcAccessMask       = source.access,
+               .dstAccessMask       = VK_ACCESS_TRANSFER_READ_BIT,
+               .oldLayout           = source.layout,
+               .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+               .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+               .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+               .image               = source.image,
+               .subresourceRange    = subresource
+          };
+          vkCmdPipelineBarrier(commandBuffer->get(), source.stage, VK_PIPELINE_STAGE_TRANSFER_BIT, {}, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+          VkBufferImageCopy region {
+               .bufferOffset      = 0,
+               .bufferRowLength   = 0,
+               .bufferImageHeight = 0,
+               .imageSubresource  = {
+                    .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel       = 0,
+                    .baseArrayLayer = 0,
+                    .layerCount     = 1 },
+               .imageOffset = { 0, 0, 0 },
+               .imageExtent = { source.extent.width, source.extent.height, 1 }
+          };
+          vkCmdCopyImageToBuffer(commandBuffer->get(), source.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer->get(), 1, &region);
+
+          VkImageMemoryBarrier fromTransfer = toTransfer;
+          fromTransfer.srcAccessMask        = VK_ACCESS_TRANSFER_READ_BIT;
+          fromTransfer.dstAccessMask        = source.access;
+          fromTransfer.oldLayout            = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+          fromTransfer.newLayout            = source.layout;
+          VkBufferMemoryBarrier toHost {
+               .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+               .pNext               = nullptr,
+               .srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+               .dstAccessMask       = VK_ACCESS_HOST_READ_BIT,
+               .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+               .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+               .buffer              = slot.buffer->get(),
+               .offset              = 0,
+               .size                = size
+          };
+          vkCmdPipelineBarrier(commandBuffer->get(), VK_PIPELINE_STAGE_TRANSFER_BIT, source.stage, {}, 0, nullptr, 0, nullptr, 1, &fromTransfer);
+          vkCmdPipelineBarrier(commandBuffer->get(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, {}, 0, nullptr, 1, &toHost, 0, nullptr);
+
+          slot.busy     = true;
+          slot.pending  = true;
+          slot.frame    = frame;
+          slot.callback = std::move(callback);
+          slot.info     = Frame {
+                   .extent   = source.extent,
+                   .format   = source.format,
+                   .rowPitch = static_cast<size_t>(source.extent.width) * 4,
+                   .data     = slot.mapped,
+                   .number   = captured_++
+          };
+          return true;
+     }
+
+     // Called once the fence of frame `frame` has been waited on.
+     void complete(size_t frame) {
+          for (auto& slot : slots_) {
+               if (!slot.pending || slot.frame != frame)
+                    continue;
+               slot.pending = false;
+               jobs_->submit([inbox = inbox_, slot = &slot] {
+                    {
+                         std::unique_lock lock(inbox->mutex);
+                         if (inbox->closed)
+                              return;
+                         ++inbox->running;
+                    }
+                    try {
+                         slot->callback(slot->info);
+                    }
+                    catch (const std::exception& e) {
+                         fmt::print("frame capture callback failed: {}\n", e.what());
+                    }
+                    slot->callback = nullptr;
+                    slot->busy     = false;
+                    std::unique_lock lock(inbox->mutex);
+                    --inbox->running;
+                    inbox->idle.notify_all();
+               });
+          }
+     }
+
+     uint64_t captured() { return captured_; }
+     uint64_t dropped() { return dropped_; }
+
+  private:
+     struct Slot {
+          std::optional<Buffer<uint8_t>> buffer;
+          uint8_t*                       mapped { nullptr };
+          VkDeviceSize                   capacity { 0 };
+          // set from recording until the callback returns, which may be on a worker
+          std::atomic<bool>              busy { false };
+          bool                           pending { false };
+          size_t                         frame { 0 };
+          Frame                          info {};
+          Callback                       callback;
+     };
+     // Callbacks that start after closing return without touching a slot, running ones are waited for.
+     struct Inbox {
+          std::mutex              mutex;
+          std::condition_variable idle;
+          size_t                  running { 0 };
+          bool                    closed { false };
+     };
+
+     Core*        core_;
+     Device*      device_;
+     CommandPool* commandPool_;
+     JobSystem*   jobs_;
+     uint64_t     captured_ { 0 };
+     uint64_t     dropped_ { 0 };
+
+     std::vector<Slot>      slots_;
+     std::shared_ptr<Inbox> inbox_ { std::make_shared<Inbox>() };
+};
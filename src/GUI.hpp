@@ -1,25 +1,37 @@
 #pragma once
 
 #include "DebugMessenger.hpp"
+#include "InputLog.hpp"
 #include "Renderer.hpp"
+#include "Scene.hpp"
+#include "Surface.hpp"
 #include "Win32.hpp"
 
-#include <fmt/xchar.h>
+#include <fmt/core.h>
 
+#include <atomic>
 #include <chrono>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <string>
 #include <thread>
 #include <vector>
 
+// Three threads per window: the one that created it pumps its messages, which only queue input; the
+// interaction thread handles that input, changes the scene with it and publishes a packet of what
+// changed; the render thread draws the latest packet, so dragging the window or any other modal loop
+// of the pump does not stop frames. They share the scene only through the packet handed over, so a
+// slow listener delays what is drawn, not the present: frames go on with the last packet meanwhile.
 class Window {
   public:
-     Window(const wchar_t* name, Win32* win32, Core* core)
-        : windowName_(name)
+     Window(const wchar_t* name, Win32* win32, Core* core, JobSystem* jobs)
+        : win32_(win32)
         , eventSystem_()
-        , frame_(win32->createFrame(name, &eventSystem_))
-        , surface_(core, win32, &frame_)
-        , renderer_(core, &surface_) {
+        , frame_(std::make_unique<Frame<Win32>>(win32->createFrame(name, &eventSystem_)))
+        , surface_(std::make_unique<Surface>(core, win32, frame_.get()))
+        , renderer_(core, surface_->surfaceKHR(), jobs)
+        , scene_(name, &eventSystem_, &renderer_) {
           // std::vector<Vertex> vertecies {
           //      { .position           = { -.5f, -.5f, 0.1f },
           //         .color             = { 1.f, 1.f, 1.f },
@@ -35,59 +47,88 @@ class Window {
           //         .textureCoordinate = { 1.f, 1.f } }
           // };
           // renderer_.load(vertecies);
-          onClose_  = subscribeOnClose([this] { shouldClose_ = true; });
-          onResize_ = eventSystem_.resizeDispatcher.subscribe([this](int x, int y) {
-               renderer_.resize(x, y);
-               renderer_.tryDrawFrame();
+          onClose_     = subscribeOnClose([this] {
+               shouldClose_ = true;
+               win32_->wake();
           });
-          onClick_  = eventSystem_.mouseButtonDispatcher.subscribe([this](EventSystem::MouseButton button, int x, int y) {
-               auto w = (2.f * static_cast<float>(x) / static_cast<float>(renderer_.width())) - 1.f;
-               auto h = (2.f * static_cast<float>(y) / static_cast<float>(renderer_.height())) - 1.f;
-               if (button == EventSystem::MouseButton::LEFT) {
-                    std::vector<Vertex> verts {
-                         { .position           = { w - .1f, h - .1f, 0.f },
-                             .color             = { 1.f, 1.f, 1.f },
-                             .textureCoordinate = { 0.f, 0.f } },
-                         { .position           = { w - .1f, h + .1f, 0.f },
-                             .color             = { .9f, .9f, .9f },
-                             .textureCoordinate = { 0.f, 1.f } },
-                         { .position           = { w + .1f, h - .1f, 0.f },
-                             .color             = { .8f, .8f, .8f },
-                             .textureCoordinate = { 1.f, 0.f } },
-                         { .position           = { w + .1f, h + .1f, 0.f },
-                             .color             = { .5f, .5f, .5f },
-                             .textureCoordinate = { 1.f, 1.f } }
-                    };
-                    renderer_.load(verts);
-               }
-          });
-          // onMouseMove_ = eventSystem_.mouseMoveDispatcher.subscribe([this](int x, int y) { fmt::print(L"Mouse moved to: {}, {} in window {}\n", x, y, windowName_); });
+          renderer_.publish();
+          interaction_ = std::thread([this] { interact(); });
+          rendering_   = std::thread([this] { render(); });
+     }
+     ~Window() {
+          running_ = false;
+          eventSystem_.queue.wake();
+          if (interaction_.joinable())
+               interaction_.join();
+          if (rendering_.joinable())
+               rendering_.join();
      }
      Window(const Window&)            = delete;
      Window(Window&&)                 = delete;
      Window& operator=(const Window&) = delete;
      Window& operator=(Window&&)      = delete;
 
-     std::unique_ptr<EventDispatcher<std::function<void()>>::Subscription> subscribeOnClose(std::function<void()> callback) {
-          return eventSystem_.closeDispatcher.subscribe(callback);
+     template <typename F>
+     EventSystem::Subscription<EventSystem::Close> subscribeOnClose(F&& callback) {
+          return eventSystem_.bus.subscribe<EventSystem::Close>([callback = std::forward<F>(callback)](std::span<const EventSystem::Close>) mutable { callback(); });
      }
 
      bool shouldClose() const { return shouldClose_; }
 
-     std::wstring windowName_;
-     EventSystem  eventSystem_;
-     bool         shouldClose_ { false };
+     // Writes the input handled from now on to `log`, null to stop.
+     void record(InputLog::Writer* log) {
+          std::lock_guard dispatching(dispatchMutex_);
+          eventSystem_.recorder = log;
+     }
+     int width() { return renderer_.width(); }
+     int height() { return renderer_.height(); }
+
+  private:
+     // Listeners run here, and a packet is published after each batch of input and after each frame
+     // that took one, which keeps animations moving at the frame rate.
+     void interact() {
+          while (running_) {
+               eventSystem_.queue.wait();
+               {
+                    std::lock_guard dispatching(dispatchMutex_);
+                    eventSystem_.dispatch();
+               }
+               renderer_.publish();
+          }
+     }
+
+     // Paced by the present queue; an exception closes the window.
+     void render() {
+          try {
+               while (running_) {
+                    if (!renderer_.tryDrawFrame())
+                         std::this_thread::sleep_for(std::chrono::milliseconds(16));
+                    if (renderer_.tookPacket())
+                         eventSystem_.queue.wake();
+               }
+          }
+          catch (const std::exception& e) {
+               fmt::print("exception: {}\n", e.what());
+               shouldClose_ = true;
+               win32_->wake();
+          }
+     }
 
-     std::unique_ptr<EventDispatcher<std::function<void()>>::Subscription>                                                                       onClose_;
-     std::unique_ptr<EventDispatcher<std::function<void(EventSystem::MouseButton, int, int)>, EventSystem::MouseButton, int, int>::Subscription> onClick_;
-     std::unique_ptr<EventDispatcher<std::function<void(int, int)>, int, int>::Subscription>                                                     onResize_;
-     // std::unique_ptr<EventDispatcher<std::function<void(int, int)>, int, int>::Subscription> onMouseMove_;
+     Win32*            win32_;
+     EventSystem       eventSystem_;
+     std::atomic<bool> shouldClose_ { false };
+     std::atomic<bool> running_ { true };
+     std::mutex        dispatchMutex_; // the recorder changes between batches
 
-     Frame<Win32> frame_;
-     Surface surface_;
-     Renderer     renderer_;
+     EventSystem::Subscription<EventSystem::Close> onClose_;
 
-  private:
+     std::unique_ptr<Frame<Win32>> frame_;
+     std::unique_ptr<Surface>      surface_;
+     Renderer                      renderer_;
+     Scene                         scene_;
+
+     std::thread interaction_;
+     std::thread rendering_;
 };
 
 class GUI {
@@ -104,18 +145,23 @@ class GUI {
      void initialize() {
           // loadModel();
           auto name = L"Vulkan and win32";
-          windows_.emplace_back(std::make_unique<Window>(name, &win32_, &core_));
+          windows_.emplace_back(std::make_unique<Window>(name, &win32_, &core_, &jobs_));
+          if (!recordPath_.empty()) {
+               auto& window = windows_.front();
+               recording_   = std::make_unique<InputLog::Writer>(recordPath_, window->width(), window->height());
+               window->record(recording_.get());
+          }
           // name = L"Second window";
-          // windows_.emplace_back(std::make_unique<Window>(name, &win32_, &core_));
+          // windows_.emplace_back(std::make_unique<Window>(name, &win32_, &core_, &jobs_));
      }
+     // Records the first window's input into `path`, once run.
+     void record(const std::string& path) { recordPath_ = path; }
+
      void run() {
           initialize();
           while (!windows_.empty()) {
-               win32_.processMessages();
-               for (auto& window : windows_)
-                    window->renderer_.tryDrawFrame();
+               win32_.waitMessages();
                std::erase_if(windows_, [](const auto& w) { return w->shouldClose(); });
-               std::this_thread::sleep_for(std::chrono::milliseconds(16));
           }
      }
 
@@ -123,6 +169,9 @@ class GUI {
      Win32          win32_;
      Core           core_;
      DebugMessenger debug_;
+     JobSystem      jobs_;
 
+     std::string                          recordPath_;
+     std::unique_ptr<InputLog::Writer>    recording_;
      std::vector<std::unique_ptr<Window>> windows_ {};
 };
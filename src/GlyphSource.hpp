@@ -0,0 +1,159 @@
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+// Glyph metrics and coverage for Text, from the platform's font rasterizer, all at one em height.
+// On Windows that is GDI. Elsewhere there is no rasterizer yet: every printable character is the
+// same outlined box at fixed metrics, so text lays out and costs what it would, only unreadable, as
+// offscreen replays need.
+class GlyphSource {
+  public:
+     using Font = uint32_t;
+
+     static constexpr int NORMAL = 400;
+
+     struct Metrics {
+          float                               ascent;
+          float                               descent;
+          float                               lineHeight;
+          std::unordered_map<uint32_t, float> kerning; // first << 16 | second
+     };
+
+     // Coverage levels 0 to 64, rows `pitch` apart; the origin is the pen's offset from the top left.
+     struct Bitmap {
+          uint32_t             width;
+          uint32_t             height;
+          uint32_t             pitch;
+          int                  originX;
+          int                  originY;
+          std::vector<uint8_t> coverage;
+     };
+
+     explicit GlyphSource(int size)
+        : size_(size) {
+#ifdef _WIN32
+          dc_ = CreateCompatibleDC(nullptr);
+          if (!dc_)
+               throw std::runtime_error("call to CreateCompatibleDC failed");
+#endif
+     }
+     ~GlyphSource() {
+#ifdef _WIN32
+          for (auto font : fonts_)
+               DeleteObject(font);
+          DeleteDC(dc_);
+#endif
+     }
+     GlyphSource(const GlyphSource&)            = delete;
+     GlyphSource(GlyphSource&&)                 = delete;
+     GlyphSource& operator=(const GlyphSource&) = delete;
+     GlyphSource& operator=(GlyphSource&&)      = delete;
+
+#ifdef _WIN32
+     Font add(const wchar_t* family, int weight, bool italic, Metrics& metrics) {
+          auto font = CreateFontW(-size_, 0, 0, 0, weight, italic, FALSE, FALSE, DEFAULT_CHARSET, OUT_TT_ONLY_PRECIS, CLIP_DEFAULT_PRECIS, ANTIALIASED_QUALITY, DEFAULT_PITCH, family);
+          if (!font)
+               throw std::runtime_error("call to CreateFontW failed");
+          SelectObject(dc_, font);
+          selected_ = static_cast<Font>(fonts_.size());
+          fonts_.push_back(font);
+          TEXTMETRICW text;
+          GetTextMetricsW(dc_, &text);
+          metrics.ascent     = static_cast<float>(text.tmAscent);
+          metrics.descent    = static_cast<float>(text.tmDescent);
+          metrics.lineHeight = static_cast<float>(text.tmHeight + text.tmExternalLeading);
+          std::vector<KERNINGPAIR> pairs(GetKerningPairsW(dc_, 0, nullptr));
+          if (!pairs.empty())
+               GetKerningPairsW(dc_, static_cast<DWORD>(pairs.size()), pairs.data());
+          for (auto& pair : pairs)
+               metrics.kerning[static_cast<uint32_t>(pair.wFirst) << 16 | pair.wSecond] = static_cast<float>(pair.iKernAmount);
+          return selected_;
+     }
+
+     // False when the font has no such glyph.
+     bool advance(Font font, wchar_t codepoint, float& advance) {
+          select(font);
+          GLYPHMETRICS metrics {};
+          if (GetGlyphOutlineW(dc_, codepoint, GGO_METRICS, &metrics, 0, nullptr, &IDENTITY) == GDI_ERROR)
+               return false;
+          advance = static_cast<float>(metrics.gmCellIncX);
+          return true;
+     }
+
+     // False when the glyph covers nothing.
+     bool rasterize(Font font, wchar_t codepoint, Bitmap& bitmap) {
+          select(font);
+          GLYPHMETRICS metrics {};
+          auto         size = GetGlyphOutlineW(dc_, codepoint, GGO_GRAY8_BITMAP, &metrics, 0, nullptr, &IDENTITY);
+          if (size == GDI_ERROR || size == 0)
+               return false;
+          bitmap.coverage.resize(size);
+          GetGlyphOutlineW(dc_, codepoint, GGO_GRAY8_BITMAP, &metrics, size, bitmap.coverage.data(), &IDENTITY);
+          // rows are DWORD aligned
+          bitmap.width   = metrics.gmBlackBoxX;
+          bitmap.height  = metrics.gmBlackBoxY;
+          bitmap.pitch   = (metrics.gmBlackBoxX + 3) & ~3u;
+          bitmap.originX = metrics.gmptGlyphOrigin.x;
+          bitmap.originY = -metrics.gmptGlyphOrigin.y;
+          return true;
+     }
+
+  private:
+     void select(Font font) {
+          if (font != selected_) {
+               SelectObject(dc_, fonts_[font]);
+               selected_ = font;
+          }
+     }
+
+     static constexpr MAT2 IDENTITY { { 0, 1 }, { 0, 0 }, { 0, 0 }, { 0, 1 } };
+
+     int                size_;
+     HDC                dc_;
+     std::vector<HFONT> fonts_;
+     Font               selected_ { ~0u };
+#else
+     Font add(const wchar_t*, int, bool, Metrics& metrics) {
+          metrics.ascent     = static_cast<float>(size_) * .8f;
+          metrics.descent    = static_cast<float>(size_) * .2f;
+          metrics.lineHeight = static_cast<float>(size_) * 1.2f;
+          return fonts_++;
+     }
+
+     bool advance(Font, wchar_t codepoint, float& advance) {
+          if (codepoint < L' ')
+               return false;
+          advance = static_cast<float>(size_) * .55f;
+          return true;
+     }
+
+     bool rasterize(Font, wchar_t codepoint, Bitmap& bitmap) {
+          if (codepoint <= L' ')
+               return false;
+          auto stroke    = std::max(1, size_ / 16);
+          bitmap.width   = static_cast<uint32_t>(size_ / 2 - 2);
+          bitmap.height  = static_cast<uint32_t>(size_ * 7 / 10);
+          bitmap.pitch   = bitmap.width;
+          bitmap.originX = 1;
+          bitmap.originY = -static_cast<int>(bitmap.height);
+          bitmap.coverage.assign(bitmap.pitch * bitmap.height, 0);
+          for (uint32_t y = 0; y != bitmap.height; ++y)
+               for (uint32_t x = 0; x != bitmap.width; ++x)
+                    if (std::min({ x, y, bitmap.width - 1 - x, bitmap.height - 1 - y }) < static_cast<uint32_t>(stroke))
+                         bitmap.coverage[y * bitmap.pitch + x] = 64;
+          return true;
+     }
+
+  private:
+     int  size_;
+     Font fonts_ { 0 };
+#endif
+};
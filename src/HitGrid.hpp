@@ -0,0 +1,178 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over axis aligned rectangles, answering which of them lie under a point or overlap a
+// rectangle. Every rectangle is listed in the cells it covers, so a point query only tests the few
+// rectangles of one cell; rectangles covering more than LARGE cells are kept apart and always tested.
+// Moving a rectangle within the same cells touches nothing but its entry. Ids are dense indices the
+// caller owns; of several hits the one with the highest z is on top.
+class HitGrid {
+     static constexpr int LARGE = 64;
+
+     struct Item {
+          glm::vec2 low;
+          glm::vec2 high;
+          uint64_t  z;
+          int       x0, y0, x1, y1; // covered cells, inclusive
+          bool      active { false };
+          bool      large { false };
+     };
+
+  public:
+     using Id                  = uint32_t;
+     static constexpr Id NONE = ~0u;
+
+     explicit HitGrid(float cellSize = 64.f)
+        : cellSize_(cellSize) {}
+
+     void set(Id id, glm::vec2 low, glm::vec2 high, uint64_t z) {
+          if (id >= items_.size()) {
+               items_.resize(id + 1);
+               stamps_.resize(id + 1, 0);
+          }
+          auto& item = items_[id];
+          int   x0 = cell(low.x), y0 = cell(low.y), x1 = cell(high.x), y1 = cell(high.y);
+          if (!item.active || x0 != item.x0 || y0 != item.y0 || x1 != item.x1 || y1 != item.y1) {
+               if (item.active)
+                    unlink(id);
+               item.x0    = x0;
+               item.y0    = y0;
+               item.x1    = x1;
+               item.y1    = y1;
+               item.large = static_cast<int64_t>(x1 - x0 + 1) * (y1 - y0 + 1) > LARGE;
+               link(id);
+               if (!item.active)
+                    ++size_;
+          }
+          item.low    = low;
+          item.high   = high;
+          item.z      = z;
+          item.active = true;
+     }
+
+     void remove(Id id) {
+          if (id >= items_.size() || !items_[id].active)
+               return;
+          unlink(id);
+          items_[id].active = false;
+          --size_;
+     }
+
+     // Topmost rectangle containing `point`, or NONE.
+     Id at(glm::vec2 point) const {
+          Id   best = NONE;
+          auto test = [&](Id id) {
+               auto& item = items_[id];
+               if (contains(item, point) && (best == NONE || item.z > items_[best].z))
+                    best = id;
+          };
+          if (auto it = cells_.find(key(cell(point.x), cell(point.y))); it != cells_.end())
+               for (auto id : it->second)
+                    test(id);
+          for (auto id : large_)
+               test(id);
+          return best;
+     }
+
+     // Every rectangle containing `point`, topmost first.
+     void stack(glm::vec2 point, std::vector<Id>& out) const {
+          out.clear();
+          if (auto it = cells_.find(key(cell(point.x), cell(point.y))); it != cells_.end())
+               for (auto id : it->second)
+                    if (contains(items_[id], point))
+                         out.push_back(id);
+          for (auto id : large_)
+               if (contains(items_[id], point))
+                    out.push_back(id);
+          sortByZ(out);
+     }
+
+     // Every rectangle overlapping [low, high], topmost first.
+     void overlapping(glm::vec2 low, glm::vec2 high, std::vector<Id>& out) {
+          out.clear();
+          ++stamp_;
+          auto test = [&](Id id) {
+               auto& item = items_[id];
+               if (stamps_[id] != stamp_ && item.low.x < high.x && low.x < item.high.x && item.low.y < high.y && low.y < item.high.y) {
+                    stamps_[id] = stamp_;
+                    out.push_back(id);
+               }
+          };
+          int x0 = cell(low.x), y0 = cell(low.y), x1 = cell(high.x), y1 = cell(high.y);
+          // a query wider than the populated cells walks the cells instead of the area
+          if (static_cast<int64_t>(x1 - x0 + 1) * (y1 - y0 + 1) > static_cast<int64_t>(cells_.size())) {
+               for (auto& [k, ids] : cells_)
+                    for (auto id : ids)
+                         test(id);
+          }
+          else
+               for (int y = y0; y <= y1; ++y)
+                    for (int x = x0; x <= x1; ++x)
+                         if (auto it = cells_.find(key(x, y)); it != cells_.end())
+                              for (auto id : it->second)
+                                   test(id);
+          for (auto id : large_)
+               test(id);
+          sortByZ(out);
+     }
+
+     size_t size() const { return size_; }
+
+  private:
+     int cell(float coordinate) const { return static_cast<int>(std::clamp(std::floor(coordinate / cellSize_), -1e9f, 1e9f)); }
+
+     static uint64_t key(int x, int y) { return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 | static_cast<uint32_t>(y); }
+
+     static bool contains(const Item& item, glm::vec2 point) { return point.x >= item.low.x && point.x < item.high.x && point.y >= item.low.y && point.y < item.high.y; }
+
+     void sortByZ(std::vector<Id>& ids) const {
+          std::sort(ids.begin(), ids.end(), [this](Id a, Id b) { return items_[a].z > items_[b].z; });
+     }
+
+     void link(Id id) {
+          auto& item = items_[id];
+          if (item.large) {
+               large_.push_back(id);
+               return;
+          }
+          for (int y = item.y0; y <= item.y1; ++y)
+               for (int x = item.x0; x <= item.x1; ++x)
+                    cells_[key(x, y)].push_back(id);
+     }
+
+     void unlink(Id id) {
+          auto& item  = items_[id];
+          auto  erase = [id](std::vector<Id>& ids) {
+               auto it = std::find(ids.begin(), ids.end(), id);
+               *it     = ids.back();
+               ids.pop_back();
+          };
+          if (item.large) {
+               erase(large_);
+               return;
+          }
+          for (int y = item.y0; y <= item.y1; ++y)
+               for (int x = item.x0; x <= item.x1; ++x) {
+                    auto it = cells_.find(key(x, y));
+                    erase(it->second);
+                    if (it->second.empty())
+                         cells_.erase(it);
+               }
+     }
+
+     float  cellSize_;
+     size_t size_ { 0 };
+     size_t stamp_ { 0 };
+
+     std::vector<Item>                              items_;
+     std::vector<size_t>                            stamps_;
+     std::unordered_map<uint64_t, std::vector<Id>> cells_;
+     std::vector<Id>                                large_;
+};
@@ -48,7 +48,9 @@ class ImageResource2D {
           }
      }
 
+     auto image() { return image_; }
      auto view() { return imageView_; }
+     auto extent() { return iConf_.extent; }
      auto format() { return iConf_.format; }
      auto msaa() { return iConf_.msaa; }
 
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// A callable held in place, for listeners made and dropped by the thousand. Anything invocable that
+// fits in `Capacity` bytes is stored without allocating; a bigger one does not compile, so capture a
+// pointer to larger state instead. It stays where it was made: it is neither copied nor moved.
+template <typename Signature, size_t Capacity = 48>
+class InlineFunction;
+
+template <typename R, typename... Args, size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+  public:
+     InlineFunction() = default;
+     ~InlineFunction() { reset(); }
+     InlineFunction(const InlineFunction&)            = delete;
+     InlineFunction(InlineFunction&&)                 = delete;
+     InlineFunction& operator=(const InlineFunction&) = delete;
+     InlineFunction& operator=(InlineFunction&&)      = delete;
+
+     template <typename F>
+     requires std::is_invocable_r_v<R, std::decay_t<F>&, Args...>
+     void emplace(F&& f) {
+          using T = std::decay_t<F>;
+          static_assert(sizeof(T) <= Capacity, "callable too large to store inline, capture a pointer to its state");
+          static_assert(alignof(T) <= alignof(std::max_align_t), "callable over-aligned");
+          reset();
+          ::new (static_cast<void*>(storage_)) T(std::forward<F>(f));
+          invoke_  = [](void* storage, Args&&... args) -> R {
+               // a void signature discards whatever the callable returns
+               if constexpr (std::is_void_v<R>)
+                    std::invoke(*static_cast<T*>(storage), std::forward<Args>(args)...);
+               else
+                    return std::invoke(*static_cast<T*>(storage), std::forward<Args>(args)...);
+          };
+          destroy_ = [](void* storage) { static_cast<T*>(storage)->~T(); };
+     }
+     void reset() {
+          if (destroy_ == nullptr)
+               return;
+          destroy_(storage_);
+          invoke_  = nullptr;
+          destroy_ = nullptr;
+     }
+
+     R operator()(Args... args) { return invoke_(storage_, std::forward<Args>(args)...); }
+     explicit operator bool() const { return invoke_ != nullptr; }
+
+  private:
+     R (*invoke_)(void*, Args&&...) { nullptr };
+     void (*destroy_)(void*) { nullptr };
+     alignas(std::max_align_t) std::byte storage_[Capacity];
+};
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "InputQueue.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Recorded input (.cinp), replayed to reproduce a session.
+//
+//   Header | record...
+//
+// A record is the event kind in a byte and the milliseconds since the previous record as a varint,
+// then: nothing for a close; the new size as two varints for a resize; the pointer's move since the
+// previous pointer event as two zigzag varints for a move, after a byte for a button holding the
+// button and, in its top bit, whether it went down; the delta as a zigzag varint for the wheel. A
+// mouse move usually takes four bytes.
+class InputLog {
+     static_assert(std::endian::native == std::endian::little, "input logs are little endian");
+
+  public:
+     static constexpr uint32_t magic   = 0x504E4943; // "CINP"
+     static constexpr uint32_t version = 2;
+
+     struct Header {
+          uint32_t magic;
+          uint32_t version;
+          uint32_t width; // client size when recording started
+          uint32_t height;
+     };
+
+     // Appends events as they are delivered; the file is complete once the writer is destroyed.
+     class Writer {
+       public:
+          Writer(const std::string& path, uint32_t width, uint32_t height)
+             : file_(path, std::ios::binary | std::ios::trunc) {
+               if (!file_)
+                    throw std::runtime_error("failed to open " + path + " for writing");
+               Header header { .magic = magic, .version = version, .width = width, .height = height };
+               file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+          }
+          Writer(const Writer&)            = delete;
+          Writer(Writer&&)                 = delete;
+          Writer& operator=(const Writer&) = delete;
+          Writer& operator=(Writer&&)      = delete;
+
+          void write(const InputEvent& event) {
+               char   record[32];
+               size_t size { 0 };
+               auto   varint = [&](uint32_t value) {
+                    for (; value >= 0x80; value >>= 7)
+                         record[size++] = static_cast<char>(value | 0x80);
+                    record[size++] = static_cast<char>(value);
+               };
+               auto zigzag = [&](int32_t value) { varint((static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31)); };
+               record[size++] = static_cast<char>(event.kind);
+               varint(count_ == 0 ? 0 : event.time - time_);
+               switch (event.kind) {
+                    case InputEvent::Kind::CLOSE:
+                         break;
+                    case InputEvent::Kind::RESIZE:
+                         varint(static_cast<uint32_t>(event.x));
+                         varint(static_cast<uint32_t>(event.y));
+                         break;
+                    case InputEvent::Kind::MOUSE_BUTTON:
+                         record[size++] = static_cast<char>(event.value | (event.down ? 0x80 : 0));
+                         [[fallthrough]];
+                    case InputEvent::Kind::MOUSE_MOVE:
+                         zigzag(event.x - x_);
+                         zigzag(event.y - y_);
+                         x_ = event.x;
+                         y_ = event.y;
+                         break;
+                    case InputEvent::Kind::MOUSE_WHEEL:
+                         zigzag(event.value);
+                         break;
+               }
+               file_.write(record, static_cast<std::streamsize>(size));
+               time_ = event.time;
+               ++count_;
+          }
+          size_t count() const { return count_; }
+
+       private:
+          std::ofstream file_;
+          uint32_t      time_ { 0 };
+          int32_t       x_ { 0 };
+          int32_t       y_ { 0 };
+          size_t        count_ { 0 };
+     };
+
+     // Reads and decodes the whole log.
+     InputLog(const std::string& path) {
+          std::ifstream file(path, std::ios::binary);
+          if (!file)
+               throw std::runtime_error("failed to open " + path);
+          std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+          if (bytes.size() < sizeof(Header))
+               throw std::runtime_error(path + " is not an input log");
+          std::memcpy(&header_, bytes.data(), sizeof(Header));
+          if (header_.magic != magic || header_.version != version)
+               throw std::runtime_error(path + " is not an input log of version " + std::to_string(version));
+
+          size_t position { sizeof(Header) };
+          auto   corrupt = [&] { return std::runtime_error(path + " is truncated or corrupt"); };
+          auto   byte    = [&] {
+               if (position == bytes.size())
+                    throw corrupt();
+               return bytes[position++];
+          };
+          auto varint = [&] {
+               uint32_t value { 0 };
+               for (uint32_t shift = 0;; shift += 7) {
+                    if (shift > 28)
+                         throw corrupt();
+                    auto b = byte();
+                    value |= static_cast<uint32_t>(b & 0x7F) << shift;
+                    if (!(b & 0x80))
+                         return value;
+               }
+          };
+          auto zigzag = [&] {
+               auto value = varint();
+               return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+          };
+          uint32_t time { 0 };
+          int32_t  x { 0 }, y { 0 };
+          while (position != bytes.size()) {
+               InputEvent event {};
+               event.kind = static_cast<InputEvent::Kind>(byte());
+               time += varint();
+               event.time = time;
+               switch (event.kind) {
+                    case InputEvent::Kind::CLOSE:
+                         break;
+                    case InputEvent::Kind::RESIZE:
+                         event.x = static_cast<int32_t>(varint());
+                         event.y = static_cast<int32_t>(varint());
+                         break;
+                    case InputEvent::Kind::MOUSE_BUTTON:
+                         event.value = byte();
+                         event.down  = (event.value & 0x80) != 0;
+                         event.value &= 0x7F;
+                         [[fallthrough]];
+                    case InputEvent::Kind::MOUSE_MOVE:
+                         x += zigzag();
+                         y += zigzag();
+                         event.x = x;
+                         event.y = y;
+                         break;
+                    case InputEvent::Kind::MOUSE_WHEEL:
+                         event.value = zigzag();
+                         break;
+                    default:
+                         throw corrupt();
+               }
+               events_.push_back(event);
+          }
+     }
+
+     std::span<const InputEvent> events() const { return events_; }
+     uint32_t                    width() const { return header_.width; }
+     uint32_t                    height() const { return header_.height; }
+
+  private:
+     Header                  header_ {};
+     std::vector<InputEvent> events_;
+};
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+
+struct InputEvent {
+     enum class Kind : uint8_t {
+          CLOSE,
+          RESIZE,
+          MOUSE_MOVE,
+          MOUSE_BUTTON,
+          MOUSE_WHEEL
+     };
+
+     Kind     kind;
+     uint32_t time; // milliseconds, on the platform's message clock
+     int32_t  x;    // pointer position, or the new client size
+     int32_t  y;
+     int32_t  value; // button, or wheel delta
+     bool     down;  // the button went down rather than up
+};
+
+// Bounded ring of input events from any number of producer threads to one consumer. A producer
+// claims a cell by advancing the tail and publishes it through the cell's sequence number, so
+// pushing takes no lock and never allocates. The consumer drains once per frame, merging runs of
+// moves and of resizes into their last event unless the whole history is asked for, so the cost of
+// input is bounded by the events of a frame rather than by how fast the mouse reports.
+// Moves leave the last quarter of the ring to everything else. What does not fit is merged into one
+// overflow slot per kind, the latest move, resize and close and the summed wheel, delivered after the
+// ring at the next drain; only buttons, once even the reserve is full, are dropped and counted.
+class InputQueue {
+     struct Cell {
+          std::atomic<size_t> sequence;
+          InputEvent          event;
+     };
+     struct Overflow {
+          std::atomic<bool>     pending { false };
+          std::atomic<uint64_t> position { 0 };
+          std::atomic<uint32_t> time { 0 };
+          std::atomic<int32_t>  value { 0 };
+     };
+
+  public:
+     struct Stats {
+          size_t received;
+          size_t delivered;
+          size_t coalesced;
+          size_t dropped;
+     };
+
+     // `capacity` is rounded up to a power of two.
+     explicit InputQueue(size_t capacity = 1024)
+        : capacity_(std::bit_ceil(capacity))
+        , cells_(std::make_unique<Cell[]>(capacity_)) {
+          for (size_t i = 0; i != capacity_; ++i)
+               cells_[i].sequence.store(i, std::memory_order_relaxed);
+     }
+     InputQueue(const InputQueue&)            = delete;
+     InputQueue(InputQueue&&)                 = delete;
+     InputQueue& operator=(const InputQueue&) = delete;
+     InputQueue& operator=(InputQueue&&)      = delete;
+
+     // Any thread. False only when a button was dropped.
+     bool push(const InputEvent& event) {
+          if (tryPush(event))
+               return true;
+          if (event.kind == InputEvent::Kind::MOUSE_BUTTON) {
+               dropped_.fetch_add(1, std::memory_order_relaxed);
+               return false;
+          }
+          auto& slot = overflow_[static_cast<size_t>(event.kind)];
+          slot.position.store(static_cast<uint64_t>(static_cast<uint32_t>(event.x)) << 32 | static_cast<uint32_t>(event.y), std::memory_order_relaxed);
+          slot.time.store(event.time, std::memory_order_relaxed);
+          slot.value.fetch_add(event.value, std::memory_order_relaxed);
+          merged_.fetch_add(1, std::memory_order_relaxed);
+          slot.pending.store(true, std::memory_order_release);
+          wake();
+          return true;
+     }
+
+     // Any thread. Puts the event in the ring or returns false, never merging it, for callers that
+     // would rather wait for a drain.
+     bool tryPush(const InputEvent& event) {
+          auto reserve  = event.kind == InputEvent::Kind::MOUSE_MOVE ? capacity_ / 4 : 0;
+          auto position = tail_.load(std::memory_order_relaxed);
+          for (;;) {
+               auto& cell     = cells_[position & (capacity_ - 1)];
+               auto  sequence = cell.sequence.load(std::memory_order_acquire);
+               auto  lag      = static_cast<std::ptrdiff_t>(sequence - position);
+               // the cell `reserve` ahead is still unread from the previous lap
+               auto& ahead = cells_[(position + reserve) & (capacity_ - 1)];
+               if (lag < 0 || (reserve != 0 && static_cast<std::ptrdiff_t>(ahead.sequence.load(std::memory_order_acquire) - (position + reserve)) < 0))
+                    return false;
+               if (lag == 0) {
+                    if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                         break;
+               }
+               else
+                    position = tail_.load(std::memory_order_relaxed);
+          }
+          auto& cell = cells_[position & (capacity_ - 1)];
+          cell.event = event;
+          cell.sequence.store(position + 1, std::memory_order_release);
+          wake();
+          return true;
+     }
+
+     // Consumer thread. Blocks until an event was pushed or wake() was called since the last wait.
+     void wait() {
+          signal_.wait(seen_, std::memory_order_acquire);
+          seen_ = signal_.load(std::memory_order_acquire);
+     }
+     // Any thread. Ends the consumer's wait without an event, to stop it.
+     void wake() {
+          signal_.fetch_add(1, std::memory_order_release);
+          signal_.notify_one();
+     }
+
+     // Keeps every move, for pen and drawing tools that follow the whole path.
+     void setHistory(bool history) { history_ = history; }
+
+     // Consumer thread. Calls `f` with the events pushed so far, in order, merged unless the history
+     // is kept, then with the overflow slots; events pushed while draining may wait for the next
+     // drain. Returns how many were delivered.
+     template <typename F>
+     size_t drain(F&& f) {
+          auto       end = tail_.load(std::memory_order_acquire);
+          InputEvent pending {};
+          bool       held { false };
+          size_t     delivered { 0 };
+          while (head_ != end) {
+               auto& cell = cells_[head_ & (capacity_ - 1)];
+               // claimed but not yet written
+               if (cell.sequence.load(std::memory_order_acquire) != head_ + 1)
+                    break;
+               auto event = cell.event;
+               cell.sequence.store(head_ + capacity_, std::memory_order_release);
+               ++head_;
+               ++stats_.received;
+               if (held && pending.kind == event.kind && (event.kind == InputEvent::Kind::RESIZE || (event.kind == InputEvent::Kind::MOUSE_MOVE && !history_))) {
+                    pending = event;
+                    ++stats_.coalesced;
+                    continue;
+               }
+               if (held) {
+                    f(pending);
+                    ++delivered;
+               }
+               pending = event;
+               held    = true;
+          }
+          if (held) {
+               f(pending);
+               ++delivered;
+          }
+          // a close goes last, after whatever led up to it
+          for (auto kind : { InputEvent::Kind::MOUSE_MOVE, InputEvent::Kind::MOUSE_WHEEL, InputEvent::Kind::RESIZE, InputEvent::Kind::CLOSE }) {
+               auto& slot = overflow_[static_cast<size_t>(kind)];
+               if (!slot.pending.exchange(false, std::memory_order_acquire))
+                    continue;
+               auto position = slot.position.load(std::memory_order_relaxed);
+               f(InputEvent {
+                    .kind  = kind,
+                    .time  = slot.time.load(std::memory_order_relaxed),
+                    .x     = static_cast<int32_t>(position >> 32),
+                    .y     = static_cast<int32_t>(position),
+                    .value = slot.value.exchange(0, std::memory_order_relaxed),
+                    .down  = false });
+               ++delivered;
+               ++overflowed_;
+          }
+          stats_.delivered += delivered;
+          return delivered;
+     }
+
+     Stats stats() {
+          // every overflow delivery stands for at least one merged push
+          auto merged = merged_.load(std::memory_order_relaxed);
+          auto stats  = stats_;
+          stats.received += merged;
+          stats.coalesced += merged - std::min(merged, overflowed_);
+          stats.dropped = dropped_.load(std::memory_order_relaxed);
+          return stats;
+     }
+
+  private:
+     const size_t            capacity_;
+     std::unique_ptr<Cell[]> cells_;
+     alignas(64) std::atomic<size_t> tail_ { 0 };
+     alignas(64) std::atomic<size_t> dropped_ { 0 };
+     std::atomic<size_t> merged_ { 0 };
+     Overflow            overflow_[static_cast<size_t>(InputEvent::Kind::MOUSE_WHEEL) + 1] {};
+     alignas(64) std::atomic<uint32_t> signal_ { 0 };
+     alignas(64) size_t head_ { 0 };
+     uint32_t seen_ { 0 };
+     size_t overflowed_ { 0 };
+     bool  history_ { false };
+     Stats stats_ {};
+};
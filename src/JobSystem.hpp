@@ -0,0 +1,404 @@
+#pragma once
+
+#include "InlineFunction.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Work-stealing scheduler. Each worker owns a deque: jobs a worker submits go to its bottom and it
+// takes them back from there, newest first, while a worker with nothing to do steals the oldest from
+// the top of another's. Jobs submitted from other threads go through one shared queue. A counter
+// tracks a group of jobs; waiting on it runs other jobs meanwhile, so a job may wait on jobs it
+// submitted without holding up a worker, and a job submitted after a counter is held back until the
+// counter reaches zero, so dependencies need no thread to wait at all. Jobs must not throw. Jobs
+// still queued at destruction are dropped.
+class JobSystem {
+     struct Task;
+     struct Worker;
+
+  public:
+     // bytes a job may capture before it is wrapped in a std::function
+     static constexpr size_t CAPACITY = 64;
+
+     // Jobs submitted with a counter; it reaches zero when all of them have run. Jobs may be added by
+     // the thread that waits on it or by jobs it counts, and it may be used again once it reaches zero.
+     class Counter {
+       public:
+          Counter() = default;
+          Counter(const Counter&)            = delete;
+          Counter(Counter&&)                 = delete;
+          Counter& operator=(const Counter&) = delete;
+          Counter& operator=(Counter&&)      = delete;
+
+          bool   done() const { return pending_.load(std::memory_order_acquire) == 0; }
+          size_t pending() const { return pending_.load(std::memory_order_relaxed); }
+
+       private:
+          friend JobSystem;
+          std::atomic<size_t> pending_ { 0 };
+          std::mutex          mutex_ {};
+          std::vector<Task*>  after_ {}; // held back until zero
+          bool                closing_ { false };
+     };
+
+     struct Stats {
+          size_t workers;
+          size_t executed;
+          size_t steals;       // jobs taken from another worker's deque
+          size_t failedSteals; // searches of every deque that found nothing
+          size_t shared;       // jobs taken from the shared queue
+          size_t queued;       // waiting to run now
+          size_t deepest;      // most jobs one deque has held
+          double idle;         // seconds workers slept, summed over workers
+     };
+
+     explicit JobSystem(size_t threads = std::max(2u, std::thread::hardware_concurrency()) - 1) {
+          for (size_t i = 0; i != std::max<size_t>(threads, 1); ++i)
+               workers_.emplace_back(std::make_unique<Worker>(this, static_cast<uint32_t>(i)));
+          for (auto& worker : workers_)
+               worker->thread = std::jthread([this, worker = worker.get()](std::stop_token stop) { work(worker, stop); });
+     }
+     ~JobSystem() {
+          for (auto& worker : workers_)
+               worker->thread.request_stop();
+          epoch_.fetch_add(1);
+          epoch_.notify_all();
+          for (auto& worker : workers_)
+               worker->thread.join();
+          for (auto& worker : workers_)
+               while (auto* task = worker->deque.pop())
+                    delete task;
+          for (auto* task : shared_)
+               delete task;
+     }
+     JobSystem(const JobSystem&)            = delete;
+     JobSystem(JobSystem&&)                 = delete;
+     JobSystem& operator=(const JobSystem&) = delete;
+     JobSystem& operator=(JobSystem&&)      = delete;
+
+     template <typename F>
+     requires std::is_invocable_v<std::decay_t<F>&>
+     void submit(F&& job, Counter* counter = nullptr) { schedule(make(std::forward<F>(job), counter)); }
+
+     // Runs `job` once `dependency` reaches zero, or now if it has.
+     template <typename F>
+     requires std::is_invocable_v<std::decay_t<F>&>
+     void submitAfter(Counter& dependency, F&& job, Counter* counter = nullptr) {
+          auto* task = make(std::forward<F>(job), counter);
+          {
+               std::unique_lock lock(dependency.mutex_);
+               if (!dependency.closing_ && dependency.pending_.load(std::memory_order_acquire) != 0) {
+                    dependency.after_.push_back(task);
+                    return;
+               }
+          }
+          schedule(task);
+     }
+
+     // Runs queued jobs until `counter` reaches zero, sleeping only when there are none to run.
+     void wait(Counter& counter) {
+          auto*    self = local();
+          uint32_t idle { 0 };
+          while (true) {
+               // a counter reaching zero after `seen` was read changes it, so the wait returns at once
+               auto seen = finished_.load();
+               if (counter.pending_.load() == 0)
+                    return;
+               if (auto* task = find(self)) {
+                    run(task, self);
+                    idle = 0;
+               }
+               else if (++idle < SPINS)
+                    std::this_thread::yield();
+               else
+                    finished_.wait(seen);
+          }
+     }
+
+     // Calls f(first, last) over [begin, end) in ranges of at most `grain`, and returns when all are
+     // done. The range is halved into jobs as it goes, so idle workers steal the largest halves left.
+     template <typename F>
+     void parallelFor(size_t begin, size_t end, size_t grain, F&& f) {
+          Counter counter;
+          split(begin, end, std::max<size_t>(grain, 1), f, counter);
+          wait(counter);
+     }
+
+     size_t size() const { return workers_.size(); }
+
+     Stats stats() const {
+          Stats stats { .workers = workers_.size(), .executed = 0, .steals = 0, .failedSteals = 0, .shared = 0, .queued = sharedCount_.load(), .deepest = 0, .idle = 0. };
+          for (auto& worker : workers_) {
+               stats.executed += worker->executed.load(std::memory_order_relaxed);
+               stats.steals += worker->steals.load(std::memory_order_relaxed);
+               stats.failedSteals += worker->failedSteals.load(std::memory_order_relaxed);
+               stats.shared += worker->shared.load(std::memory_order_relaxed);
+               stats.queued += worker->deque.size();
+               stats.deepest = std::max(stats.deepest, worker->deepest.load(std::memory_order_relaxed));
+               stats.idle += static_cast<double>(worker->idle.load(std::memory_order_relaxed)) * 1e-9;
+          }
+          return stats;
+     }
+     void resetStats() {
+          for (auto& worker : workers_) {
+               worker->executed.store(0, std::memory_order_relaxed);
+               worker->steals.store(0, std::memory_order_relaxed);
+               worker->failedSteals.store(0, std::memory_order_relaxed);
+               worker->shared.store(0, std::memory_order_relaxed);
+               worker->deepest.store(0, std::memory_order_relaxed);
+               worker->idle.store(0, std::memory_order_relaxed);
+          }
+     }
+
+  private:
+     static constexpr uint32_t SPINS = 64; // empty searches before sleeping
+
+     struct Task {
+          InlineFunction<void(), CAPACITY> job;
+          Counter*                         counter;
+     };
+
+     // Chase-Lev deque of fixed size: the owner pushes and pops at the bottom, thieves take from the
+     // top, and only a race for the last job takes a compare and swap.
+     class Deque {
+       public:
+          static constexpr int64_t SIZE = 1024;
+
+          // false when full
+          bool push(Task* task) {
+               auto bottom = bottom_.load(std::memory_order_relaxed);
+               if (bottom - top_.load(std::memory_order_acquire) >= SIZE)
+                    return false;
+               tasks_[static_cast<size_t>(bottom & (SIZE - 1))].store(task, std::memory_order_relaxed);
+               bottom_.store(bottom + 1, std::memory_order_release);
+               return true;
+          }
+          Task* pop() {
+               auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+               bottom_.store(bottom);
+               auto top = top_.load();
+               if (top > bottom) {
+                    bottom_.store(bottom + 1, std::memory_order_relaxed);
+                    return nullptr;
+               }
+               auto* task = tasks_[static_cast<size_t>(bottom & (SIZE - 1))].load(std::memory_order_relaxed);
+               if (top == bottom) {
+                    if (!top_.compare_exchange_strong(top, top + 1))
+                         task = nullptr;
+                    bottom_.store(bottom + 1, std::memory_order_relaxed);
+               }
+               return task;
+          }
+          Task* steal() {
+               auto top    = top_.load();
+               auto bottom = bottom_.load();
+               if (top >= bottom)
+                    return nullptr;
+               auto* task = tasks_[static_cast<size_t>(top & (SIZE - 1))].load(std::memory_order_relaxed);
+               return top_.compare_exchange_strong(top, top + 1) ? task : nullptr;
+          }
+          size_t size() const {
+               auto bottom = bottom_.load(std::memory_order_relaxed), top = top_.load(std::memory_order_relaxed);
+               return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+          }
+
+       private:
+          alignas(64) std::atomic<int64_t> top_ { 0 };
+          alignas(64) std::atomic<int64_t> bottom_ { 0 };
+          std::array<std::atomic<Task*>, SIZE> tasks_ {};
+     };
+
+     // counters are written by their worker only
+     struct alignas(64) Worker {
+          Worker(JobSystem* system, uint32_t index)
+             : system(system)
+             , seed(index * 0x9E3779B9u + 1) {}
+
+          JobSystem*            system;
+          Deque                 deque {};
+          uint32_t              seed;
+          std::atomic<size_t>   executed { 0 };
+          std::atomic<size_t>   steals { 0 };
+          std::atomic<size_t>   failedSteals { 0 };
+          std::atomic<size_t>   shared { 0 };
+          std::atomic<size_t>   deepest { 0 };
+          std::atomic<uint64_t> idle { 0 }; // nanoseconds
+          std::jthread          thread {};
+     };
+
+     static inline thread_local Worker* current_ { nullptr };
+
+     std::vector<std::unique_ptr<Worker>> workers_ {};
+     std::deque<Task*>                    shared_ {};
+     std::mutex                           sharedMutex_ {};
+     std::atomic<size_t>                  sharedCount_ { 0 };
+     std::atomic<uint32_t>                epoch_ { 0 }; // bumped by every submission, workers sleep on it
+     std::atomic<uint32_t>                sleepers_ { 0 };
+     std::atomic<uint32_t>                finished_ { 0 }; // bumped by every counter reaching zero, waits sleep on it
+
+     // the calling thread's worker, if it is one of ours
+     Worker* local() const { return current_ != nullptr && current_->system == this ? current_ : nullptr; }
+
+     template <typename F>
+     Task* make(F&& job, Counter* counter) {
+          auto* task    = new Task;
+          task->counter = counter;
+          if constexpr (sizeof(std::decay_t<F>) <= CAPACITY && alignof(std::decay_t<F>) <= alignof(std::max_align_t))
+               task->job.emplace(std::forward<F>(job));
+          else
+               task->job.emplace(std::function<void()>(std::forward<F>(job)));
+          // the job that took the counter to zero is done with it before the zero is seen
+          if (counter != nullptr && counter->pending_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+               std::unique_lock lock(counter->mutex_);
+               counter->closing_ = false;
+          }
+          return task;
+     }
+
+     void schedule(Task* task) {
+          auto* self = local();
+          if (self != nullptr && self->deque.push(task)) {
+               auto depth = self->deque.size();
+               if (depth > self->deepest.load(std::memory_order_relaxed))
+                    self->deepest.store(depth, std::memory_order_relaxed);
+          }
+          else {
+               std::unique_lock lock(sharedMutex_);
+               shared_.push_back(task);
+               sharedCount_.fetch_add(1);
+          }
+          epoch_.fetch_add(1);
+          if (sleepers_.load() != 0)
+               epoch_.notify_one();
+     }
+
+     // own deque first, then the shared queue, then the other deques from a random one on
+     Task* find(Worker* self) {
+          if (self != nullptr)
+               if (auto* task = self->deque.pop())
+                    return task;
+          if (sharedCount_.load() != 0) {
+               std::unique_lock lock(sharedMutex_);
+               if (!shared_.empty()) {
+                    auto* task = shared_.front();
+                    shared_.pop_front();
+                    sharedCount_.fetch_sub(1);
+                    if (self != nullptr)
+                         self->shared.fetch_add(1, std::memory_order_relaxed);
+                    return task;
+               }
+          }
+          static thread_local uint32_t outside { 0x2545F491u };
+          auto&                        seed  = self != nullptr ? self->seed : outside;
+          seed ^= seed << 13, seed ^= seed >> 17, seed ^= seed << 5;
+          auto count = workers_.size();
+          for (size_t i = 0, first = seed % count; i != count; ++i) {
+               auto& victim = workers_[(first + i) % count];
+               if (victim.get() == self)
+                    continue;
+               if (auto* task = victim->deque.steal()) {
+                    if (self != nullptr)
+                         self->steals.fetch_add(1, std::memory_order_relaxed);
+                    return task;
+               }
+          }
+          if (self != nullptr)
+               self->failedSteals.fetch_add(1, std::memory_order_relaxed);
+          return nullptr;
+     }
+
+     void run(Task* task, Worker* self) {
+          task->job();
+          auto* counter = task->counter;
+          delete task;
+          if (self != nullptr)
+               self->executed.fetch_add(1, std::memory_order_relaxed);
+          if (counter != nullptr)
+               finish(*counter);
+     }
+
+     // Whoever takes the count to zero first takes the held back jobs under the lock, and only then
+     // stores the zero and touches the counter no more, so a waiter that sees it may destroy it.
+     void finish(Counter& counter) {
+          while (true) {
+               auto pending = counter.pending_.load(std::memory_order_acquire);
+               if (pending > 1) {
+                    if (counter.pending_.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel))
+                         return;
+                    continue;
+               }
+               std::vector<Task*> after;
+               {
+                    std::unique_lock lock(counter.mutex_);
+                    after.swap(counter.after_);
+                    counter.closing_ = true;
+               }
+               pending = 1;
+               if (counter.pending_.compare_exchange_strong(pending, 0)) {
+                    // the counter may be gone now, waiters are woken through the job system
+                    finished_.fetch_add(1);
+                    finished_.notify_all();
+                    for (auto* task : after)
+                         schedule(task);
+                    return;
+               }
+               // a job was added meanwhile, the count is not reaching zero yet
+               std::unique_lock lock(counter.mutex_);
+               counter.after_.insert(counter.after_.end(), after.begin(), after.end());
+               counter.closing_ = false;
+          }
+     }
+
+     template <typename F>
+     void split(size_t begin, size_t end, size_t grain, F& f, Counter& counter) {
+          while (end - begin > grain) {
+               auto middle = begin + (end - begin) / 2;
+               submit([this, middle, end, grain, &f, &counter] { split(middle, end, grain, f, counter); }, &counter);
+               end = middle;
+          }
+          f(begin, end);
+     }
+
+     void work(Worker* self, std::stop_token stop) {
+          current_ = self;
+          uint32_t idle { 0 };
+          while (!stop.stop_requested()) {
+               if (auto* task = find(self)) {
+                    run(task, self);
+                    idle = 0;
+                    continue;
+               }
+               if (++idle < SPINS) {
+                    std::this_thread::yield();
+                    continue;
+               }
+               // a submission after `seen` was read changes the epoch, so the wait returns at once
+               auto seen = epoch_.load();
+               sleepers_.fetch_add(1);
+               if (auto* task = find(self)) {
+                    sleepers_.fetch_sub(1);
+                    run(task, self);
+               }
+               else if (!stop.stop_requested()) {
+                    auto start = std::chrono::steady_clock::now();
+                    epoch_.wait(seen);
+                    self->idle.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()), std::memory_order_relaxed);
+                    sleepers_.fetch_sub(1);
+               }
+               else
+                    sleepers_.fetch_sub(1);
+               idle = 0;
+          }
+     }
+};
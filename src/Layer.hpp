@@ -0,0 +1,397 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "CommandPool.hpp"
+#include "Core.hpp"
+#include "Device.hpp"
+#include "ImageResource2D.hpp"
+#include "TextureTable.hpp"
+#include "Vertex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// A group of draws rasterized once into an offscreen image and composited as one textured quad. The
+// group is drawn again only when it goes stale: its vertices change, it moves or is rescaled, the
+// window is resized, or a texture it samples is repointed (a streamed image becoming resident, say).
+// Vertices are in window NDC like any other draw; the layer keeps what falls inside its bounds.
+class Layer {
+     struct Target {
+          Core*           core;
+          Device*         device;
+          ImageResource2D colorbuffer;
+          ImageResource2D depthbuffer;
+          ImageResource2D resolve;
+          VkFramebuffer   framebuffer { VK_NULL_HANDLE };
+
+          ~Target() { vkDestroyFramebuffer(device->logical(), framebuffer, core->allocator()); }
+     };
+
+  public:
+     struct Formats {
+          VkFormat              color;
+          VkFormat              depth;
+          VkSampleCountFlagBits msaa;
+     };
+
+     // `formats` must match the main render pass, the layer pass is kept compatible with it so the
+     // same pipeline draws into both.
+     Layer(Core* core, Device* device, CommandPool* commandPool, TextureTable* textureTable, size_t maxFramesInFlight, Formats formats, VkRect2D bounds, float scale = 1.f)
+        : core_(core)
+        , device_(device)
+        , commandPool_(commandPool)
+        , textureTable_(textureTable)
+        , maxFramesInFlight_(maxFramesInFlight)
+        , formats_(formats)
+        , bounds_(bounds)
+        , scale_(scale) {
+          createRenderPass();
+          createSampler();
+          target_ = createTarget();
+          slot_   = textureTable_->add(target_->resolve.view(), sampler_);
+     }
+     ~Layer() {
+          textureTable_->remove(slot_);
+          vkDestroySampler(device_->logical(), sampler_, core_->allocator());
+          vkDestroyRenderPass(device_->logical(), renderPass_, core_->allocator());
+     }
+     Layer(const Layer&)            = delete;
+     Layer(Layer&&)                 = delete;
+     Layer& operator=(const Layer&) = delete;
+     Layer& operator=(Layer&&)      = delete;
+
+     void load(std::vector<Vertex> vertecies) {
+          for (auto& vertex : vertecies)
+               if (std::find(textures_.begin(), textures_.end(), vertex.texture) == textures_.end()) {
+                    textures_.push_back(vertex.texture);
+                    generations_.push_back(0);
+               }
+          content_.emplace_back(Buffer<Vertex>::makeVertex(core_, device_, commandPool_, vertecies));
+          dirty_ = true;
+     }
+
+     void clear() {
+          for (auto& buffer : content_)
+               retiringBuffers_.emplace_back(std::move(buffer), maxFramesInFlight_ + 1);
+          content_.clear();
+          textures_.clear();
+          generations_.clear();
+          dirty_ = true;
+     }
+
+     void invalidate() { dirty_ = true; }
+
+     void setBounds(VkRect2D bounds) {
+          bool resized = bounds.extent.width != bounds_.extent.width || bounds.extent.height != bounds_.extent.height;
+          bounds_      = bounds;
+          if (resized)
+               retarget();
+          // the quad is rebuilt and the contents drawn again on the next prepare()
+          window_ = {};
+     }
+
+     // Rasterizes at `scale` times the bounds, for content that is zoomed or shown on a denser display.
+     void setScale(float scale) {
+          if (scale == scale_)
+               return;
+          scale_ = scale;
+          retarget();
+     }
+
+     auto  slot() { return slot_; }
+     auto  bounds() { return bounds_; }
+     auto  scale() { return scale_; }
+     auto& textures() { return textures_; }
+     auto  image() { return target_->resolve.image(); }
+     auto  extent() { return target_->resolve.extent(); }
+     auto  format() { return formats_.color; }
+
+     // Called once per frame before the texture table is flushed. Returns whether the layer has to be
+     // drawn again with record() before it is composited.
+     bool prepare(VkExtent2D window) {
+          for (auto& [target, frames] : retiringTargets_)
+               --frames;
+          std::erase_if(retiringTargets_, [](const auto& retiring) { return retiring.second == 0; });
+          for (auto& [buffer, frames] : retiringBuffers_)
+               --frames;
+          std::erase_if(retiringBuffers_, [](const auto& retiring) { return retiring.second == 0; });
+
+          if (window.width != window_.width || window.height != window_.height) {
+               window_ = window;
+               createQuad();
+               dirty_ = true;
+          }
+          for (size_t i = 0; i != textures_.size(); ++i)
+               if (textureTable_->generation(textures_[i]) != generations_[i])
+                    dirty_ = true;
+          return dirty_;
+     }
+
+     // Draws the group into the layer, outside of any render pass. The resolve is left ready to sample.
+     void record(CommandBuffer* commandBuffer, VkPipeline pipeline, VkPipelineLayout pipelineLayout, VkDescriptorSet descriptorSet) {
+          auto                      extent = target_->resolve.extent();
+          std::vector<VkClearValue> clear_values { { .color = clearColor_ }, { .depthStencil = { 1.f, 0 } } };
+          VkRenderPassBeginInfo     renderPassBeginInfo {
+                   .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                   .pNext           = nullptr,
+                   .renderPass      = renderPass_,
+                   .framebuffer     = target_->framebuffer,
+                   .renderArea      = { { 0, 0 }, extent },
+                   .clearValueCount = static_cast<uint32_t>(clear_values.size()),
+                   .pClearValues    = clear_values.data()
+          };
+          vkCmdBeginRenderPass(commandBuffer->get(), &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+          {
+               // the whole window mapped so that the layer's corner lands on the image origin
+               VkViewport viewport {
+                    .x        = -static_cast<float>(bounds_.offset.x) * scale_,
+                    .y        = -static_cast<float>(bounds_.offset.y) * scale_,
+                    .width    = static_cast<float>(window_.width) * scale_,
+                    .height   = static_cast<float>(window_.height) * scale_,
+                    .minDepth = 0.f,
+                    .maxDepth = 1.f
+               };
+               VkRect2D scissor {
+                    .offset = { 0, 0 },
+                    .extent = extent
+               };
+               vkCmdBindPipeline(commandBuffer->get(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+               vkCmdSetViewport(commandBuffer->get(), 0, 1, &viewport);
+               vkCmdSetScissor(commandBuffer->get(), 0, 1, &scissor);
+               vkCmdBindDescriptorSets(commandBuffer->get(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+               for (auto& buffer : content_) {
+                    VkBuffer     vertexBuffers[]     = { buffer.get() };
+                    VkDeviceSize deviceSizeOffsets[] = { 0 };
+                    vkCmdBindVertexBuffers(commandBuffer->get(), 0, 1, vertexBuffers, deviceSizeOffsets);
+                    vkCmdDraw(commandBuffer->get(), 4, 1, 0, 0);
+               }
+          }
+          vkCmdEndRenderPass(commandBuffer->get());
+
+          for (size_t i = 0; i != textures_.size(); ++i)
+               generations_[i] = textureTable_->generation(textures_[i]);
+          dirty_ = false;
+     }
+
+     // Composites the layer, inside the main render pass with its pipeline bound.
+     void draw(CommandBuffer* commandBuffer) {
+          VkBuffer     vertexBuffers[]     = { quad_->get() };
+          VkDeviceSize deviceSizeOffsets[] = { 0 };
+          vkCmdBindVertexBuffers(commandBuffer->get(), 0, 1, vertexBuffers, deviceSizeOffsets);
+          vkCmdDraw(commandBuffer->get(), 4, 1, 0, 0);
+     }
+
+  private:
+     void createRenderPass() {
+          VkAttachmentDescription colorAttachmentDescription {
+               .flags          = {},
+               .format         = formats_.color,
+               .samples        = formats_.msaa,
+               .loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR,
+               .storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+               .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+               .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+               .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
+               .finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+          };
+          VkAttachmentReference colorAttachmentReference {
+               .attachment = 0,
+               .layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+          };
+          VkAttachmentDescription depthAttachmentDescription {
+               .flags          = {},
+               .format         = formats_.depth,
+               .samples        = formats_.msaa,
+               .loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR,
+               .storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+               .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+               .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+               .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
+               .finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+          };
+          VkAttachmentReference depthAttachmentReference {
+               .attachment = 1,
+               .layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+          };
+          // same format as the swapchain resolve in the main pass, which keeps the passes compatible
+          VkAttachmentDescription colorResolveAttachmentDescription {
+               .flags          = {},
+               .format         = formats_.color,
+               .samples        = VK_SAMPLE_COUNT_1_BIT,
+               .loadOp         = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+               .storeOp        = VK_ATTACHMENT_STORE_OP_STORE,
+               .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+               .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+               .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
+               .finalLayout    = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+          };
+          VkAttachmentReference colorResolveAttachmentReference {
+               .attachment = 2,
+               .layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+          };
+          std::vector<VkAttachmentDescription> attachmentDescriptions { colorAttachmentDescription, depthAttachmentDescription, colorResolveAttachmentDescription };
+
+          VkSubpassDescription subpassDescription {
+               .flags                   = {},
+               .pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS,
+               .inputAttachmentCount    = 0,
+               .pInputAttachments       = nullptr,
+               .colorAttachmentCount    = 1,
+               .pColorAttachments       = &colorAttachmentReference,
+               .pResolveAttachments     = &colorResolveAttachmentReference,
+               .pDepthStencilAttachment = &depthAttachmentReference,
+               .preserveAttachmentCount = 0,
+               .pPreserveAttachments    = nullptr
+          };
+          // frames still in flight may be sampling the previous contents, and the composite that
+          // follows samples the new ones
+          std::vector<VkSubpassDependency> subpassDependencies {
+               VkSubpassDependency {
+                  .srcSubpass      = VK_SUBPASS_EXTERNAL,
+                  .dstSubpass      = 0,
+                  .srcStageMask    = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                  .dstStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+                  .srcAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                  .dstAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                  .dependencyFlags = {} },
+               VkSubpassDependency {
+                  .srcSubpass      = 0,
+                  .dstSubpass      = VK_SUBPASS_EXTERNAL,
+                  .srcStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                  .dstStageMask    = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                  .srcAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                  .dstAccessMask   = VK_ACCESS_SHADER_READ_BIT,
+                  .dependencyFlags = {} }
+          };
+          VkRenderPassCreateInfo renderPassCreateInfo {
+               .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+               .pNext           = nullptr,
+               .flags           = {},
+               .attachmentCount = static_cast<uint32_t>(attachmentDescriptions.size()),
+               .pAttachments    = attachmentDescriptions.data(),
+               .subpassCount    = 1,
+               .pSubpasses      = &subpassDescription,
+               .dependencyCount = static_cast<uint32_t>(subpassDependencies.size()),
+               .pDependencies   = subpassDependencies.data()
+          };
+          if (vkCreateRenderPass(device_->logical(), &renderPassCreateInfo, core_->allocator(), &renderPass_) != VK_SUCCESS)
+               throw std::runtime_error("call to vkCreateRenderPass failed");
+     }
+
+     void createSampler() {
+          VkSamplerCreateInfo samplerCreateInfo {
+               .sType                   = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+               .pNext                   = nullptr,
+               .flags                   = {},
+               .magFilter               = VK_FILTER_LINEAR,
+               .minFilter               = VK_FILTER_LINEAR,
+               .mipmapMode              = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+               .addressModeU            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+               .addressModeV            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+               .addressModeW            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+               .mipLodBias              = 0.f,
+               .anisotropyEnable        = VK_FALSE,
+               .maxAnisotropy           = 1.f,
+               .compareEnable           = VK_FALSE,
+               .compareOp               = VK_COMPARE_OP_ALWAYS,
+               .minLod                  = 0.f,
+               .maxLod                  = 0.f,
+               .borderColor             = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+               .unnormalizedCoordinates = VK_FALSE
+          };
+          if (vkCreateSampler(device_->logical(), &samplerCreateInfo, core_->allocator(), &sampler_) != VK_SUCCESS)
+               throw std::runtime_error("call to vkCreateSampler failed");
+     }
+
+     std::unique_ptr<Target> createTarget() {
+          VkExtent2D extent {
+               std::max(1u, static_cast<uint32_t>(std::ceil(static_cast<float>(bounds_.extent.width) * scale_))),
+               std::max(1u, static_cast<uint32_t>(std::ceil(static_cast<float>(bounds_.extent.height) * scale_)))
+          };
+          auto attachment = [&](VkFormat format, VkSampleCountFlagBits msaa, VkImageUsageFlags usage) {
+               return ImageResource2D::ImageConf {
+                    .format           = format,
+                    .extent           = extent,
+                    .mipLevels        = 1,
+                    .msaa             = msaa,
+                    .tiling           = VK_IMAGE_TILING_OPTIMAL,
+                    .usage            = usage,
+                    .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+               };
+          };
+          auto target = std::unique_ptr<Target>(new Target {
+             .core        = core_,
+             .device      = device_,
+             .colorbuffer = ImageResource2D(core_, device_, attachment(formats_.color, formats_.msaa, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), { .aspect = VK_IMAGE_ASPECT_COLOR_BIT }),
+             .depthbuffer = ImageResource2D(core_, device_, attachment(formats_.depth, formats_.msaa, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT), { .aspect = VK_IMAGE_ASPECT_DEPTH_BIT }),
+             .resolve     = ImageResource2D(core_, device_, attachment(formats_.color, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT), { .aspect = VK_IMAGE_ASPECT_COLOR_BIT }) });
+
+          std::vector<VkImageView> attachments { target->colorbuffer.view(), target->depthbuffer.view(), target->resolve.view() };
+          VkFramebufferCreateInfo  framebufferCreateInfo {
+                .sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+                .pNext           = nullptr,
+                .flags           = {},
+                .renderPass      = renderPass_,
+                .attachmentCount = static_cast<uint32_t>(attachments.size()),
+                .pAttachments    = attachments.data(),
+                .width           = extent.width,
+                .height          = extent.height,
+                .layers          = 1
+          };
+          if (vkCreateFramebuffer(device_->logical(), &framebufferCreateInfo, core_->allocator(), &target->framebuffer) != VK_SUCCESS)
+               throw std::runtime_error("call to vkCreateFramebuffer failed");
+          return target;
+     }
+
+     // The old images may still be sampled by frames in flight, they are destroyed once those are done.
+     void retarget() {
+          retiringTargets_.emplace_back(std::move(target_), maxFramesInFlight_ + 1);
+          target_ = createTarget();
+          textureTable_->set(slot_, target_->resolve.view(), sampler_);
+          dirty_ = true;
+     }
+
+     void createQuad() {
+          auto  x0 = 2.f * static_cast<float>(bounds_.offset.x) / static_cast<float>(window_.width) - 1.f;
+          auto  y0 = 2.f * static_cast<float>(bounds_.offset.y) / static_cast<float>(window_.height) - 1.f;
+          auto  x1 = x0 + 2.f * static_cast<float>(bounds_.extent.width) / static_cast<float>(window_.width);
+          auto  y1 = y0 + 2.f * static_cast<float>(bounds_.extent.height) / static_cast<float>(window_.height);
+          std::vector<Vertex> vertecies {
+               { .position = { x0, y0, 0.f }, .color = { 1.f, 1.f, 1.f }, .textureCoordinate = { 0.f, 0.f }, .texture = slot_ },
+               { .position = { x0, y1, 0.f }, .color = { 1.f, 1.f, 1.f }, .textureCoordinate = { 0.f, 1.f }, .texture = slot_ },
+               { .position = { x1, y0, 0.f }, .color = { 1.f, 1.f, 1.f }, .textureCoordinate = { 1.f, 0.f }, .texture = slot_ },
+               { .position = { x1, y1, 0.f }, .color = { 1.f, 1.f, 1.f }, .textureCoordinate = { 1.f, 1.f }, .texture = slot_ }
+          };
+          if (quad_)
+               retiringBuffers_.emplace_back(std::move(*quad_), maxFramesInFlight_ + 1);
+          quad_.emplace(Buffer<Vertex>::makeVertex(core_, device_, commandPool_, vertecies));
+     }
+
+     VkClearColorValue clearColor_ { { .01f, .01f, .01f, 1.f } };
+
+     Core*         core_;
+     Device*       device_;
+     CommandPool*  commandPool_;
+     TextureTable* textureTable_;
+     size_t        maxFramesInFlight_;
+     Formats       formats_;
+     VkRect2D      bounds_;
+     float         scale_;
+     VkExtent2D    window_ {};
+     bool          dirty_ { true };
+
+     VkRenderPass                  renderPass_;
+     VkSampler                     sampler_;
+     uint32_t                      slot_;
+     std::unique_ptr<Target>       target_;
+     std::optional<Buffer<Vertex>> quad_;
+     std::vector<Buffer<Vertex>>   content_;
+     std::vector<uint32_t>         textures_;
+     std::vector<uint32_t>         generations_;
+
+     std::vector<std::pair<std::unique_ptr<Target>, size_t>> retiringTargets_;
+     std::vector<std::pair<Buffer<Vertex>, size_t>>          retiringBuffers_;
+};
@@ -0,0 +1,506 @@
+#pragma once
+
+#include "JobSystem.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+// Box layout in two passes. measure() asks a node how large it wants to be within an available size,
+// and caches the answer per node for the last few sizes asked; arrange() hands a node its final size
+// and places its children in it. Changing a node drops its cache and its ancestors', everything else
+// keeps answering from cache, and a subtree whose size did not change is not arranged again. Children
+// are stacked on top of each other, laid out in a row or a column with flex grow and shrink, or put
+// in a grid of equal columns. Positions are relative to the parent's corner, in pixels. Large
+// independent subtrees are arranged on the job system.
+class Layout {
+     static constexpr uint32_t NONE = ~0u;
+     // subtrees at least this large go to the job system
+     static constexpr size_t TASK = 256;
+
+     struct Measurement {
+          glm::vec2 available { -1.f };
+          glm::vec2 size {};
+     };
+
+  public:
+     using Id      = uint32_t;
+     using Measure = std::function<glm::vec2(glm::vec2 available)>;
+
+     static constexpr float AUTO     = -1.f;
+     static constexpr float UNBOUNDED = std::numeric_limits<float>::infinity();
+
+     enum class Kind : uint8_t {
+          STACK,
+          ROW,
+          COLUMN,
+          GRID
+     };
+     // Where children sit across the main axis, or along both axes in a stack.
+     enum class Align : uint8_t {
+          START,
+          CENTER,
+          END,
+          STRETCH
+     };
+     // Where children sit along the main axis of a row or column.
+     enum class Justify : uint8_t {
+          START,
+          CENTER,
+          END,
+          SPACE_BETWEEN
+     };
+     struct Edges {
+          float left { 0.f };
+          float top { 0.f };
+          float right { 0.f };
+          float bottom { 0.f };
+     };
+     struct Style {
+          Kind      kind { Kind::STACK };
+          glm::vec2 size { AUTO, AUTO };
+          glm::vec2 minSize { 0.f, 0.f };
+          glm::vec2 maxSize { UNBOUNDED, UNBOUNDED };
+          Edges     padding {};
+          float     gap { 0.f };
+          float     grow { 0.f };
+          float     shrink { 1.f };
+          Align     align { Align::STRETCH };
+          Justify   justify { Justify::START };
+          uint32_t  columns { 1 };
+     };
+
+     struct Stats {
+          size_t nodes;
+          size_t measured;
+          size_t cacheHits;
+          size_t arranged;
+          size_t changed;
+          size_t tasks;
+     };
+
+     // Without a job system everything is arranged on the calling thread.
+     explicit Layout(JobSystem* jobs = nullptr)
+        : jobs_(jobs) {
+          nodes_.emplace_back();
+          nodes_[0].alive = true;
+     }
+     Layout(const Layout&)            = delete;
+     Layout(Layout&&)                 = delete;
+     Layout& operator=(const Layout&) = delete;
+     Layout& operator=(Layout&&)      = delete;
+
+     // Takes the size passed to update().
+     Id root() { return 0; }
+
+     Id create(Id parent) { return create(parent, Style {}); }
+     Id create(Id parent, const Style& style) {
+          Id id;
+          if (!free_.empty()) {
+               id = free_.back();
+               free_.pop_back();
+          }
+          else {
+               id = static_cast<Id>(nodes_.size());
+               nodes_.emplace_back();
+          }
+          auto& node  = nodes_[id];
+          node        = Node {};
+          node.parent = parent;
+          node.style  = style;
+          node.alive  = true;
+          auto& p    = nodes_.at(parent);
+          if (p.lastChild == NONE)
+               p.firstChild = id;
+          else {
+               nodes_[p.lastChild].next = id;
+               node.previous            = p.lastChild;
+          }
+          p.lastChild = id;
+          for (auto a = parent; a != NONE; a = nodes_[a].parent)
+               ++nodes_[a].descendants;
+          ++count_;
+          markDirty(id);
+          return id;
+     }
+
+     // Removes the node and everything below it.
+     void destroy(Id id) {
+          if (id == root() || !nodes_.at(id).alive)
+               return;
+          auto& node = nodes_[id];
+          auto& p    = nodes_[node.parent];
+          (node.previous == NONE ? p.firstChild : nodes_[node.previous].next) = node.next;
+          (node.next == NONE ? p.lastChild : nodes_[node.next].previous)      = node.previous;
+          auto removed = node.descendants + 1;
+          for (auto a = node.parent; a != NONE; a = nodes_[a].parent)
+               nodes_[a].descendants -= removed;
+          markDirty(node.parent);
+          std::vector<Id> stack { id };
+          while (!stack.empty()) {
+               auto current = stack.back();
+               stack.pop_back();
+               for (auto child = nodes_[current].firstChild; child != NONE; child = nodes_[child].next)
+                    stack.push_back(child);
+               nodes_[current] = Node {};
+               free_.push_back(current);
+               --count_;
+          }
+     }
+
+     const Style& style(Id id) { return nodes_.at(id).style; }
+     void         setStyle(Id id, const Style& style) {
+          nodes_.at(id).style = style;
+          markDirty(id);
+     }
+     // Content size of a leaf, text for instance. Called with the size available inside the padding.
+     void setMeasure(Id id, Measure measure) {
+          nodes_.at(id).measure = std::move(measure);
+          markDirty(id);
+     }
+     // The leaf's content changed, its measure function has to be asked again.
+     void invalidate(Id id) { markDirty(id); }
+
+     // Lays the tree out in `size`. Returns the nodes whose position or size changed.
+     const std::vector<Id>& update(glm::vec2 size) {
+          changed_.clear();
+          stats_ = Stats { .nodes = count_, .measured = 0, .cacheHits = 0, .arranged = 0, .changed = 0, .tasks = 0 };
+          auto& root = nodes_[0];
+          if (root.size != size || root.dirty) {
+               root.size = size;
+               tasks_.clear();
+               Pending pending;
+               // subtrees below this size are not split further, so each worker gets a few tasks
+               split_ = std::max(TASK, count_ / (4 * (jobs_ ? jobs_->size() : 1)));
+               tasks_.emplace_back();
+               arrange(0, size, tasks_.front(), &pending);
+               // the calling thread arranges queued subtrees too while it waits
+               if (jobs_)
+                    jobs_->wait(pending.counter);
+               if (pending.error)
+                    std::rethrow_exception(pending.error);
+               for (auto& task : tasks_) {
+                    changed_.insert(changed_.end(), task.changed.begin(), task.changed.end());
+                    stats_.measured += task.measured;
+                    stats_.cacheHits += task.cacheHits;
+                    stats_.arranged += task.arranged;
+               }
+               stats_.tasks = tasks_.size() - 1;
+          }
+          stats_.changed = changed_.size();
+          return changed_;
+     }
+
+     glm::vec2 position(Id id) { return nodes_.at(id).position; }
+     glm::vec2 size(Id id) { return nodes_.at(id).size; }
+     glm::vec2 absolute(Id id) {
+          glm::vec2 position { 0.f, 0.f };
+          for (auto a = id; a != NONE; a = nodes_[a].parent)
+               position += nodes_[a].position;
+          return position;
+     }
+
+     // Node `id` drives widget `widget`, whose parent has to be the widget of the nearest bound
+     // ancestor, or the root widget when there is none.
+     void bind(Id id, uint32_t widget) { nodes_.at(id).widget = widget; }
+
+     // Moves the bound widgets of the nodes the last update() changed, anything with
+     // setRect(widget, position, size) will do.
+     template <typename Widgets>
+     void apply(Widgets& widgets) {
+          std::vector<Id> stack;
+          for (auto id : changed_) {
+               if (!nodes_[id].alive)
+                    continue;
+               // an unbound node carries the nearest bound nodes below it
+               stack.assign(1, id);
+               while (!stack.empty()) {
+                    auto current = stack.back();
+                    stack.pop_back();
+                    auto& node = nodes_[current];
+                    if (node.widget != NONE) {
+                         widgets.setRect(node.widget, offset(current), node.size);
+                         continue;
+                    }
+                    for (auto child = node.firstChild; child != NONE; child = nodes_[child].next)
+                         stack.push_back(child);
+               }
+          }
+     }
+
+     Stats stats() { return stats_; }
+
+  private:
+     struct Node {
+          uint32_t                   parent { NONE };
+          uint32_t                   firstChild { NONE };
+          uint32_t                   lastChild { NONE };
+          uint32_t                   next { NONE };
+          uint32_t                   previous { NONE };
+          uint32_t                   widget { NONE };
+          size_t                     descendants { 0 };
+          Style                      style {};
+          Measure                    measure;
+          std::array<Measurement, 2> cache {};
+          uint32_t                   cacheNext { 0 };
+          glm::vec2                  position { 0.f, 0.f };
+          glm::vec2                  size { -1.f, -1.f };
+          bool                       dirty { true };
+          bool                       alive { false };
+     };
+
+     // What one thread did, merged after the update.
+     struct Task {
+          std::vector<Id> changed;
+          size_t          measured { 0 };
+          size_t          cacheHits { 0 };
+          size_t          arranged { 0 };
+     };
+     struct Pending {
+          JobSystem::Counter counter;
+          std::mutex         mutex;
+          std::exception_ptr error;
+     };
+
+     // the ancestors measure their children, so their answers go too
+     void markDirty(Id id) {
+          for (auto a = id; a != NONE; a = nodes_[a].parent) {
+               auto& node = nodes_[a];
+               node.cache = {};
+               node.dirty = true;
+          }
+     }
+
+     // position relative to the nearest bound ancestor
+     glm::vec2 offset(Id id) {
+          auto position = nodes_[id].position;
+          for (auto a = nodes_[id].parent; a != NONE && nodes_[a].widget == NONE; a = nodes_[a].parent)
+               position += nodes_[a].position;
+          return position;
+     }
+
+     static int   mainAxis(Kind kind) { return kind == Kind::COLUMN ? 1 : 0; }
+     static float inner(float size, float padding) { return std::max(0.f, size - padding); }
+
+     static glm::vec2 clampSize(const Style& style, glm::vec2 size) {
+          return { std::clamp(size.x, style.minSize.x, std::max(style.minSize.x, style.maxSize.x)), std::clamp(size.y, style.minSize.y, std::max(style.minSize.y, style.maxSize.y)) };
+     }
+
+     glm::vec2 measure(Id id, glm::vec2 available, Task& task) {
+          auto& node = nodes_[id];
+          for (auto& entry : node.cache)
+               if (entry.available == available) {
+                    ++task.cacheHits;
+                    return entry.size;
+               }
+          ++task.measured;
+          auto& style = node.style;
+          auto  outer = available;
+          for (int axis = 0; axis != 2; ++axis) {
+               if (style.size[axis] >= 0.f)
+                    outer[axis] = style.size[axis];
+               outer[axis] = std::min(outer[axis], style.maxSize[axis]);
+          }
+          glm::vec2 content { inner(outer.x, style.padding.left + style.padding.right), inner(outer.y, style.padding.top + style.padding.bottom) };
+          glm::vec2 used { 0.f, 0.f };
+          if (node.firstChild == NONE) {
+               if (node.measure)
+                    used = node.measure(content);
+          }
+          else if (style.kind == Kind::STACK) {
+               for (auto child = node.firstChild; child != NONE; child = nodes_[child].next)
+                    used = glm::max(used, measure(child, content, task));
+          }
+          else if (style.kind == Kind::GRID) {
+               auto  columns = std::max(1u, style.columns);
+               auto  cell    = std::isinf(content.x) ? UNBOUNDED : std::max(0.f, (content.x - style.gap * static_cast<float>(columns - 1)) / static_cast<float>(columns));
+               float widest { 0.f }, row { 0.f };
+               uint32_t column { 0 };
+               for (auto child = node.firstChild; child != NONE; child = nodes_[child].next) {
+                    auto size = measure(child, { cell, UNBOUNDED }, task);
+                    widest    = std::max(widest, size.x);
+                    row       = std::max(row, size.y);
+                    if (++column == columns || nodes_[child].next == NONE) {
+                         used.y += row + (nodes_[child].next == NONE ? 0.f : style.gap);
+                         row    = 0.f;
+                         column = 0;
+                    }
+               }
+               auto gaps = style.gap * static_cast<float>(columns - 1);
+               used.x    = std::isinf(content.x) ? widest * static_cast<float>(columns) + gaps : content.x;
+          }
+          else {
+               auto main  = mainAxis(style.kind);
+               bool first = true;
+               auto basis  = content;
+               basis[main] = UNBOUNDED;
+               for (auto child = node.firstChild; child != NONE; child = nodes_[child].next) {
+                    auto size = measure(child, basis, task);
+                    used[main] += size[main] + (first ? 0.f : style.gap);
+                    used[1 - main] = std::max(used[1 - main], size[1 - main]);
+                    first          = false;
+               }
+          }
+          glm::vec2 size { used.x + style.padding.left + style.padding.right, used.y + style.padding.top + style.padding.bottom };
+          for (int axis = 0; axis != 2; ++axis)
+               if (style.size[axis] >= 0.f)
+                    size[axis] = style.size[axis];
+          size = clampSize(style, size);
+
+          node.cache[node.cacheNext] = { available, size };
+          node.cacheNext             = (node.cacheNext + 1) % node.cache.size();
+          return size;
+     }
+
+     // Places the children of `id`, which already has its size, and arranges those whose size changed
+     // or that changed themselves. `pending` is set on the calling thread only, which hands large
+     // subtrees to the job system instead of descending into them.
+     void arrange(Id id, glm::vec2 size, Task& task, Pending* pending) {
+          auto& node  = nodes_[id];
+          auto& style = node.style;
+          node.dirty  = false;
+          ++task.arranged;
+          if (node.firstChild == NONE)
+               return;
+          glm::vec2 origin { style.padding.left, style.padding.top };
+          glm::vec2 content { inner(size.x, style.padding.left + style.padding.right), inner(size.y, style.padding.top + style.padding.bottom) };
+
+          auto stretched = [&](Id child, glm::vec2 measured, int axis) {
+               return style.align == Align::STRETCH && nodes_[child].style.size[axis] < 0.f ? content[axis] : std::min(measured[axis], content[axis]);
+          };
+          auto aligned = [&](float free) {
+               return style.align == Align::CENTER ? free / 2.f : style.align == Align::END ? free : 0.f;
+          };
+
+          if (style.kind == Kind::STACK) {
+               for (auto child = node.firstChild; child != NONE; child = nodes_[child].next) {
+                    auto      measured = measure(child, content, task);
+                    glm::vec2 childSize { stretched(child, measured, 0), stretched(child, measured, 1) };
+                    childSize = clampSize(nodes_[child].style, childSize);
+                    place(child, origin + glm::vec2 { aligned(content.x - childSize.x), aligned(content.y - childSize.y) }, childSize, task, pending);
+               }
+          }
+          else if (style.kind == Kind::GRID) {
+               auto     columns = std::max(1u, style.columns);
+               auto     cell    = std::max(0.f, (content.x - style.gap * static_cast<float>(columns - 1)) / static_cast<float>(columns));
+               uint32_t column { 0 };
+               float    top { origin.y }, row { 0.f };
+               // a row is as tall as its tallest child, so it is measured before it is placed
+               for (auto first = node.firstChild; first != NONE;) {
+                    auto last = first;
+                    for (uint32_t c = 1; c != columns && nodes_[last].next != NONE; ++c)
+                         last = nodes_[last].next;
+                    row = 0.f;
+                    for (auto child = first;; child = nodes_[child].next) {
+                         row = std::max(row, measure(child, { cell, UNBOUNDED }, task).y);
+                         if (child == last)
+                              break;
+                    }
+                    column = 0;
+                    for (auto child = first;; child = nodes_[child].next) {
+                         place(child, { origin.x + static_cast<float>(column++) * (cell + style.gap), top }, clampSize(nodes_[child].style, { cell, row }), task, pending);
+                         if (child == last)
+                              break;
+                    }
+                    top += row + style.gap;
+                    first = nodes_[last].next;
+               }
+          }
+          else {
+               auto                   main  = mainAxis(style.kind);
+               auto                   cross = 1 - main;
+               std::vector<glm::vec2> sizes;
+               float                  total { 0.f }, grow { 0.f }, shrink { 0.f };
+               // children are measured unbounded along the main axis, as in measure(), then grow or shrink
+               auto basis  = content;
+               basis[main] = UNBOUNDED;
+               for (auto child = node.firstChild; child != NONE; child = nodes_[child].next) {
+                    auto& childStyle = nodes_[child].style;
+                    auto  measured   = measure(child, basis, task);
+                    total += measured[main];
+                    grow += childStyle.grow;
+                    shrink += childStyle.shrink * measured[main];
+                    sizes.push_back(measured);
+               }
+               auto gaps = style.gap * static_cast<float>(sizes.size() - 1);
+               auto free = content[main] - total - gaps;
+               size_t i { 0 };
+               for (auto child = node.firstChild; child != NONE; child = nodes_[child].next, ++i) {
+                    auto& childStyle = nodes_[child].style;
+                    if (free > 0.f && grow > 0.f)
+                         sizes[i][main] += free * childStyle.grow / grow;
+                    else if (free < 0.f && shrink > 0.f)
+                         sizes[i][main] += free * childStyle.shrink * sizes[i][main] / shrink;
+                    sizes[i][cross] = stretched(child, sizes[i], cross);
+                    sizes[i]        = clampSize(childStyle, sizes[i]);
+               }
+               float used { gaps };
+               for (auto& childSize : sizes)
+                    used += childSize[main];
+               auto  left = std::max(0.f, content[main] - used);
+               float pen { 0.f }, spacing { style.gap };
+               if (style.justify == Justify::CENTER)
+                    pen = left / 2.f;
+               else if (style.justify == Justify::END)
+                    pen = left;
+               else if (style.justify == Justify::SPACE_BETWEEN && sizes.size() > 1)
+                    spacing += left / static_cast<float>(sizes.size() - 1);
+               i = 0;
+               for (auto child = node.firstChild; child != NONE; child = nodes_[child].next, ++i) {
+                    glm::vec2 position = origin;
+                    position[main] += pen;
+                    position[cross] += aligned(content[cross] - sizes[i][cross]);
+                    place(child, position, sizes[i], task, pending);
+                    pen += sizes[i][main] + spacing;
+               }
+          }
+     }
+
+     void place(Id id, glm::vec2 position, glm::vec2 size, Task& task, Pending* pending) {
+          auto& node    = nodes_[id];
+          bool  resized = node.size != size;
+          if (node.position != position || resized)
+               task.changed.push_back(id);
+          node.position = position;
+          node.size     = size;
+          if (!resized && !node.dirty)
+               return;
+          if (!pending || node.descendants < TASK)
+               arrange(id, size, task, nullptr);
+          else if (node.descendants >= split_ || !jobs_)
+               arrange(id, size, task, pending);
+          else {
+               auto& subtask = tasks_.emplace_back();
+               jobs_->submit(
+                    [this, id, size, &subtask, pending] {
+                         try {
+                              arrange(id, size, subtask, nullptr);
+                         }
+                         catch (...) {
+                              std::unique_lock lock(pending->mutex);
+                              pending->error = std::current_exception();
+                         }
+                    },
+                    &pending->counter);
+          }
+     }
+
+     JobSystem*  jobs_;
+     size_t      count_ { 0 };
+     size_t      split_ { TASK };
+     Stats       stats_ {};
+
+     std::vector<Node> nodes_;
+     std::vector<Id>   free_;
+     std::vector<Id>   changed_;
+     std::deque<Task>  tasks_;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+// Read-only view of a whole file. Pages are faulted in on first touch, so opening is cheap and the
+// cost of a read lands wherever the bytes are first used.
+class MappedFile {
+  public:
+#ifdef _WIN32
+     MappedFile(const std::string& path) {
+          file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+          if (file_ == INVALID_HANDLE_VALUE)
+               throw std::runtime_error("call to CreateFileA failed to open " + path);
+          LARGE_INTEGER size;
+          if (!GetFileSizeEx(file_, &size)) {
+               CloseHandle(file_);
+               throw std::runtime_error("call to GetFileSizeEx failed");
+          }
+          size_ = static_cast<size_t>(size.QuadPart);
+          if (size_ == 0)
+               return;
+          mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+          if (mapping_ == nullptr) {
+               CloseHandle(file_);
+               throw std::runtime_error("call to CreateFileMappingW failed");
+          }
+          data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+          if (data_ == nullptr) {
+               CloseHandle(mapping_);
+               CloseHandle(file_);
+               throw std::runtime_error("call to MapViewOfFile failed");
+          }
+     }
+     ~MappedFile() {
+          if (data_ != nullptr)
+               UnmapViewOfFile(data_);
+          if (mapping_ != nullptr)
+               CloseHandle(mapping_);
+          CloseHandle(file_);
+     }
+#else
+     MappedFile(const std::string& path) {
+          file_ = open(path.c_str(), O_RDONLY);
+          if (file_ == -1)
+               throw std::runtime_error("call to open failed to open " + path);
+          struct stat status;
+          if (fstat(file_, &status) != 0) {
+               close(file_);
+               throw std::runtime_error("call to fstat failed");
+          }
+          size_ = static_cast<size_t>(status.st_size);
+          if (size_ == 0)
+               return;
+          auto data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file_, 0);
+          if (data == MAP_FAILED) {
+               close(file_);
+               throw std::runtime_error("call to mmap failed");
+          }
+          posix_madvise(data, size_, POSIX_MADV_SEQUENTIAL);
+          data_ = static_cast<const uint8_t*>(data);
+     }
+     ~MappedFile() {
+          if (data_ != nullptr)
+               munmap(const_cast<uint8_t*>(data_), size_);
+          close(file_);
+     }
+#endif
+     MappedFile(const MappedFile&)            = delete;
+     MappedFile(MappedFile&&)                 = delete;
+     MappedFile& operator=(const MappedFile&) = delete;
+     MappedFile& operator=(MappedFile&&)      = delete;
+
+     const uint8_t*           data() const { return data_; }
+     size_t                   size() const { return size_; }
+     std::span<const uint8_t> bytes() const { return { data_, size_ }; }
+
+  private:
+#ifdef _WIN32
+     HANDLE         file_ { INVALID_HANDLE_VALUE };
+     HANDLE         mapping_ { nullptr };
+#else
+     int            file_ { -1 };
+#endif
+     const uint8_t* data_ { nullptr };
+     size_t         size_ { 0 };
+};
@@ -0,0 +1,557 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_AMD64)
+#define PATH_X86
+#include <emmintrin.h>
+#endif
+
+// Vector outline of lines, quadratic and cubic curves and circular arcs, in its own units. Every path
+// has an id that changes whenever it is edited, which is what tessellations are cached under.
+class Path {
+  public:
+     enum class Verb : uint8_t {
+          MOVE,
+          LINE,
+          QUAD,
+          CUBIC,
+          CLOSE
+     };
+
+     Path()
+        : id_(next()) {}
+
+     void moveTo(glm::vec2 point) { add(Verb::MOVE, { point }); }
+     void lineTo(glm::vec2 point) { add(Verb::LINE, { point }); }
+     void quadTo(glm::vec2 control, glm::vec2 point) { add(Verb::QUAD, { control, point }); }
+     void cubicTo(glm::vec2 control0, glm::vec2 control1, glm::vec2 point) { add(Verb::CUBIC, { control0, control1, point }); }
+     void close() { add(Verb::CLOSE, {}); }
+
+     // Circular arc from `start` radians over `sweep`, positive sweeps turning from x towards y. Joins
+     // the current point with a line, or starts a contour.
+     void arc(glm::vec2 centre, float radius, float start, float sweep) {
+          auto at = [&](float angle) { return centre + radius * glm::vec2 { std::cos(angle), std::sin(angle) }; };
+          if (verbs_.empty() || verbs_.back() == Verb::CLOSE)
+               moveTo(at(start));
+          else if (points_.back() != at(start))
+               lineTo(at(start));
+          // cubics of at most a quarter turn each
+          auto pieces = std::max(1, static_cast<int>(std::ceil(std::abs(sweep) / 1.5707964f)));
+          auto step   = sweep / static_cast<float>(pieces);
+          auto k      = 4.f / 3.f * std::tan(step / 4.f);
+          for (int i = 0; i != pieces; ++i) {
+               auto a0 = start + step * static_cast<float>(i);
+               auto a1 = a0 + step;
+               auto p0 = at(a0);
+               auto p1 = at(a1);
+               cubicTo(p0 + k * radius * glm::vec2 { -std::sin(a0), std::cos(a0) }, p1 - k * radius * glm::vec2 { -std::sin(a1), std::cos(a1) }, p1);
+          }
+     }
+
+     void circle(glm::vec2 centre, float radius) {
+          moveTo(centre + glm::vec2 { radius, 0.f });
+          arc(centre, radius, 0.f, 6.2831853f);
+          close();
+     }
+     void rect(glm::vec2 position, glm::vec2 size) {
+          moveTo(position);
+          lineTo({ position.x + size.x, position.y });
+          lineTo(position + size);
+          lineTo({ position.x, position.y + size.y });
+          close();
+     }
+
+     void clear() {
+          verbs_.clear();
+          points_.clear();
+          id_ = next();
+     }
+
+     bool     empty() const { return verbs_.empty(); }
+     uint64_t id() const { return id_; }
+
+     const std::vector<Verb>&      verbs() const { return verbs_; }
+     const std::vector<glm::vec2>& points() const { return points_; }
+
+  private:
+     static uint64_t next() {
+          static std::atomic<uint64_t> ids { 1 };
+          return ids++;
+     }
+
+     void add(Verb verb, std::initializer_list<glm::vec2> points) {
+          verbs_.push_back(verb);
+          points_.insert(points_.end(), points);
+          id_ = next();
+     }
+
+     std::vector<Verb>      verbs_;
+     std::vector<glm::vec2> points_;
+     uint64_t               id_;
+};
+
+// Indexed triangles in path units.
+struct PathMesh {
+     std::vector<glm::vec2> points;
+     std::vector<uint32_t>  indices;
+     glm::vec2              low { 0.f, 0.f };
+     glm::vec2              high { 0.f, 0.f };
+};
+
+enum class FillRule : uint8_t {
+     NON_ZERO,
+     EVEN_ODD
+};
+
+struct Stroke {
+     enum class Join : uint8_t {
+          MITER,
+          BEVEL,
+          ROUND
+     };
+     enum class Cap : uint8_t {
+          BUTT,
+          SQUARE,
+          ROUND
+     };
+     float width { 1.f };
+     Join  join { Join::MITER };
+     Cap   cap { Cap::BUTT };
+     // miters longer than this many half widths are bevelled
+     float miterLimit { 4.f };
+};
+
+// Paths to polylines to triangles. Curves are cut into as many segments as Wang's formula needs to
+// stay within the tolerance, and evaluated four parameters at a time.
+namespace Tessellate {
+
+     struct Contour {
+          uint32_t first;
+          uint32_t count;
+          bool     closed;
+     };
+
+     // Points of a cubic at t = 1/n .. n/n, appended to `out`.
+     inline void cubicScalar(glm::vec2 p0, glm::vec2 p1, glm::vec2 p2, glm::vec2 p3, uint32_t n, std::vector<glm::vec2>& out) {
+          // power basis: ((a t + b) t + c) t + p0
+          auto a    = p3 - p0 + 3.f * (p1 - p2);
+          auto b    = 3.f * (p0 - 2.f * p1 + p2);
+          auto c    = 3.f * (p1 - p0);
+          auto step = 1.f / static_cast<float>(n);
+          for (uint32_t i = 1; i <= n; ++i) {
+               auto t = static_cast<float>(i) * step;
+               out.push_back(((a * t + b) * t + c) * t + p0);
+          }
+          out.back() = p3;
+     }
+
+     inline void cubic(glm::vec2 p0, glm::vec2 p1, glm::vec2 p2, glm::vec2 p3, uint32_t n, std::vector<glm::vec2>& out) {
+#ifdef PATH_X86
+          if (n < 4) {
+               cubicScalar(p0, p1, p2, p3, n, out);
+               return;
+          }
+          auto a    = p3 - p0 + 3.f * (p1 - p2);
+          auto b    = 3.f * (p0 - 2.f * p1 + p2);
+          auto c    = 3.f * (p1 - p0);
+          auto step = 1.f / static_cast<float>(n);
+          auto base = out.size();
+          out.resize(base + n);
+          auto* dst = reinterpret_cast<float*>(out.data() + base);
+          // x and y of four parameters per iteration, interleaved back into points on the store
+          const __m128 ax = _mm_set1_ps(a.x), ay = _mm_set1_ps(a.y);
+          const __m128 bx = _mm_set1_ps(b.x), by = _mm_set1_ps(b.y);
+          const __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y);
+          const __m128 dx = _mm_set1_ps(p0.x), dy = _mm_set1_ps(p0.y);
+          const __m128 s  = _mm_set1_ps(step);
+          uint32_t     i { 0 };
+          for (; i + 4 <= n; i += 4) {
+               auto t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_setr_epi32(static_cast<int>(i + 1), static_cast<int>(i + 2), static_cast<int>(i + 3), static_cast<int>(i + 4))), s);
+               auto x = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(ax, t), bx), t), cx), t), dx);
+               auto y = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(ay, t), by), t), cy), t), dy);
+               _mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(x, y));
+               _mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(x, y));
+          }
+          for (; i != n; ++i) {
+               auto t            = static_cast<float>(i + 1) * step;
+               out[base + i] = ((a * t + b) * t + c) * t + p0;
+          }
+          out.back() = p3;
+#else
+          cubicScalar(p0, p1, p2, p3, n, out);
+#endif
+     }
+
+     // Wang's formula: segments keeping a curve of degree `degree` within `tolerance` of its chords.
+     inline uint32_t segments(float degree, float secondDifference, float tolerance) {
+          auto n = std::ceil(std::sqrt(degree * (degree - 1.f) / 8.f * secondDifference / tolerance));
+          return static_cast<uint32_t>(std::clamp(n, 1.f, 1024.f));
+     }
+
+     // Cuts the path into polylines, a contour per move.
+     inline void flatten(const Path& path, float tolerance, std::vector<glm::vec2>& points, std::vector<Contour>& contours) {
+          points.clear();
+          contours.clear();
+          auto& source = path.points();
+          size_t next { 0 };
+          auto   finish = [&](bool closed) {
+               if (!contours.empty() && contours.back().count == 0) {
+                    auto& contour  = contours.back();
+                    contour.count  = static_cast<uint32_t>(points.size()) - contour.first;
+                    contour.closed = closed;
+                    if (contour.count < 2)
+                         contours.pop_back();
+               }
+          };
+          auto start = [&](glm::vec2 point) {
+               finish(false);
+               contours.push_back({ static_cast<uint32_t>(points.size()), 0, false });
+               points.push_back(point);
+          };
+          for (auto verb : path.verbs()) {
+               if (verb != Path::Verb::MOVE && verb != Path::Verb::CLOSE && (contours.empty() || contours.back().count != 0))
+                    start(points.empty() ? glm::vec2 { 0.f, 0.f } : points.back());
+               switch (verb) {
+                    case Path::Verb::MOVE:
+                         start(source[next++]);
+                         break;
+                    case Path::Verb::LINE:
+                         points.push_back(source[next++]);
+                         break;
+                    case Path::Verb::QUAD: {
+                         auto p0 = points.back(), p1 = source[next], p2 = source[next + 1];
+                         next += 2;
+                         auto n = segments(2.f, glm::length(p0 - 2.f * p1 + p2), tolerance);
+                         // raised to a cubic, which it is exactly
+                         cubic(p0, p0 + 2.f / 3.f * (p1 - p0), p2 + 2.f / 3.f * (p1 - p2), p2, n, points);
+                    } break;
+                    case Path::Verb::CUBIC: {
+                         auto p0 = points.back(), p1 = source[next], p2 = source[next + 1], p3 = source[next + 2];
+                         next += 3;
+                         auto n = segments(3.f, std::max(glm::length(p0 - 2.f * p1 + p2), glm::length(p1 - 2.f * p2 + p3)), tolerance);
+                         cubic(p0, p1, p2, p3, n, points);
+                    } break;
+                    case Path::Verb::CLOSE:
+                         if (!contours.empty() && contours.back().count == 0) {
+                              auto first = points[contours.back().first];
+                              finish(true);
+                              // a contour drawn after a close starts where the closed one did
+                              contours.push_back({ static_cast<uint32_t>(points.size()), 0, false });
+                              points.push_back(first);
+                         }
+                         break;
+               }
+          }
+          finish(false);
+     }
+
+     inline void bounds(PathMesh& mesh) {
+          if (mesh.points.empty())
+               return;
+          mesh.low = mesh.high = mesh.points.front();
+          for (auto& point : mesh.points) {
+               mesh.low  = glm::min(mesh.low, point);
+               mesh.high = glm::max(mesh.high, point);
+          }
+     }
+
+     // Sweeps the edges top to bottom: between two consecutive vertex heights the edges crossing the
+     // band are ordered by x, and every span the fill rule counts as inside becomes a trapezoid. Where
+     // two edges cross inside a band, it is cut at the crossing first, so the order holds throughout
+     // each band. Holes, overlaps, self-intersections and either rule come out of the same pass.
+     inline void fill(const std::vector<glm::vec2>& points, const std::vector<Contour>& contours, FillRule rule, PathMesh& mesh) {
+          struct Edge {
+               glm::vec2 top;
+               glm::vec2 bottom;
+               int       winding;
+               float     slope; // dx / dy
+          };
+          std::vector<Edge>  edges;
+          std::vector<float> heights;
+          for (auto& contour : contours)
+               for (uint32_t i = 0; i != contour.count; ++i) {
+                    auto p = points[contour.first + i];
+                    auto q = points[contour.first + (i + 1) % contour.count];
+                    heights.push_back(p.y);
+                    if (p.y == q.y)
+                         continue;
+                    auto down = p.y < q.y;
+                    auto top = down ? p : q, bottom = down ? q : p;
+                    edges.push_back({ top, bottom, down ? 1 : -1, (bottom.x - top.x) / (bottom.y - top.y) });
+               }
+          std::sort(heights.begin(), heights.end());
+          heights.erase(std::unique(heights.begin(), heights.end()), heights.end());
+          std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.top.y < b.top.y; });
+
+          struct Crossing {
+               float    x0;
+               float    x1;
+               int      winding;
+               uint32_t edge;
+          };
+          std::vector<uint32_t> active;
+          std::vector<Crossing> crossings;
+          size_t                next { 0 };
+          auto                  x = [&](uint32_t e, float y) { return edges[e].top.x + (y - edges[e].top.y) * edges[e].slope; };
+          for (size_t h = 0; h + 1 < heights.size();) {
+               auto y0 = heights[h], y1 = heights[h + 1];
+               std::erase_if(active, [&](uint32_t e) { return edges[e].bottom.y <= y0; });
+               for (; next != edges.size() && edges[next].top.y <= y0; ++next)
+                    if (edges[next].bottom.y > y0)
+                         active.push_back(static_cast<uint32_t>(next));
+               crossings.clear();
+               for (auto e : active)
+                    crossings.push_back({ x(e, y0), x(e, y1), edges[e].winding, e });
+               std::sort(crossings.begin(), crossings.end(), [](const Crossing& a, const Crossing& b) { return a.x0 < b.x0 || (a.x0 == b.x0 && a.x1 < b.x1); });
+               // edges that swap places inside the band cross there, and the first to cross are
+               // neighbours at its top; the band then ends at that crossing and the next one starts
+               auto cut = y1;
+               for (size_t c = 0; c + 1 < crossings.size(); ++c) {
+                    auto& a = crossings[c];
+                    auto& b = crossings[c + 1];
+                    if (a.x1 <= b.x1)
+                         continue;
+                    auto y = y0 + (y1 - y0) * (b.x0 - a.x0) / ((a.x1 - b.x1) - (a.x0 - b.x0));
+                    if (y > y0 && y < cut)
+                         cut = y;
+               }
+               if (cut != y1) {
+                    y1 = cut;
+                    for (auto& crossing : crossings)
+                         crossing.x1 = x(crossing.edge, y1);
+                    heights[h] = y1;
+               }
+               else
+                    ++h;
+               int winding { 0 };
+               for (size_t c = 0; c + 1 < crossings.size(); ++c) {
+                    winding += crossings[c].winding;
+                    bool inside = rule == FillRule::NON_ZERO ? winding != 0 : (winding & 1) != 0;
+                    if (!inside)
+                         continue;
+                    auto& left  = crossings[c];
+                    auto& right = crossings[c + 1];
+                    auto  base  = static_cast<uint32_t>(mesh.points.size());
+                    mesh.points.insert(mesh.points.end(), { { left.x0, y0 }, { right.x0, y0 }, { right.x1, y1 }, { left.x1, y1 } });
+                    mesh.indices.insert(mesh.indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+               }
+          }
+          bounds(mesh);
+     }
+
+     // A quad per segment, joins on the outer side of every turn, caps on open ends.
+     inline void stroke(const std::vector<glm::vec2>& source, const std::vector<Contour>& contours, const Stroke& style, float tolerance, PathMesh& mesh) {
+          auto half = style.width / 2.f;
+          auto emit = [&](std::initializer_list<glm::vec2> triangle) {
+               auto base = static_cast<uint32_t>(mesh.points.size());
+               mesh.points.insert(mesh.points.end(), triangle);
+               mesh.indices.insert(mesh.indices.end(), { base, base + 1, base + 2 });
+          };
+          auto quad = [&](glm::vec2 a, glm::vec2 b, glm::vec2 c, glm::vec2 d) {
+               auto base = static_cast<uint32_t>(mesh.points.size());
+               mesh.points.insert(mesh.points.end(), { a, b, c, d });
+               mesh.indices.insert(mesh.indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+          };
+          // a fan around `centre` from `from` to `to`, the short way round
+          auto round = [&](glm::vec2 centre, glm::vec2 from, glm::vec2 to) {
+               auto a0    = std::atan2(from.y, from.x);
+               auto sweep = std::atan2(to.y, to.x) - a0;
+               if (sweep > 3.14159265f)
+                    sweep -= 6.2831853f;
+               if (sweep < -3.14159265f)
+                    sweep += 6.2831853f;
+               auto step  = 2.f * std::acos(std::clamp(1.f - tolerance / std::max(half, tolerance), -1.f, 1.f));
+               auto count = std::max(1, static_cast<int>(std::ceil(std::abs(sweep) / std::max(step, 1e-3f))));
+               auto prev  = centre + from;
+               for (int i = 1; i <= count; ++i) {
+                    auto angle = a0 + sweep * static_cast<float>(i) / static_cast<float>(count);
+                    auto point = centre + half * glm::vec2 { std::cos(angle), std::sin(angle) };
+                    emit({ centre, prev, point });
+                    prev = point;
+               }
+          };
+          auto normal = [&](glm::vec2 a, glm::vec2 b) {
+               auto d = b - a;
+               return glm::vec2 { -d.y, d.x } * (half / glm::length(d));
+          };
+
+          std::vector<glm::vec2> points;
+          for (auto& contour : contours) {
+               // repeated points have no direction
+               points.clear();
+               for (uint32_t i = 0; i != contour.count; ++i)
+                    if (points.empty() || source[contour.first + i] != points.back())
+                         points.push_back(source[contour.first + i]);
+               if (contour.closed && points.size() > 1 && points.front() == points.back())
+                    points.pop_back();
+               if (points.size() < 2)
+                    continue;
+               auto closed   = contour.closed && points.size() > 2;
+               auto count    = points.size();
+               auto segments = closed ? count : count - 1;
+
+               for (size_t i = 0; i != segments; ++i) {
+                    auto a = points[i], b = points[(i + 1) % count];
+                    auto n = normal(a, b);
+                    quad(a + n, b + n, b - n, a - n);
+               }
+               for (size_t i = closed ? 0 : 1; i != (closed ? count : count - 1); ++i) {
+                    auto p     = points[i];
+                    auto n0    = normal(points[(i + count - 1) % count], p);
+                    auto n1    = normal(p, points[(i + 1) % count]);
+                    auto d0    = glm::vec2 { n0.y, -n0.x };
+                    auto d1    = glm::vec2 { n1.y, -n1.x };
+                    auto cross = d0.x * d1.y - d0.y * d1.x;
+                    if (std::abs(cross) < 1e-6f * half * half)
+                         continue;
+                    // the outer side is the one the turn opens
+                    auto o0 = cross > 0.f ? -n0 : n0;
+                    auto o1 = cross > 0.f ? -n1 : n1;
+                    if (style.join == Stroke::Join::ROUND)
+                         round(p, o0, o1);
+                    else {
+                         auto bisector = o0 + o1;
+                         auto cosine   = glm::dot(bisector, o0) / (glm::length(bisector) * half);
+                         auto miter    = half / std::max(cosine, 1e-6f);
+                         if (style.join == Stroke::Join::MITER && miter <= style.miterLimit * half) {
+                              auto tip = p + bisector * (miter / glm::length(bisector));
+                              emit({ p, p + o0, tip });
+                              emit({ p, tip, p + o1 });
+                         }
+                         else
+                              emit({ p, p + o0, p + o1 });
+                    }
+               }
+               if (closed)
+                    continue;
+               for (auto end : { 0, 1 }) {
+                    auto p    = end ? points[count - 1] : points[0];
+                    auto q    = end ? points[count - 2] : points[1];
+                    auto n    = normal(q, p);
+                    auto away = glm::vec2 { n.y, -n.x };
+                    if (style.cap == Stroke::Cap::SQUARE)
+                         quad(p + n, p + n + away, p - n + away, p - n);
+                    else if (style.cap == Stroke::Cap::ROUND) {
+                         round(p, n, away);
+                         round(p, away, -n);
+                    }
+               }
+          }
+          bounds(mesh);
+     }
+}
+
+// Tessellations by path, operation and scale. Scales are rounded to steps of a quarter octave, and
+// each step is tessellated at the tolerance of its largest scale, so zooming reuses meshes within a
+// step and a chart drawn every frame is tessellated once. The least recently used meshes go when the
+// cache is full; meshes are shared, so one still being drawn stays alive.
+class PathCache {
+     // a quarter pixel at the largest scale of a step
+     static constexpr float TOLERANCE = .25f;
+
+     struct Key {
+          uint64_t path;
+          int32_t  step;
+          uint32_t operation; // fill rule, or join and cap
+          float    width;
+          float    miterLimit;
+
+          bool operator==(const Key&) const = default;
+     };
+     struct Hash {
+          size_t operator()(const Key& key) const {
+               uint32_t width;
+               std::memcpy(&width, &key.width, sizeof(width));
+               return std::hash<uint64_t> {}(key.path * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(key.operation) << 40 ^ static_cast<uint64_t>(width) << 8 ^ static_cast<uint32_t>(key.step));
+          }
+     };
+     struct Entry {
+          std::shared_ptr<const PathMesh> mesh;
+          uint64_t                        used;
+     };
+
+  public:
+     struct Stats {
+          size_t entries;
+          size_t hits;
+          size_t misses;
+          size_t evicted;
+     };
+
+     explicit PathCache(size_t capacity = 4096)
+        : capacity_(capacity) {}
+
+     // Triangles covering the path, for drawing at `scale` pixels per path unit.
+     std::shared_ptr<const PathMesh> fill(const Path& path, float scale, FillRule rule = FillRule::NON_ZERO) {
+          return get({ path.id(), step(scale), static_cast<uint32_t>(rule), 0.f, 0.f }, [&](float tolerance, PathMesh& mesh) {
+               Tessellate::flatten(path, tolerance, points_, contours_);
+               Tessellate::fill(points_, contours_, rule, mesh);
+          });
+     }
+
+     // Triangles covering the outline; the width is in path units.
+     std::shared_ptr<const PathMesh> stroke(const Path& path, float scale, const Stroke& style) {
+          auto operation = 16 + static_cast<uint32_t>(style.join) * 4 + static_cast<uint32_t>(style.cap);
+          return get({ path.id(), step(scale), operation, style.width, style.miterLimit }, [&](float tolerance, PathMesh& mesh) {
+               Tessellate::flatten(path, tolerance, points_, contours_);
+               Tessellate::stroke(points_, contours_, style, tolerance, mesh);
+          });
+     }
+
+     Stats stats() {
+          stats_.entries = entries_.size();
+          return stats_;
+     }
+
+  private:
+     static int32_t step(float scale) { return static_cast<int32_t>(std::ceil(std::log2(std::max(scale, 1e-6f)) * 4.f)); }
+
+     template <typename F>
+     std::shared_ptr<const PathMesh> get(const Key& key, F&& tessellate) {
+          ++clock_;
+          if (auto it = entries_.find(key); it != entries_.end()) {
+               ++stats_.hits;
+               it->second.used = clock_;
+               return it->second.mesh;
+          }
+          ++stats_.misses;
+          auto mesh = std::make_shared<PathMesh>();
+          tessellate(TOLERANCE / std::exp2(static_cast<float>(key.step) / 4.f), *mesh);
+          if (entries_.size() >= capacity_)
+               evict();
+          entries_.emplace(key, Entry { mesh, clock_ });
+          return mesh;
+     }
+
+     // drops the least recently used quarter at once, so a full cache evicts rarely
+     void evict() {
+          std::vector<uint64_t> used;
+          used.reserve(entries_.size());
+          for (auto& [key, entry] : entries_)
+               used.push_back(entry.used);
+          auto nth = used.begin() + static_cast<std::ptrdiff_t>(used.size() / 4);
+          std::nth_element(used.begin(), nth, used.end());
+          auto cutoff = *nth;
+          stats_.evicted += std::erase_if(entries_, [cutoff](const auto& entry) { return entry.second.used <= cutoff; });
+     }
+
+     size_t   capacity_;
+     uint64_t clock_ { 0 };
+     Stats    stats_ {};
+
+     std::unordered_map<Key, Entry, Hash> entries_;
+     std::vector<glm::vec2>               points_;
+     std::vector<Tessellate::Contour>     contours_;
+};
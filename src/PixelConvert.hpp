@@ -0,0 +1,433 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_AMD64)
+#define PIXEL_CONVERT_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define PIXEL_CONVERT_AVX2
+#else
+#include <cpuid.h>
+#define PIXEL_CONVERT_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// Pixel kernels for uploads and readbacks, one row at a time. Every kernel has a scalar version and,
+// on x86, SSE2 and AVX2 versions picked at runtime from the CPU's features. All of them work on 8 bit
+// RGBA (or BGRA) texels; `dst` may be write-combined memory, it is only ever written front to back.
+namespace PixelConvert {
+
+     enum class Isa {
+          SCALAR,
+          SSE2,
+          AVX2
+     };
+
+     inline Isa detect() {
+#ifdef PIXEL_CONVERT_X86
+          // AVX2 needs the CPU bit and the OS saving the ymm registers (OSXSAVE and XCR0 bits 1, 2)
+#if defined(_MSC_VER) && !defined(__clang__)
+          int info[4];
+          __cpuidex(info, 1, 0);
+          bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+          __cpuidex(info, 7, 0);
+          bool avx2 = info[1] & (1 << 5);
+#else
+          unsigned a, b, c, d;
+          bool     osAvx { false };
+          if (__get_cpuid_count(1, 0, &a, &b, &c, &d) && (c & (1 << 27)) && (c & (1 << 28))) {
+               unsigned lo, hi;
+               __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+               osAvx = (lo & 6) == 6;
+          }
+          bool avx2 = __get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & (1 << 5));
+#endif
+          return osAvx && avx2 ? Isa::AVX2 : Isa::SSE2;
+#else
+          return Isa::SCALAR;
+#endif
+     }
+
+     inline Isa& activeIsa() {
+          static Isa isa = detect();
+          return isa;
+     }
+
+     // For benchmarks and tests; never goes above what the CPU supports.
+     inline void setIsa(Isa isa) { activeIsa() = std::min(isa, detect()); }
+
+     // sRGB transfer function as tables: 256 floats for decoding, 4096 bytes for encoding, which is
+     // fine enough that every 8 bit value round-trips.
+     inline const std::array<float, 256>& srgbToLinearTable() {
+          static const auto table = [] {
+               std::array<float, 256> table;
+               for (int i = 0; i != 256; ++i) {
+                    float c  = i / 255.f;
+                    table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+               }
+               return table;
+          }();
+          return table;
+     }
+     inline const std::array<uint8_t, 4096>& linearToSrgbTable() {
+          static const auto table = [] {
+               std::array<uint8_t, 4096> table;
+               for (int i = 0; i != 4096; ++i) {
+                    float c  = i / 4095.f;
+                    float s  = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+                    table[i] = static_cast<uint8_t>(std::lround(std::clamp(s, 0.f, 1.f) * 255.f));
+               }
+               return table;
+          }();
+          return table;
+     }
+
+     namespace scalar {
+          inline void expandToRGBA(const uint8_t* src, int channels, uint8_t* dst, size_t pixels) {
+               for (size_t i = 0; i != pixels; ++i) {
+                    auto* s = src + i * channels;
+                    auto* d = dst + i * 4;
+                    if (channels < 3) {
+                         d[0] = d[1] = d[2] = s[0];
+                         d[3]               = channels == 2 ? s[1] : 255;
+                    }
+                    else {
+                         d[0] = s[0];
+                         d[1] = s[1];
+                         d[2] = s[2];
+                         d[3] = channels == 4 ? s[3] : 255;
+                    }
+               }
+          }
+
+          inline void swizzleRB(const uint8_t* src, uint8_t* dst, size_t pixels) {
+               for (size_t i = 0; i != pixels * 4; i += 4) {
+                    uint8_t r  = src[i];
+                    dst[i + 1] = src[i + 1];
+                    dst[i + 3] = src[i + 3];
+                    dst[i]     = src[i + 2];
+                    dst[i + 2] = r;
+               }
+          }
+
+          // round(c * a / 255) without a division
+          inline uint8_t mulDiv255(uint32_t c, uint32_t a) {
+               uint32_t t = c * a + 128;
+               return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+          }
+
+          inline void premultiply(const uint8_t* src, uint8_t* dst, size_t pixels) {
+               for (size_t i = 0; i != pixels * 4; i += 4) {
+                    uint8_t a  = src[i + 3];
+                    dst[i]     = mulDiv255(src[i], a);
+                    dst[i + 1] = mulDiv255(src[i + 1], a);
+                    dst[i + 2] = mulDiv255(src[i + 2], a);
+                    dst[i + 3] = a;
+               }
+          }
+
+          inline void unpremultiply(const uint8_t* src, uint8_t* dst, size_t pixels) {
+               for (size_t i = 0; i != pixels * 4; i += 4) {
+                    uint8_t a     = src[i + 3];
+                    float   scale = a == 0 ? 0.f : 255.f / a;
+                    for (int c = 0; c != 3; ++c)
+                         dst[i + c] = static_cast<uint8_t>(std::min(255l, std::lrint(src[i + c] * scale)));
+                    dst[i + 3] = a;
+               }
+          }
+
+          inline void toLinear(const uint8_t* src, float* dst, size_t n) {
+               auto& table = srgbToLinearTable();
+               for (size_t i = 0; i != n; ++i)
+                    dst[i] = table[src[i]];
+          }
+
+          inline void toSrgb(const float* src, uint8_t* dst, size_t n) {
+               auto& table = linearToSrgbTable();
+               for (size_t i = 0; i != n; ++i)
+                    dst[i] = table[static_cast<size_t>(std::clamp(src[i], 0.f, 1.f) * 4095.f + .5f)];
+          }
+     }
+
+#ifdef PIXEL_CONVERT_X86
+     namespace sse2 {
+          inline void expandToRGBA(const uint8_t* src, int channels, uint8_t* dst, size_t pixels) {
+               size_t        i { 0 };
+               const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+               if (channels == 1) {
+                    for (; i + 16 <= pixels; i += 16) {
+                         __m128i g  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                         __m128i gg = _mm_unpacklo_epi8(g, g);
+                         __m128i ga = _mm_unpacklo_epi8(g, _mm_set1_epi8(-1));
+                         _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_unpacklo_epi16(gg, ga));
+                         _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 16), _mm_unpackhi_epi16(gg, ga));
+                         gg = _mm_unpackhi_epi8(g, g);
+                         ga = _mm_unpackhi_epi8(g, _mm_set1_epi8(-1));
+                         _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 32), _mm_unpacklo_epi16(gg, ga));
+                         _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 48), _mm_unpackhi_epi16(gg, ga));
+                    }
+               }
+               else if (channels == 2) {
+                    for (; i + 8 <= pixels; i += 8) {
+                         // each 16 bit lane holds grey | alpha << 8, grey is doubled into its own lane
+                         __m128i ga = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+                         __m128i g  = _mm_and_si128(ga, _mm_set1_epi16(0x00FF));
+                         __m128i gg = _mm_or_si128(g, _mm_slli_epi16(g, 8));
+                         _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_unpacklo_epi16(gg, ga));
+                         _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 16), _mm_unpackhi_epi16(gg, ga));
+                    }
+               }
+               else if (channels == 3) {
+                    // four unaligned 32 bit loads per vector; each reads one byte past its pixel, so the
+                    // last pixel is left to the scalar tail
+                    for (; i + 5 <= pixels; i += 4) {
+                         int32_t p[4];
+                         std::memcpy(&p[0], src + i * 3, 4);
+                         std::memcpy(&p[1], src + i * 3 + 3, 4);
+                         std::memcpy(&p[2], src + i * 3 + 6, 4);
+                         std::memcpy(&p[3], src + i * 3 + 9, 4);
+                         __m128i rgbx = _mm_set_epi32(p[3], p[2], p[1], p[0]);
+                         _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(rgbx, alpha));
+                    }
+               }
+               else {
+                    std::memcpy(dst, src, pixels * 4);
+                    return;
+               }
+               scalar::expandToRGBA(src + i * channels, channels, dst + i * 4, pixels - i);
+          }
+
+          inline __m128i swizzleRB(__m128i v) {
+               __m128i ga = _mm_and_si128(v, _mm_set1_epi32(static_cast<int>(0xFF00FF00)));
+               __m128i r  = _mm_and_si128(_mm_slli_epi32(v, 16), _mm_set1_epi32(0x00FF0000));
+               __m128i b  = _mm_and_si128(_mm_srli_epi32(v, 16), _mm_set1_epi32(0x000000FF));
+               return _mm_or_si128(ga, _mm_or_si128(r, b));
+          }
+
+          inline void swizzleRB(const uint8_t* src, uint8_t* dst, size_t pixels) {
+               size_t i { 0 };
+               for (; i + 4 <= pixels; i += 4)
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), swizzleRB(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4))));
+               scalar::swizzleRB(src + i * 4, dst + i * 4, pixels - i);
+          }
+
+          // Two pixels as eight 16 bit lanes; every colour lane is multiplied by its pixel's alpha and
+          // the alpha lane by 255, then (t + (t >> 8)) >> 8 divides by 255 with rounding.
+          inline __m128i premultiply(__m128i c) {
+               __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, 0xFF), 0xFF);
+               a         = _mm_or_si128(_mm_and_si128(a, _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1)), _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0));
+               __m128i t = _mm_add_epi16(_mm_mullo_epi16(c, a), _mm_set1_epi16(128));
+               return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+          }
+
+          inline void premultiply(const uint8_t* src, uint8_t* dst, size_t pixels) {
+               size_t        i { 0 };
+               const __m128i zero = _mm_setzero_si128();
+               for (; i + 4 <= pixels; i += 4) {
+                    __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+                    __m128i lo = premultiply(_mm_unpacklo_epi8(v, zero));
+                    __m128i hi = premultiply(_mm_unpackhi_epi8(v, zero));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo, hi));
+               }
+               scalar::premultiply(src + i * 4, dst + i * 4, pixels - i);
+          }
+
+          // One pixel as four floats, scaled by 255 / alpha; zero alpha gives zero colour.
+          inline __m128i unpremultiply(__m128i c32) {
+               __m128 c     = _mm_cvtepi32_ps(c32);
+               __m128 a     = _mm_shuffle_ps(c, c, 0xFF);
+               __m128 scale = _mm_and_ps(_mm_div_ps(_mm_set1_ps(255.f), a), _mm_cmpneq_ps(a, _mm_setzero_ps()));
+               __m128 mask  = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+               scale        = _mm_or_ps(_mm_and_ps(mask, scale), _mm_andnot_ps(mask, _mm_set1_ps(1.f)));
+               return _mm_cvtps_epi32(_mm_mul_ps(c, scale));
+          }
+
+          inline void unpremultiply(const uint8_t* src, uint8_t* dst, size_t pixels) {
+               size_t        i { 0 };
+               const __m128i zero = _mm_setzero_si128();
+               for (; i + 4 <= pixels; i += 4) {
+                    __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+                    __m128i lo = _mm_unpacklo_epi8(v, zero);
+                    __m128i hi = _mm_unpackhi_epi8(v, zero);
+                    __m128i p0 = unpremultiply(_mm_unpacklo_epi16(lo, zero));
+                    __m128i p1 = unpremultiply(_mm_unpackhi_epi16(lo, zero));
+                    __m128i p2 = unpremultiply(_mm_unpacklo_epi16(hi, zero));
+                    __m128i p3 = unpremultiply(_mm_unpackhi_epi16(hi, zero));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3)));
+               }
+               scalar::unpremultiply(src + i * 4, dst + i * 4, pixels - i);
+          }
+
+          // no gather before AVX2, the decode table lookups stay scalar
+          inline void toLinear(const uint8_t* src, float* dst, size_t n) { scalar::toLinear(src, dst, n); }
+
+          inline void toSrgb(const float* src, uint8_t* dst, size_t n) {
+               auto&  table = linearToSrgbTable();
+               size_t i { 0 };
+               for (; i + 4 <= n; i += 4) {
+                    __m128  c = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), _mm_setzero_ps()), _mm_set1_ps(1.f));
+                    int32_t index[4];
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(index), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(4095.f)), _mm_set1_ps(.5f))));
+                    for (int j = 0; j != 4; ++j)
+                         dst[i + j] = table[index[j]];
+               }
+               scalar::toSrgb(src + i, dst + i, n - i);
+          }
+     }
+
+     namespace avx2 {
+          PIXEL_CONVERT_AVX2 inline void expandToRGBA(const uint8_t* src, int channels, uint8_t* dst, size_t pixels) {
+               size_t        i { 0 };
+               const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+               if (channels == 1) {
+                    for (; i + 8 <= pixels; i += 8) {
+                         __m256i g = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+                         _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_or_si256(_mm256_mullo_epi32(g, _mm256_set1_epi32(0x010101)), alpha));
+                    }
+               }
+               else if (channels == 2) {
+                    for (; i + 8 <= pixels; i += 8) {
+                         __m256i ga = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2)));
+                         __m256i g  = _mm256_mullo_epi32(_mm256_and_si256(ga, _mm256_set1_epi32(0xFF)), _mm256_set1_epi32(0x010101));
+                         __m256i a  = _mm256_slli_epi32(_mm256_srli_epi32(ga, 8), 24);
+                         _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_or_si256(g, a));
+                    }
+               }
+               else if (channels == 3) {
+                    // 24 source bytes per 8 pixels: spread 12 into each 128 bit lane, then shuffle in lane;
+                    // the 32 byte load runs 8 bytes past them, hence the larger tail
+                    const __m256i spread  = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+                    const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                       0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+                    for (; i + 11 <= pixels; i += 8) {
+                         __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 3));
+                         v         = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(v, spread), shuffle);
+                         _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_or_si256(v, alpha));
+                    }
+               }
+               else {
+                    std::memcpy(dst, src, pixels * 4);
+                    return;
+               }
+               sse2::expandToRGBA(src + i * channels, channels, dst + i * 4, pixels - i);
+          }
+
+          PIXEL_CONVERT_AVX2 inline void swizzleRB(const uint8_t* src, uint8_t* dst, size_t pixels) {
+               const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                  2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+               size_t i { 0 };
+               for (; i + 8 <= pixels; i += 8) {
+                    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_shuffle_epi8(v, shuffle));
+               }
+               sse2::swizzleRB(src + i * 4, dst + i * 4, pixels - i);
+          }
+
+          PIXEL_CONVERT_AVX2 inline void premultiply(const uint8_t* src, uint8_t* dst, size_t pixels) {
+               // per pixel: broadcast byte 3 to the colour lanes and 255 to the alpha lane
+               const __m256i spread = _mm256_setr_epi8(6, -1, 6, -1, 6, -1, -1, -1, 14, -1, 14, -1, 14, -1, -1, -1,
+                  6, -1, 6, -1, 6, -1, -1, -1, 14, -1, 14, -1, 14, -1, -1, -1);
+               const __m256i alphaLane = _mm256_set1_epi64x(0x00FF000000000000);
+               const __m256i zero      = _mm256_setzero_si256();
+               size_t        i { 0 };
+               for (; i + 8 <= pixels; i += 8) {
+                    __m256i v  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+                    __m256i lo = _mm256_unpacklo_epi8(v, zero);
+                    __m256i hi = _mm256_unpackhi_epi8(v, zero);
+                    __m256i al = _mm256_or_si256(_mm256_shuffle_epi8(lo, spread), alphaLane);
+                    __m256i ah = _mm256_or_si256(_mm256_shuffle_epi8(hi, spread), alphaLane);
+                    __m256i tl = _mm256_add_epi16(_mm256_mullo_epi16(lo, al), _mm256_set1_epi16(128));
+                    __m256i th = _mm256_add_epi16(_mm256_mullo_epi16(hi, ah), _mm256_set1_epi16(128));
+                    tl         = _mm256_srli_epi16(_mm256_add_epi16(tl, _mm256_srli_epi16(tl, 8)), 8);
+                    th         = _mm256_srli_epi16(_mm256_add_epi16(th, _mm256_srli_epi16(th, 8)), 8);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_packus_epi16(tl, th));
+               }
+               sse2::premultiply(src + i * 4, dst + i * 4, pixels - i);
+          }
+
+          PIXEL_CONVERT_AVX2 inline __m256i unpremultiply(__m256i c32) {
+               __m256 c     = _mm256_cvtepi32_ps(c32);
+               __m256 a     = _mm256_shuffle_ps(c, c, 0xFF);
+               __m256 scale = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(255.f), a), _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_NEQ_OQ));
+               scale        = _mm256_blend_ps(scale, _mm256_set1_ps(1.f), 0x88);
+               return _mm256_cvtps_epi32(_mm256_mul_ps(c, scale));
+          }
+
+          PIXEL_CONVERT_AVX2 inline void unpremultiply(const uint8_t* src, uint8_t* dst, size_t pixels) {
+               size_t i { 0 };
+               for (; i + 8 <= pixels; i += 8) {
+                    // two pixels per register, packing keeps them in lane order so the halves interleave
+                    __m256i p0 = unpremultiply(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * 4))));
+                    __m256i p1 = unpremultiply(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * 4 + 8))));
+                    __m256i p2 = unpremultiply(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * 4 + 16))));
+                    __m256i p3 = unpremultiply(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * 4 + 24))));
+                    __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(p0, p1), _mm256_packs_epi32(p2, p3));
+                    packed         = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), packed);
+               }
+               sse2::unpremultiply(src + i * 4, dst + i * 4, pixels - i);
+          }
+
+          PIXEL_CONVERT_AVX2 inline void toLinear(const uint8_t* src, float* dst, size_t n) {
+               auto&  table = srgbToLinearTable();
+               size_t i { 0 };
+               for (; i + 8 <= n; i += 8) {
+                    __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+                    _mm256_storeu_ps(dst + i, _mm256_i32gather_ps(table.data(), index, 4));
+               }
+               scalar::toLinear(src + i, dst + i, n - i);
+          }
+
+          PIXEL_CONVERT_AVX2 inline void toSrgb(const float* src, uint8_t* dst, size_t n) {
+               auto&  table = linearToSrgbTable();
+               size_t i { 0 };
+               for (; i + 8 <= n; i += 8) {
+                    __m256  c = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i), _mm256_setzero_ps()), _mm256_set1_ps(1.f));
+                    int32_t index[8];
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(index), _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(c, _mm256_set1_ps(4095.f)), _mm256_set1_ps(.5f))));
+                    for (int j = 0; j != 8; ++j)
+                         dst[i + j] = table[index[j]];
+               }
+               scalar::toSrgb(src + i, dst + i, n - i);
+          }
+     }
+
+#define PIXEL_CONVERT_DISPATCH(kernel, ...)             \
+     switch (activeIsa()) {                             \
+          case Isa::AVX2: return avx2::kernel(__VA_ARGS__);   \
+          case Isa::SSE2: return sse2::kernel(__VA_ARGS__);   \
+          default: return scalar::kernel(__VA_ARGS__);        \
+     }
+#else
+#define PIXEL_CONVERT_DISPATCH(kernel, ...) return scalar::kernel(__VA_ARGS__);
+#endif
+
+     // 1 (grey), 2 (grey + alpha), 3 (RGB) or 4 (RGBA) channels in, RGBA out.
+     inline void expandToRGBA(const uint8_t* src, int channels, uint8_t* dst, size_t pixels) { PIXEL_CONVERT_DISPATCH(expandToRGBA, src, channels, dst, pixels) }
+     // RGBA <-> BGRA, `src` and `dst` may be the same row.
+     inline void swizzleRB(const uint8_t* src, uint8_t* dst, size_t pixels) { PIXEL_CONVERT_DISPATCH(swizzleRB, src, dst, pixels) }
+     // Multiplies colour by alpha on the stored values, in place allowed. For sRGB encoded images this
+     // is the usual approximation, exact premultiplication goes through toLinear / toSrgb.
+     inline void premultiply(const uint8_t* src, uint8_t* dst, size_t pixels) { PIXEL_CONVERT_DISPATCH(premultiply, src, dst, pixels) }
+     inline void unpremultiply(const uint8_t* src, uint8_t* dst, size_t pixels) { PIXEL_CONVERT_DISPATCH(unpremultiply, src, dst, pixels) }
+     // Per channel, `n` values; alpha is not sRGB encoded, callers handle it themselves.
+     inline void toLinear(const uint8_t* src, float* dst, size_t n) { PIXEL_CONVERT_DISPATCH(toLinear, src, dst, n) }
+     inline void toSrgb(const float* src, uint8_t* dst, size_t n) { PIXEL_CONVERT_DISPATCH(toSrgb, src, dst, n) }
+
+#undef PIXEL_CONVERT_DISPATCH
+
+     inline bool isOpaque(const uint8_t* src, int channels, size_t pixels) {
+          if (channels == 1 || channels == 3)
+               return true;
+          for (size_t i = 0; i != pixels; ++i)
+               if (src[i * channels + channels - 1] != 255)
+                    return false;
+          return true;
+     }
+}
@@ -3,8 +3,21 @@
 #include "DescriptorSets.hpp"
 #include "ImageResource2D.hpp"
 #include "Swapchain.hpp"
+#include "Vertex.hpp"
 
 class RenderProgram {
+     // What differs between the pipelines drawing into the pass.
+     struct PipelineConf {
+          const char*                              vertexShader;
+          const char*                              fragmentShader;
+          VkVertexInputBindingDescription          binding;
+          const VkVertexInputAttributeDescription* attributes;
+          uint32_t                                 attributeCount;
+          VkPrimitiveTopology                      topology;
+          VkCullModeFlags                          cullMode;
+          VkBool32                                 depthTest;
+     };
+
   public:
      struct Attachments {
           Swapchain*       swapchain;
@@ -19,13 +32,55 @@ class RenderProgram {
           createRenderPass();
           createFramebuffers();
           createPipelineLayout();
-          createPipeline();
+          auto attributes = Vertex::attributeDescriptions();
+          pipeline_       = createPipeline({
+               .vertexShader   = "./shaders/shader.vert.spv",
+               .fragmentShader = "./shaders/shader.frag.spv",
+               .binding        = Vertex::bindingDescription(),
+               .attributes     = attributes.data(),
+               .attributeCount = static_cast<uint32_t>(attributes.size()),
+               .topology       = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+               .cullMode       = VK_CULL_MODE_BACK_BIT,
+               .depthTest      = VK_TRUE });
+          // the same, moved by each widget's motion record
+          widgetPipeline_ = createPipeline({
+               .vertexShader   = "./shaders/widget.vert.spv",
+               .fragmentShader = "./shaders/shader.frag.spv",
+               .binding        = Vertex::bindingDescription(),
+               .attributes     = attributes.data(),
+               .attributeCount = static_cast<uint32_t>(attributes.size()),
+               .topology       = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+               .cullMode       = VK_CULL_MODE_BACK_BIT,
+               .depthTest      = VK_TRUE });
+          // 2D draw lists keep painter's order instead of depth, and may wind either way
+          auto attributes2D = Vertex2D::attributeDescriptions();
+          shapesPipeline_   = createPipeline({
+               .vertexShader   = "./shaders/shapes.vert.spv",
+               .fragmentShader = "./shaders/shapes.frag.spv",
+               .binding        = Vertex2D::bindingDescription(),
+               .attributes     = attributes2D.data(),
+               .attributeCount = static_cast<uint32_t>(attributes2D.size()),
+               .topology       = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+               .cullMode       = VK_CULL_MODE_NONE,
+               .depthTest      = VK_FALSE });
+          textPipeline_ = createPipeline({
+               .vertexShader   = "./shaders/shapes.vert.spv",
+               .fragmentShader = "./shaders/text.frag.spv",
+               .binding        = Vertex2D::bindingDescription(),
+               .attributes     = attributes2D.data(),
+               .attributeCount = static_cast<uint32_t>(attributes2D.size()),
+               .topology       = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+               .cullMode       = VK_CULL_MODE_NONE,
+               .depthTest      = VK_FALSE });
      }
      ~RenderProgram() {
           vkDestroyRenderPass(device_->logical(), renderPass_, core_->allocator());
           for (auto framebuffer : framebuffers_)
                vkDestroyFramebuffer(device_->logical(), framebuffer, core_->allocator());
           vkDestroyPipeline(device_->logical(), pipeline_, core_->allocator());
+          vkDestroyPipeline(device_->logical(), widgetPipeline_, core_->allocator());
+          vkDestroyPipeline(device_->logical(), shapesPipeline_, core_->allocator());
+          vkDestroyPipeline(device_->logical(), textPipeline_, core_->allocator());
           vkDestroyPipelineLayout(device_->logical(), pipelineLayout_, core_->allocator());
      }
      void beginRenderPass(size_t framebufferIndex, CommandBuffer* commandBuffer) {
@@ -50,6 +105,9 @@ class RenderProgram {
           createFramebuffers();
      }
      auto& pipeline() { return pipeline_; }
+     auto& widgetPipeline() { return widgetPipeline_; }
+     auto& shapesPipeline() { return shapesPipeline_; }
+     auto& textPipeline() { return textPipeline_; }
      auto& pipelineLayout() { return pipelineLayout_; }
 
   private:
@@ -63,7 +121,7 @@ class RenderProgram {
                .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
                .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
                .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
-               .finalLayout    = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+               .finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
           };
           VkAttachmentReference colorAttachmentReference {
                .attachment = 0,
@@ -95,7 +153,7 @@ class RenderProgram {
                .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
                .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
                .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
-               .finalLayout    = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+               .finalLayout    = attachments_.swapchain->finalLayout()
           };
           VkAttachmentReference colorResolveAttachmentReference {
                .attachment = 2,
@@ -210,10 +268,10 @@ class RenderProgram {
      }
      // ---------------------------------------------------------------------------------------- //
      // ---------------------------------------------------------------------------------------- //
-     void createPipeline() {
-          std::vector<char> vertShaderCode   = readFile("./shaders/shader.vert.spv");
+     VkPipeline createPipeline(const PipelineConf& conf) {
+          std::vector<char> vertShaderCode   = readFile(conf.vertexShader);
           VkShaderModule    vertShaderModule = createShaderModule(vertShaderCode);
-          std::vector<char> fragShaderCode   = readFile("./shaders/shader.frag.spv");
+          std::vector<char> fragShaderCode   = readFile(conf.fragmentShader);
           VkShaderModule    fragShaderModule = createShaderModule(fragShaderCode);
 
           std::vector<VkPipelineShaderStageCreateInfo> shaderStages {
@@ -235,23 +293,20 @@ class RenderProgram {
                   .pSpecializationInfo = nullptr }
           };
           // ----------------------------------------------------------------------------------- //
-          auto bindingDescription    = Vertex::bindingDescription();
-          auto attributeDescriptions = Vertex::attributeDescriptions();
-
           VkPipelineVertexInputStateCreateInfo vkPipelineVertexInputStateCreateInfo {
                .sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
                .pNext                           = nullptr,
                .flags                           = {},
                .vertexBindingDescriptionCount   = 1,
-               .pVertexBindingDescriptions      = &bindingDescription,
-               .vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()),
-               .pVertexAttributeDescriptions    = attributeDescriptions.data()
+               .pVertexBindingDescriptions      = &conf.binding,
+               .vertexAttributeDescriptionCount = conf.attributeCount,
+               .pVertexAttributeDescriptions    = conf.attributes
           };
           VkPipelineInputAssemblyStateCreateInfo vkPipelineInputAssemblyStateCreateInfo {
                .sType                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
                .pNext                  = nullptr,
                .flags                  = {},
-               .topology               = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+               .topology               = conf.topology,
                .primitiveRestartEnable = VK_FALSE
           };
           VkPipelineViewportStateCreateInfo vkPipelineViewportStateCreateInfo {
@@ -270,7 +325,7 @@ class RenderProgram {
                .depthClampEnable        = VK_FALSE,
                .rasterizerDiscardEnable = VK_FALSE,
                .polygonMode             = VK_POLYGON_MODE_FILL,
-               .cullMode                = VK_CULL_MODE_BACK_BIT,
+               .cullMode                = conf.cullMode,
                .frontFace               = VK_FRONT_FACE_COUNTER_CLOCKWISE,
                .depthBiasEnable         = VK_FALSE,
                .depthBiasConstantFactor = 0.f,
@@ -303,8 +358,8 @@ class RenderProgram {
                .sType                 = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
                .pNext                 = nullptr,
                .flags                 = {},
-               .depthTestEnable       = VK_TRUE,
-               .depthWriteEnable      = VK_TRUE,
+               .depthTestEnable       = conf.depthTest,
+               .depthWriteEnable      = conf.depthTest,
                .depthCompareOp        = VK_COMPARE_OP_LESS,
                .depthBoundsTestEnable = VK_FALSE,
                .stencilTestEnable     = VK_FALSE,
@@ -358,11 +413,13 @@ class RenderProgram {
                .basePipelineIndex   = 0
           };
           // ----------------------------------------------------------------------------------- //
-          if (vkCreateGraphicsPipelines(device_->logical(), {}, 1u, &vkGraphicsPipelineCreateInfo, core_->allocator(), &pipeline_) != VK_SUCCESS)
+          VkPipeline pipeline;
+          if (vkCreateGraphicsPipelines(device_->logical(), {}, 1u, &vkGraphicsPipelineCreateInfo, core_->allocator(), &pipeline) != VK_SUCCESS)
                throw std::runtime_error("call to vkCreateGraphicsPipelines failed");
           // ----------------------------------------------------------------------------------- //
           vkDestroyShaderModule(device_->logical(), vertShaderModule, core_->allocator());
           vkDestroyShaderModule(device_->logical(), fragShaderModule, core_->allocator());
+          return pipeline;
      }
      // ---------------------------------------------------------------------------------------- //
      VkClearColorValue clearColor_ { { .01f, .01f, .01f, 1.f } };
@@ -378,4 +435,7 @@ class RenderProgram {
      std::vector<VkFramebuffer> framebuffers_;
      VkPipelineLayout           pipelineLayout_;
      VkPipeline                 pipeline_;
+     VkPipeline                 widgetPipeline_;
+     VkPipeline                 shapesPipeline_;
+     VkPipeline                 textPipeline_;
 };
@@ -1,16 +1,32 @@
 #pragma once
 
+#include "Animator.hpp"
 #include "Buffer.hpp"
 #include "Core.hpp"
 #include "RenderProgram.hpp"
 // #include "Data.hpp"
 // #include "DescriptorSets.hpp"
 #include "Device.hpp"
+#include "DrawList.hpp"
+#include "FrameCapture.hpp"
 #include "GraphicsPipeline.hpp"
+#include "Layer.hpp"
 #include "RenderPass.hpp"
+#include "Text.hpp"
+#include "TextureCache.hpp"
+#include "TextureStreamer.hpp"
+#include "TextureTable.hpp"
+#include "JobSystem.hpp"
 #include "Vertex.hpp"
+#include "WidgetTree.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
 #include <vector>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -39,26 +55,60 @@ class Renderer {
           };
      }
 
+     // What a frame draws of the scene, built by the thread that changes it and never touched again
+     // until the thread that draws has taken it in; only handing it over is locked.
+     struct Packet {
+          VkExtent2D            extent;
+          WidgetTree::Changes   widgets;
+          DrawList::Batches     list;
+          Text::Uploads         glyphs;
+          std::vector<uint32_t> textures; // slots the widgets and the draw list sample
+
+          bool empty() const { return widgets.runs.empty() && widgets.motions.empty() && !list.changed && glyphs.cells.empty(); }
+          void clear() {
+               widgets.clear();
+               list.changed = false;
+               glyphs.clear();
+               textures.clear();
+          }
+     };
+
      // std::chrono::_V2::steady_clock::time_point           start   {std::chrono::steady_clock::now()};
   public:
-     Renderer(Core* core, Surface* surface)
+     // Timed when the GPU is done with the frame.
+     struct FrameTimes {
+          uint64_t frame;
+          double   cpu; // milliseconds preparing, recording and submitting
+          double   gpu; // milliseconds from the frame's first command to its last, 0 without timestamps
+     };
+
+     // Without a surface, frames are drawn offscreen at `extent` and never presented.
+     Renderer(Core* core, VkSurfaceKHR surface, JobSystem* jobs, VkExtent2D extent = {})
         : core_(core)
         , device_(core_)
         , commandPool_(core_, &device_)
         , renderCommandBuffers_(commandPool_.createCommandBuffers(2))
-        , descriptorSetLayout_(core_, &device_)
-        , descriptorPool_(core_, &device_, &descriptorSetLayout_)
-        , swapchain_(core_, surface, &device_)
+        , descriptorSetLayout_(core_, &device_, std::min(maxTextures_, device_.maxBindlessTextures()))
+        , descriptorPool_(core_, &device_, &descriptorSetLayout_, maxFramesInFlight_)
+        , swapchain_(core_, surface, &device_, extent)
         , colorbuffer_(core_, &device_, iConf(swapchain_.extent()), { .aspect = VK_IMAGE_ASPECT_COLOR_BIT }) // could be better
         , depthbuffer_(core_, &device_, dConf(swapchain_.extent()), { .aspect = VK_IMAGE_ASPECT_DEPTH_BIT })
-        , texture_(core_, &device_, &commandPool_)
         , renderProgram_(core_, &device_, &descriptorSetLayout_, { &swapchain_, &colorbuffer_, &depthbuffer_ }) // Good
-     {
-          descriptorSets_ = descriptorPool_.createDescriptorSets(maxFramesInFlight_, &texture_);
+        , textureTable_(core_, &device_, &descriptorPool_, maxFramesInFlight_, descriptorSetLayout_.textureCount())
+        , textureStreamer_(core_, &device_, &commandPool_, &textureTable_, jobs, maxFramesInFlight_)
+        , textureCache_(&textureStreamer_, maxFramesInFlight_, TextureCache::defaultBudget(&device_))
+        , frameCapture_(core_, &device_, &commandPool_, jobs)
+        , widgets_(swapchain_.extent())
+        , widgetBuffers_(core_, &device_, &commandPool_, maxFramesInFlight_)
+        , animator_(&widgets_)
+        , drawListBuffers_(core_, &device_, &commandPool_, maxFramesInFlight_)
+        , text_(core_, &device_, &commandPool_, &textureTable_, maxFramesInFlight_) {
+          textureCache_.acquire(TEXTURE_PATH);
 
-          auto extent = swapchain_.extent();
-          width_      = extent.width;
-          height_     = extent.height;
+          width_     = swapchain_.extent().width;
+          height_    = swapchain_.extent().height;
+          extent_    = swapchain_.extent();
+          requested_ = swapchain_.extent();
 
           VkSemaphoreCreateInfo vkSemaphoreCreateInfo {
                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
@@ -70,6 +120,19 @@ class Renderer {
                .pNext = nullptr,
                .flags = VK_FENCE_CREATE_SIGNALED_BIT
           };
+          timestampPeriod_ = device_.timestampPeriod();
+          if (timestampPeriod_ != 0.f) {
+               VkQueryPoolCreateInfo vkQueryPoolCreateInfo {
+                    .sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                    .pNext              = nullptr,
+                    .flags              = {},
+                    .queryType          = VK_QUERY_TYPE_TIMESTAMP,
+                    .queryCount         = static_cast<uint32_t>(2 * maxFramesInFlight_),
+                    .pipelineStatistics = {}
+               };
+               if (vkCreateQueryPool(device_.logical(), &vkQueryPoolCreateInfo, core_->allocator(), &timestamps_) != VK_SUCCESS)
+                    throw std::runtime_error("call to vkCreateQueryPool failed");
+          }
           for (size_t i = 0; i != maxFramesInFlight_; ++i) {
                if (vkCreateSemaphore(device_.logical(), &vkSemaphoreCreateInfo, core_->allocator(), &imageAvailable_[i]) != VK_SUCCESS)
                     throw std::runtime_error("call to vkCreateSemaphore failed");
@@ -87,46 +150,250 @@ class Renderer {
                vkDestroySemaphore(device_.logical(), renderFinished_[i], core_->allocator());
                vkDestroyFence(device_.logical(), imageInFlight_[i], core_->allocator());
           }
+          if (timestamps_ != VK_NULL_HANDLE)
+               vkDestroyQueryPool(device_.logical(), timestamps_, core_->allocator());
+     }
+
+     // Returns the slot shaders index through Vertex::texture. The texture must outlive its slot.
+     uint32_t addTexture(Texture* texture) { return textureTable_.add(texture); }
+     void     removeTexture(uint32_t slot) { textureTable_.remove(slot); }
+
+     // Same slot semantics, but the image is decoded in the background and the slot samples a
+     // placeholder until it is resident. The slot stays valid until the asset is released; the cache
+     // may evict or trim the image in between and brings it back once vertices using it are drawn.
+     uint32_t requestTexture(const std::string& asset) {
+          std::lock_guard resources(resourceMutex_);
+          return textureCache_.acquire(asset);
+     }
+     void releaseTexture(const std::string& asset) {
+          std::lock_guard resources(resourceMutex_);
+          textureCache_.release(asset);
+     }
+     auto textureStats() {
+          std::lock_guard resources(resourceMutex_);
+          return textureCache_.stats();
+     }
+     void setTextureBudget(VkDeviceSize budget) {
+          std::lock_guard resources(resourceMutex_);
+          textureCache_.setBudget(budget);
      }
 
      void load(std::vector<Vertex> vertecies) {
+          std::lock_guard       resources(resourceMutex_);
+          std::vector<uint32_t> textures;
+          for (auto& vertex : vertecies)
+               if (std::find(textures.begin(), textures.end(), vertex.texture) == textures.end())
+                    textures.push_back(vertex.texture);
+          vertexTextures_.push_back(std::move(textures));
           vertexBuffers_.emplace_back(Buffer<Vertex>::makeVertex(core_, &device_, &commandPool_, vertecies));
      }
 
+     // Retained widgets, drawn above the loose vertex buffers and below layers.
+     WidgetTree& widgets() { return widgets_; }
+     // Animates widget motion, advanced by every publish().
+     Animator&   animator() { return animator_; }
+
+     // 2D shapes and images in window pixels, drawn above everything else.
+     DrawList& drawList() { return drawList_; }
+     auto      drawListStats() { return drawList_.stats(); }
+     // Fonts and glyphs for text drawn into the draw list.
+     Text&     text() { return text_; }
+     // Tessellated paths for the draw list, kept across frames.
+     PathCache& paths() { return paths_; }
+
+     // A layer caches a group of draws in an offscreen image, composited over the loose vertex buffers.
+     // Bounds are in window pixels. The renderer owns the layer; removing it defers its destruction
+     // until frames in flight no longer sample it. A layer is changed with lockResources() held.
+     Layer* createLayer(VkRect2D bounds, float scale = 1.f) {
+          std::lock_guard resources(resourceMutex_);
+          Layer::Formats  formats {
+               .color = colorbuffer_.format(),
+               .depth = depthbuffer_.format(),
+               .msaa  = colorbuffer_.msaa()
+          };
+          return layers_.emplace_back(std::make_unique<Layer>(core_, &device_, &commandPool_, &textureTable_, maxFramesInFlight_, formats, bounds, scale)).get();
+     }
+     void removeLayer(Layer* layer) {
+          std::lock_guard resources(resourceMutex_);
+          auto            it = std::find_if(layers_.begin(), layers_.end(), [layer](const auto& l) { return l.get() == layer; });
+          if (it == layers_.end())
+               return;
+          std::erase_if(layerCaptures_, [layer](const auto& capture) { return capture.first == layer; });
+          retiredLayers_.emplace_back(std::move(*it), maxFramesInFlight_ + 1);
+          layers_.erase(it);
+     }
+
+     // Copies the next presented frame to host memory; `callback` gets it on a worker thread and must
+     // not keep the pointer past returning. Waits for a free readback buffer rather than dropping.
+     void captureFrame(FrameCapture::Callback callback) {
+          if (!swapchain_.readable())
+               throw std::runtime_error("swapchain images cannot be read back on this surface");
+          std::lock_guard resources(resourceMutex_);
+          frameCaptures_.push_back(std::move(callback));
+     }
+     // Every presented frame until stopCapture(), for recording or monitoring. Frames are skipped
+     // while the callback is behind.
+     void startCapture(FrameCapture::Callback callback) {
+          if (!swapchain_.readable())
+               throw std::runtime_error("swapchain images cannot be read back on this surface");
+          std::lock_guard resources(resourceMutex_);
+          continuousCapture_ = std::move(callback);
+     }
+     void stopCapture() {
+          std::lock_guard resources(resourceMutex_);
+          continuousCapture_ = nullptr;
+     }
+     void captureLayer(Layer* layer, FrameCapture::Callback callback) {
+          std::lock_guard resources(resourceMutex_);
+          layerCaptures_.emplace_back(layer, std::move(callback));
+     }
+     auto capturedFrames() { return frameCapture_.captured(); }
+     auto droppedFrames() { return frameCapture_.dropped(); }
+
+     // The widgets, animator, draw list, text and paths belong to one thread, the one that changes
+     // the scene, which hands frames their content through publish(); they are never locked. Texture
+     // requests, layers and captures are shared with the thread that draws and guarded by this lock,
+     // which a frame holds while it prepares and records, never while it waits for the GPU, acquires
+     // or presents.
+     std::unique_lock<std::mutex> lockResources() { return std::unique_lock(resourceMutex_); }
+
+     // Frames follow from the next packet.
      void resize(int x, int y) {
-          std::unique_lock<std::mutex> swapchain_lock(swapchainMutex_);
           width_  = x;
           height_ = y;
-          if (width_ * height_ == 0)
-               return;
-          vkDeviceWaitIdle(device_.logical());
-          swapchain_.resize();
-          colorbuffer_.resize(iConf(swapchain_.extent()), { .aspect = VK_IMAGE_ASPECT_COLOR_BIT });
-          depthbuffer_.resize(dConf(swapchain_.extent()), { .aspect = VK_IMAGE_ASPECT_DEPTH_BIT });
-          renderProgram_.resize();
+          if (x * y != 0)
+               widgets_.resize({ static_cast<uint32_t>(x), static_cast<uint32_t>(y) });
      }
 
      int width() { return width_; }
      int height() { return height_; }
 
-     void tryDrawFrame() {
-          std::unique_lock<std::mutex> swapchain_lock(swapchainMutex_);
+     // Advances animations by `seconds` a publish() instead of by the time between them, so that a
+     // replay draws the same frames at any speed. 0 goes back to the clock.
+     void setFixedStep(double seconds) { fixedStep_ = seconds; }
+
+     // On the thread that changes the scene, after a batch of input and again whenever tookPacket()
+     // says a frame took the last packet, so animations keep moving. Advances animations and, if the
+     // last packet has been taken, hands what changed since it to the thread that draws: the widget
+     // runs and motion records rewritten, the draw list batched again, the glyphs rasterized. Returns
+     // whether it handed anything over. The frame takes it while this thread dispatches the next
+     // batch, neither waits for the other.
+     bool publish() {
+          auto now = std::chrono::steady_clock::now();
+          animator_.advance(fixedStep_ != 0. ? fixedStep_ : std::chrono::duration<double>(now - lastPublish_).count());
+          lastPublish_ = now;
           if (width_ * height_ == 0)
-               return;
+               return false;
+          {
+               std::lock_guard packets(packetMutex_);
+               if (pending_)
+                    return false;
+          }
+          auto& packet = *building_;
+          packet.clear();
+          packet.extent = { static_cast<uint32_t>(width_), static_cast<uint32_t>(height_) };
+          widgets_.publish(packet.widgets);
+          drawList_.publish(packet.list, packet.extent);
+          text_.publish(packet.glyphs);
+          if (packet.empty())
+               return false;
+          text_.prepare();
+          auto& widgetTextures = widgets_.textures();
+          auto& listTextures   = drawList_.textures();
+          packet.textures.insert(packet.textures.end(), widgetTextures.begin(), widgetTextures.end());
+          packet.textures.insert(packet.textures.end(), listTextures.begin(), listTextures.end());
+
+          std::lock_guard packets(packetMutex_);
+          pending_  = std::move(building_);
+          building_ = spare_ ? std::move(spare_) : std::make_unique<Packet>();
+          return true;
+     }
+
+     // Whether a frame took a packet since the last call, on the thread that draws.
+     bool tookPacket() { return took_.exchange(false); }
+
+     // Frames the GPU has finished since the last call, oldest first. On the thread that draws.
+     std::vector<FrameTimes> takeFrameTimes() { return std::exchange(frameTimes_, {}); }
+     // Waits for every submitted frame, so that takeFrameTimes() returns them all.
+     void waitIdle() {
+          vkDeviceWaitIdle(device_.logical());
+          for (size_t frame = 0; frame != maxFramesInFlight_; ++frame)
+               collectTimes(frame);
+     }
+
+     // Draws the latest packet, or the last one again when none is waiting. Returns false when
+     // nothing could be drawn, the window being minimized or the swapchain out of date.
+     bool tryDrawFrame() {
+          take();
+          if (extent_.width * extent_.height == 0)
+               return false;
+          if (extent_.width != requested_.width || extent_.height != requested_.height) {
+               vkDeviceWaitIdle(device_.logical());
+               swapchain_.resize(extent_);
+               colorbuffer_.resize(iConf(swapchain_.extent()), { .aspect = VK_IMAGE_ASPECT_COLOR_BIT });
+               depthbuffer_.resize(dConf(swapchain_.extent()), { .aspect = VK_IMAGE_ASPECT_DEPTH_BIT });
+               renderProgram_.resize();
+               requested_ = extent_;
+          }
 
           if (vkWaitForFences(device_.logical(), 1, &imageInFlight_[currentFrame_], VK_FALSE, 4000000000) != VK_SUCCESS)
                throw std::runtime_error("failed to wait for in flight fence");
+          frameCapture_.complete(currentFrame_);
+          collectTimes(currentFrame_);
 
-          uint32_t swapchainImageIndex;
-          if (vkAcquireNextImageKHR(device_.logical(), swapchain_.get(), 4000000000, imageAvailable_[currentFrame_], VK_NULL_HANDLE, &swapchainImageIndex) != VK_SUCCESS)
-               return;
+          auto swapchainImage = swapchain_.tryNextImageIndex(imageAvailable_[currentFrame_], VK_NULL_HANDLE);
+          if (!swapchainImage)
+               return false;
+          auto swapchainImageIndex = *swapchainImage;
+          auto cpuStart            = std::chrono::steady_clock::now();
 
           if (vkResetFences(device_.logical(), 1, &imageInFlight_[currentFrame_]) != VK_SUCCESS)
                throw std::runtime_error("call to vkResetFences failed");
           vkResetCommandBuffer(renderCommandBuffers_[currentFrame_].get(), {});
 
+          std::unique_lock resources(resourceMutex_);
+
+          for (auto& [layer, frames] : retiredLayers_)
+               --frames;
+          std::erase_if(retiredLayers_, [](const auto& retired) { return retired.second == 0; });
+
+          for (auto& textures : vertexTextures_)
+               for (auto slot : textures)
+                    textureCache_.use(slot);
+          for (auto& layer : layers_)
+               for (auto slot : layer->textures())
+                    textureCache_.use(slot);
+          textureTable_.setStorage(currentFrame_, widgetBuffers_.motions(currentFrame_));
+          for (auto slot : textures_)
+               textureCache_.use(slot);
+          textureCache_.collect();
+          textureStreamer_.pump();
+          std::vector<Layer*> staleLayers;
+          for (auto& layer : layers_)
+               if (layer->prepare(swapchain_.extent()))
+                    staleLayers.push_back(layer.get());
+          auto descriptorSet = textureTable_.flush(currentFrame_);
+
           renderCommandBuffers_[currentFrame_].begin();
           {
+               if (timestamps_ != VK_NULL_HANDLE) {
+                    vkCmdResetQueryPool(renderCommandBuffers_[currentFrame_].get(), timestamps_, static_cast<uint32_t>(2 * currentFrame_), 2);
+                    vkCmdWriteTimestamp(renderCommandBuffers_[currentFrame_].get(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestamps_, static_cast<uint32_t>(2 * currentFrame_));
+               }
+               text_.record(currentFrame_, &renderCommandBuffers_[currentFrame_]);
+               for (auto* layer : staleLayers)
+                    layer->record(&renderCommandBuffers_[currentFrame_], renderProgram_.pipeline(), renderProgram_.pipelineLayout(), descriptorSet);
+               std::erase_if(layerCaptures_, [this](auto& capture) {
+                    FrameCapture::Source source {
+                         .image  = capture.first->image(),
+                         .extent = capture.first->extent(),
+                         .format = capture.first->format(),
+                         .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                         .stage  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         .access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+                    };
+                    return frameCapture_.ready() && frameCapture_.record(&renderCommandBuffers_[currentFrame_], currentFrame_, source, capture.second);
+               });
                renderProgram_.beginRenderPass(swapchainImageIndex, &renderCommandBuffers_[currentFrame_]);
                {
                     vkCmdBindPipeline(renderCommandBuffers_[currentFrame_].get(), VK_PIPELINE_BIND_POINT_GRAPHICS, renderProgram_.pipeline());
@@ -144,53 +411,126 @@ class Renderer {
                     };
                     vkCmdSetViewport(renderCommandBuffers_[currentFrame_].get(), 0, 1, &viewport);
                     vkCmdSetScissor(renderCommandBuffers_[currentFrame_].get(), 0, 1, &scissor);
+                    vkCmdBindDescriptorSets(renderCommandBuffers_[currentFrame_].get(), VK_PIPELINE_BIND_POINT_GRAPHICS, renderProgram_.pipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
 
                     for (auto& vertexBuffer : vertexBuffers_) {
                          VkBuffer     vertexBuffers[]     = { vertexBuffer.get() };
                          VkDeviceSize deviceSizeOffsets[] = { 0 };
                          vkCmdBindVertexBuffers(renderCommandBuffers_[currentFrame_].get(), 0, 1, vertexBuffers, deviceSizeOffsets);
-                         vkCmdBindDescriptorSets(renderCommandBuffers_[currentFrame_].get(), VK_PIPELINE_BIND_POINT_GRAPHICS, renderProgram_.pipelineLayout(), 0, 1, &descriptorSets_[currentFrame_], 0, nullptr);
                          vkCmdDraw(renderCommandBuffers_[currentFrame_].get(), 4, 1, 0, 0);
                     }
+                    vkCmdBindPipeline(renderCommandBuffers_[currentFrame_].get(), VK_PIPELINE_BIND_POINT_GRAPHICS, renderProgram_.widgetPipeline());
+                    widgetBuffers_.record(currentFrame_, &renderCommandBuffers_[currentFrame_]);
+                    vkCmdBindPipeline(renderCommandBuffers_[currentFrame_].get(), VK_PIPELINE_BIND_POINT_GRAPHICS, renderProgram_.pipeline());
+                    for (auto& layer : layers_)
+                         layer->draw(&renderCommandBuffers_[currentFrame_]);
+                    std::array<VkPipeline, DrawList::PIPELINES> listPipelines { renderProgram_.shapesPipeline(), renderProgram_.textPipeline() };
+                    drawListBuffers_.record(currentFrame_, &renderCommandBuffers_[currentFrame_], listPipelines);
                }
                renderProgram_.endRenderPass(&renderCommandBuffers_[currentFrame_]);
+
+               if (!frameCaptures_.empty() || continuousCapture_) {
+                    FrameCapture::Source source {
+                         .image  = swapchain_.images()[swapchainImageIndex],
+                         .extent = swapchain_.extent(),
+                         .format = swapchain_.format(),
+                         .layout = swapchain_.finalLayout(),
+                         .stage  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         .access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+                    };
+                    if (!frameCaptures_.empty()) {
+                         if (frameCapture_.ready() && frameCapture_.record(&renderCommandBuffers_[currentFrame_], currentFrame_, source, frameCaptures_.front()))
+                              frameCaptures_.erase(frameCaptures_.begin());
+                    }
+                    else
+                         frameCapture_.record(&renderCommandBuffers_[currentFrame_], currentFrame_, source, continuousCapture_);
+               }
+               if (timestamps_ != VK_NULL_HANDLE)
+                    vkCmdWriteTimestamp(renderCommandBuffers_[currentFrame_].get(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestamps_, static_cast<uint32_t>(2 * currentFrame_ + 1));
           }
           renderCommandBuffers_[currentFrame_].end();
+          resources.unlock();
 
           VkPipelineStageFlags pipeline_stage_flags { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 
+          // offscreen images are not acquired or presented, so there is nothing to wait on or signal
+          uint32_t     semaphores = swapchain_.offscreen() ? 0 : 1;
           VkSubmitInfo submit_info {
                .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
                .pNext                = nullptr,
-               .waitSemaphoreCount   = 1,
+               .waitSemaphoreCount   = semaphores,
                .pWaitSemaphores      = &imageAvailable_[currentFrame_],
                .pWaitDstStageMask    = &pipeline_stage_flags,
                .commandBufferCount   = 1,
                .pCommandBuffers      = &renderCommandBuffers_[currentFrame_].get(),
-               .signalSemaphoreCount = 1,
+               .signalSemaphoreCount = semaphores,
                .pSignalSemaphores    = &renderFinished_[currentFrame_]
           };
 
           if (vkQueueSubmit(device_.graphics(), 1, &submit_info, imageInFlight_[currentFrame_]) != VK_SUCCESS)
                throw std::runtime_error("call to vkQueueSubmit failed");
-
-          VkPresentInfoKHR present_info {
-               .sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-               .pNext              = nullptr,
-               .waitSemaphoreCount = 1,
-               .pWaitSemaphores    = &renderFinished_[currentFrame_],
-               .swapchainCount     = 1,
-               .pSwapchains        = &swapchain_.get(),
-               .pImageIndices      = &swapchainImageIndex,
-               .pResults           = nullptr
+          submittedTimes_[currentFrame_] = FrameTimes {
+               .frame = frameNumber_++,
+               .cpu   = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cpuStart).count(),
+               .gpu   = 0.
           };
-          vkQueuePresentKHR(device_.present(), &present_info);
+
+          if (!swapchain_.offscreen()) {
+               VkPresentInfoKHR present_info {
+                    .sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+                    .pNext              = nullptr,
+                    .waitSemaphoreCount = 1,
+                    .pWaitSemaphores    = &renderFinished_[currentFrame_],
+                    .swapchainCount     = 1,
+                    .pSwapchains        = &swapchain_.get(),
+                    .pImageIndices      = &swapchainImageIndex,
+                    .pResults           = nullptr
+               };
+               vkQueuePresentKHR(device_.present(), &present_info);
+          }
 
           currentFrame_ = (1 + currentFrame_) % maxFramesInFlight_;
+          return true;
      }
 
   private:
+     // Takes in the packet waiting, if any, and hands it back empty for reuse.
+     void take() {
+          std::unique_ptr<Packet> packet;
+          {
+               std::lock_guard packets(packetMutex_);
+               packet = std::move(pending_);
+          }
+          if (!packet)
+               return;
+          extent_ = packet->extent;
+          widgetBuffers_.apply(packet->widgets);
+          drawListBuffers_.apply(packet->list);
+          text_.apply(packet->glyphs);
+          std::swap(textures_, packet->textures);
+          {
+               std::lock_guard packets(packetMutex_);
+               spare_ = std::move(packet);
+          }
+          took_ = true;
+     }
+
+     // Once the frame's fence has been waited on.
+     void collectTimes(size_t frame) {
+          auto& times = submittedTimes_[frame];
+          if (!times)
+               return;
+          if (timestamps_ != VK_NULL_HANDLE) {
+               uint64_t ticks[2] {};
+               if (vkGetQueryPoolResults(device_.logical(), timestamps_, static_cast<uint32_t>(2 * frame), 2, sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+                    times->gpu = static_cast<double>(ticks[1] - ticks[0]) * timestampPeriod_ / 1e6;
+          }
+          frameTimes_.push_back(*times);
+          times.reset();
+     }
+
      const size_t        maxFramesInFlight_ { 2 };
+     const uint32_t      maxTextures_ { 16384 };
      Core*               core_;
      Device              device_;
      CommandPool         commandPool_;
@@ -202,19 +542,57 @@ class Renderer {
      ImageResource2D colorbuffer_;
      ImageResource2D depthbuffer_;
 
-     Texture        texture_;
-     RenderProgram renderProgram_;
+     RenderProgram   renderProgram_;
+     TextureTable    textureTable_;
+     TextureStreamer textureStreamer_;
+     TextureCache    textureCache_;
+     FrameCapture    frameCapture_;
+     WidgetTree      widgets_;
+     WidgetBuffers   widgetBuffers_;
+     Animator        animator_;
+     DrawList        drawList_;
+     DrawListBuffers drawListBuffers_;
+     Text            text_;
+     PathCache       paths_;
 
-     std::vector<VkDescriptorSet> descriptorSets_;
      std::vector<Buffer<Vertex>>  vertexBuffers_;
+     std::vector<std::vector<uint32_t>> vertexTextures_;
+
+     std::vector<std::unique_ptr<Layer>>                     layers_;
+     std::vector<std::pair<std::unique_ptr<Layer>, size_t>> retiredLayers_;
+
+     std::vector<FrameCapture::Callback>                   frameCaptures_;
+     FrameCapture::Callback                                continuousCapture_;
+     std::vector<std::pair<Layer*, FrameCapture::Callback>> layerCaptures_;
 
 
      std::vector<VkSemaphore> imageAvailable_ { 2 };
      std::vector<VkSemaphore> renderFinished_ { 2 };
      std::vector<VkFence>     imageInFlight_ { 2 };
 
-     int        width_;
-     int        height_;
-     size_t     currentFrame_ { 0 };
-     std::mutex swapchainMutex_;
+     // on the thread that changes the scene
+     int                                   width_;
+     int                                   height_;
+     std::chrono::steady_clock::time_point lastPublish_ { std::chrono::steady_clock::now() };
+     double                                fixedStep_ { 0. };
+     std::unique_ptr<Packet>               building_ { std::make_unique<Packet>() };
+
+     // handed over
+     std::unique_ptr<Packet> pending_;
+     std::unique_ptr<Packet> spare_;
+     std::mutex              packetMutex_;
+     std::atomic<bool>       took_ { false };
+     std::mutex              resourceMutex_;
+
+     // on the thread that draws
+     VkExtent2D            extent_;    // of the last packet taken
+     VkExtent2D            requested_; // the swapchain was last made for
+     std::vector<uint32_t> textures_;
+     size_t                currentFrame_ { 0 };
+
+     VkQueryPool                            timestamps_ { VK_NULL_HANDLE };
+     float                                  timestampPeriod_ { 0.f };
+     uint64_t                               frameNumber_ { 0 };
+     std::vector<std::optional<FrameTimes>> submittedTimes_ { 2 };
+     std::vector<FrameTimes>                frameTimes_;
 };
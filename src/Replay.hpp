@@ -0,0 +1,101 @@
+#pragma once
+
+#include "EventSystem.hpp"
+#include "InputLog.hpp"
+#include "Renderer.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Plays a recorded session into an event system and draws a frame after every step of a 60 Hz
+// clock, handing over the events recorded up to that step. Paced by the wall clock it runs as the
+// session did; unpaced it draws as fast as it can. Animations advance by the same fixed step either
+// way, so both draw the same frames and a replay is a benchmark that can be rerun.
+class Replay {
+  public:
+     static constexpr double STEP = 1. / 60.; // seconds
+
+     struct Percentiles {
+          double p50;
+          double p90;
+          double p99;
+          double max;
+     };
+     struct Report {
+          size_t      frames;
+          size_t      events;
+          double      seconds; // wall clock
+          Percentiles cpu;     // milliseconds
+          Percentiles gpu;
+
+          void print() const {
+               fmt::print("{} frames, {} events in {:.2f} s\n", frames, events, seconds);
+               fmt::print("{:>4} {:>9} {:>9} {:>9} {:>9}\n", "ms", "p50", "p90", "p99", "max");
+               fmt::print("{:>4} {:9.3f} {:9.3f} {:9.3f} {:9.3f}\n", "cpu", cpu.p50, cpu.p90, cpu.p99, cpu.max);
+               fmt::print("{:>4} {:9.3f} {:9.3f} {:9.3f} {:9.3f}\n", "gpu", gpu.p50, gpu.p90, gpu.p99, gpu.max);
+          }
+     };
+
+     Replay(EventSystem* events, Renderer* renderer)
+        : events_(events)
+        , renderer_(renderer) {}
+
+     Report run(const InputLog& log, bool paced) {
+          auto events = log.events();
+          renderer_->setFixedStep(STEP);
+          std::vector<Renderer::FrameTimes> times;
+          size_t                            next { 0 };
+          auto                              start = std::chrono::steady_clock::now();
+          for (uint64_t step = 0; next != events.size(); ++step) {
+               auto until = static_cast<uint32_t>(static_cast<double>(step) * STEP * 1000.);
+               while (next != events.size() && events[next].time <= until) {
+                    // a step holding more than the queue does is handed over in parts
+                    if (!events_->queue.tryPush(events[next]))
+                         events_->dispatch();
+                    else
+                         ++next;
+               }
+               // as a window's interaction thread does, then its render thread
+               events_->dispatch();
+               renderer_->publish();
+               if (paced)
+                    std::this_thread::sleep_until(start + std::chrono::duration<double>(static_cast<double>(step) * STEP));
+               renderer_->tryDrawFrame();
+               auto finished = renderer_->takeFrameTimes();
+               times.insert(times.end(), finished.begin(), finished.end());
+          }
+          renderer_->waitIdle();
+          auto finished = renderer_->takeFrameTimes();
+          times.insert(times.end(), finished.begin(), finished.end());
+          renderer_->setFixedStep(0.);
+
+          std::vector<double> cpu, gpu;
+          for (auto& frame : times) {
+               cpu.push_back(frame.cpu);
+               gpu.push_back(frame.gpu);
+          }
+          return {
+               .frames  = times.size(),
+               .events  = events.size(),
+               .seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+               .cpu     = percentiles(cpu),
+               .gpu     = percentiles(gpu)
+          };
+     }
+
+  private:
+     static Percentiles percentiles(std::vector<double> values) {
+          if (values.empty())
+               return {};
+          std::sort(values.begin(), values.end());
+          auto rank = [&](double p) { return values[static_cast<size_t>(p * static_cast<double>(values.size() - 1) + .5)]; };
+          return { .p50 = rank(.5), .p90 = rank(.9), .p99 = rank(.99), .max = values.back() };
+     }
+
+     EventSystem* events_;
+     Renderer*    renderer_;
+};
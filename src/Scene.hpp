@@ -0,0 +1,160 @@
+#pragma once
+
+#include "EventSystem.hpp"
+#include "Renderer.hpp"
+#include "VirtualList.hpp"
+
+#include <fmt/xchar.h>
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <string>
+
+// What a window shows and how it answers input: a title, a chart and a table of a million rows, and
+// widgets added with a left click, removed with a right one and highlighted under the pointer. It
+// only needs an event system and a renderer, so a window draws it on screen and a replay offscreen.
+// Listeners change the renderer's scene, whoever dispatches must be the thread that publishes it.
+class Scene {
+  public:
+     Scene(const wchar_t* name, EventSystem* events, Renderer* renderer)
+        : name_(name)
+        , renderer_(renderer)
+        , font_(renderer_->text().addFont(L"Segoe UI"))
+        , table_(&renderer_->text(), tableProvider(), { .font = font_ })
+        , chart_(chartPath()) {
+          table_.setColumns({ 90.f, 140.f, 110.f });
+          placeTable(static_cast<int>(renderer_->width()), static_cast<int>(renderer_->height()));
+          redraw();
+          onResize_    = events->bus.subscribe<EventSystem::Resize>([this](std::span<const EventSystem::Resize> resizes) {
+               auto [x, y] = resizes.back();
+               renderer_->resize(x, y);
+               placeTable(x, y);
+               redraw();
+          });
+          onClick_     = events->bus.subscribe<EventSystem::Click>([this](std::span<const EventSystem::Click> clicks) {
+               // the window reports both press and release, a click acts on the press
+               for (auto [button, x, y, down] : clicks)
+                    if (down)
+                         click(button, x, y);
+          });
+          onMouseMove_ = events->bus.subscribe<EventSystem::MouseMove>([this](std::span<const EventSystem::MouseMove> moves) {
+               // only where the pointer ended up matters for hovering
+               hover(moves.back().x, moves.back().y);
+          });
+          onWheel_     = events->bus.subscribe<EventSystem::Wheel>([this](std::span<const EventSystem::Wheel> wheels) {
+               int delta { 0 };
+               for (auto wheel : wheels)
+                    delta += wheel.delta;
+               table_.scroll({ 0.f, -static_cast<float>(delta) / 2.f });
+               redraw();
+          });
+     }
+     Scene(const Scene&)            = delete;
+     Scene(Scene&&)                 = delete;
+     Scene& operator=(const Scene&) = delete;
+     Scene& operator=(Scene&&)      = delete;
+
+     void click(EventSystem::MouseButton button, int x, int y) {
+          auto& widgets = renderer_->widgets();
+          if (auto row = table_.rowAt({ static_cast<float>(x), static_cast<float>(y) }); row != VirtualList::NONE) {
+               table_.select(row);
+               redraw();
+          }
+          else if (button == EventSystem::MouseButton::LEFT) {
+               glm::vec2 size { .1f * static_cast<float>(renderer_->width()), .1f * static_cast<float>(renderer_->height()) };
+               glm::vec2 position { static_cast<float>(x), static_cast<float>(y) };
+               auto  id       = widgets.create(widgets.root(), position - size / 2.f, size, { 1.f, 1.f, 1.f }, 0);
+               auto& animator = renderer_->animator();
+               animator.set(id, Animator::Property::OPACITY, 0.f);
+               animator.transition(id, Animator::Property::OPACITY, 1.f, .25f);
+               animator.set(id, Animator::Property::SCALE_X, .6f);
+               animator.set(id, Animator::Property::SCALE_Y, .6f);
+               animator.spring(id, Animator::Property::SCALE_X, 1.f);
+               animator.spring(id, Animator::Property::SCALE_Y, 1.f);
+          }
+          else if (button == EventSystem::MouseButton::RIGHT) {
+               auto id = widgets.hit({ static_cast<float>(x), static_cast<float>(y) });
+               if (id == hovered_)
+                    hovered_ = widgets.root();
+               renderer_->animator().forget(id);
+               widgets.destroy(id);
+          }
+     }
+
+     void hover(int x, int y) {
+          auto& widgets = renderer_->widgets();
+          auto  id      = widgets.hit({ static_cast<float>(x), static_cast<float>(y) });
+          if (id == hovered_)
+               return;
+          // the highlight is a tint and a scale in the motion record, the geometry stays as it is
+          auto& animator  = renderer_->animator();
+          auto  highlight = [&](WidgetTree::Id widget, bool on) {
+               animator.spring(widget, Animator::Property::SCALE_X, on ? 1.06f : 1.f);
+               animator.spring(widget, Animator::Property::SCALE_Y, on ? 1.06f : 1.f);
+               animator.transition(widget, Animator::Property::GREEN, on ? .8f : 1.f, .15f);
+               animator.transition(widget, Animator::Property::BLUE, on ? .8f : 1.f, .15f);
+          };
+          if (hovered_ != widgets.root())
+               highlight(hovered_, false);
+          if (id != widgets.root())
+               highlight(id, true);
+          hovered_ = id;
+     }
+
+  private:
+     // A million rows of generated data, only the visible ones are ever asked for.
+     static VirtualList::Provider tableProvider() {
+          return {
+               .rows   = [] { return size_t { 1'000'000 }; },
+               .cell   = [](size_t row, size_t column, std::wstring& text) {
+                    if (column == 0)
+                         fmt::format_to(std::back_inserter(text), L"{}", row);
+                    else if (column == 1)
+                         fmt::format_to(std::back_inserter(text), L"Item {}", row * 7919 % 1'000'003);
+                    else
+                         fmt::format_to(std::back_inserter(text), L"{:08x}", static_cast<uint32_t>(row * 2654435761u));
+               },
+               .height = [](size_t row) { return row % 10 == 0 ? 28.f : 20.f; }
+          };
+     }
+
+     // A smooth line through a few hundred samples, in a 300 by 80 box.
+     static Path chartPath() {
+          Path path;
+          auto sample = [](int i) { return glm::vec2 { static_cast<float>(i) * 1.5f, 40.f - 25.f * std::sin(static_cast<float>(i) * .07f) * std::cos(static_cast<float>(i) * .013f) }; };
+          path.moveTo(sample(0));
+          for (int i = 1; i <= 200; ++i) {
+               auto p0 = sample(i - 1), p1 = sample(i);
+               path.cubicTo(p0 + glm::vec2 { .5f, 0.f }, p1 - glm::vec2 { .5f, 0.f }, p1);
+          }
+          return path;
+     }
+
+     void placeTable(int width, int height) {
+          table_.setViewport({ static_cast<float>(width) - 360.f, 44.f }, { 340.f, std::max(0.f, static_cast<float>(height) - 60.f) });
+     }
+
+     // The draw list is rebuilt whole whenever the table scrolls or changes.
+     void redraw() {
+          auto& list = renderer_->drawList();
+          list.clear();
+          renderer_->text().draw(list, name_, font_, 20.f, { 12.f, 8.f }, DrawList::rgba(230, 230, 230));
+          auto& paths = renderer_->paths();
+          list.path(paths.stroke(chart_, 1.f, { .width = 2.f, .join = Stroke::Join::ROUND, .cap = Stroke::Cap::ROUND }), { 12.f, 44.f }, 1.f, DrawList::rgba(90, 160, 230));
+          table_.draw(list);
+     }
+
+     std::wstring name_;
+     Renderer*    renderer_;
+     Text::Font   font_;
+     VirtualList  table_;
+     Path         chart_;
+
+     WidgetTree::Id hovered_ { 0 };
+
+     EventSystem::Subscription<EventSystem::Click>     onClick_;
+     EventSystem::Subscription<EventSystem::Resize>    onResize_;
+     EventSystem::Subscription<EventSystem::MouseMove> onMouseMove_;
+     EventSystem::Subscription<EventSystem::Wheel>     onWheel_;
+};
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "Vertex.hpp"
+
+#include <glm/glm.hpp>
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Engine scene container (.cscn): a widget tree as the GPU and the tree itself hold it.
+//
+//   Header | Node[nodeCount] | String[textureCount] | vertices | strings
+//
+// Every section starts 16 byte aligned, fields are little endian and references between records are
+// indices or pool offsets, so a mapped file is used in place. Nodes are in depth first order, a
+// parent before its children. The vertex section is the widget stream of the saved tree, ready for
+// a vertex buffer; its texture fields index the texture table, which names each texture once, and
+// are pointed at slots when loaded. Names and texture names share the string pool.
+class SceneFile {
+     static_assert(std::endian::native == std::endian::little, "scene files are little endian");
+
+  public:
+     static constexpr uint32_t magic   = 0x4E435343; // "CSCN"
+     static constexpr uint32_t version = 1;
+     static constexpr uint32_t NONE    = ~0u;
+
+     enum Flags : uint32_t {
+          FLAG_VISIBLE = 1,
+          FLAG_SHOWN   = 2
+     };
+
+     struct String {
+          uint32_t offset;
+          uint32_t size;
+     };
+
+     struct Header {
+          uint32_t magic;
+          uint32_t version;
+          uint32_t nodeCount;
+          uint32_t textureCount;
+          uint32_t vertexCount;
+          uint32_t width; // window the vertices were written for
+          uint32_t height;
+          uint32_t stringsSize;
+          uint64_t nodesOffset;
+          uint64_t texturesOffset;
+          uint64_t verticesOffset;
+          uint64_t stringsOffset;
+     };
+
+     // Links are node indices, NONE for none; top level nodes have no parent.
+     struct Node {
+          uint32_t  parent;
+          uint32_t  firstChild;
+          uint32_t  next;
+          uint32_t  previous;
+          glm::vec2 position;
+          glm::vec2 size;
+          glm::vec3 color;
+          uint32_t  texture; // texture table index
+          glm::vec2 absolute;
+          uint32_t  depth;
+          uint32_t  flags;
+          String    name;
+     };
+     // nodes and vertices are used in place, so their layout is the file format
+     static_assert(std::is_trivially_copyable_v<Node> && sizeof(Node) == 72, "scene file node layout changed");
+     static_assert(offsetof(Node, color) == 32 && offsetof(Node, absolute) == 48 && offsetof(Node, name) == 64, "scene file node layout changed");
+     static_assert(std::is_trivially_copyable_v<Vertex> && sizeof(Vertex) == 36, "scene file vertex layout changed");
+     static_assert(offsetof(Vertex, color) == 12 && offsetof(Vertex, textureCoordinate) == 24 && offsetof(Vertex, texture) == 32, "scene file vertex layout changed");
+
+     // What write() stores, the vertices already pointing at texture table indices.
+     struct Contents {
+          uint32_t            width;
+          uint32_t            height;
+          std::vector<Node>   nodes;
+          std::vector<String> textures;
+          std::vector<Vertex> vertices;
+          std::vector<char>   strings;
+
+          String add(std::string_view string) {
+               String entry { static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(string.size()) };
+               strings.insert(strings.end(), string.begin(), string.end());
+               return entry;
+          }
+     };
+
+     static void write(const std::string& path, const Contents& contents) {
+          Header header {
+               .magic          = magic,
+               .version        = version,
+               .nodeCount      = static_cast<uint32_t>(contents.nodes.size()),
+               .textureCount   = static_cast<uint32_t>(contents.textures.size()),
+               .vertexCount    = static_cast<uint32_t>(contents.vertices.size()),
+               .width          = contents.width,
+               .height         = contents.height,
+               .stringsSize    = static_cast<uint32_t>(contents.strings.size()),
+               .nodesOffset    = align(sizeof(Header)),
+               .texturesOffset = 0,
+               .verticesOffset = 0,
+               .stringsOffset  = 0
+          };
+          header.texturesOffset = align(header.nodesOffset + sizeof(Node) * contents.nodes.size());
+          header.verticesOffset = align(header.texturesOffset + sizeof(String) * contents.textures.size());
+          header.stringsOffset  = align(header.verticesOffset + sizeof(Vertex) * contents.vertices.size());
+
+          std::ofstream file(path, std::ios::binary | std::ios::trunc);
+          if (!file)
+               throw std::runtime_error("failed to open " + path + " for writing");
+          uint64_t written { 0 };
+          auto     section = [&](uint64_t offset, const void* data, size_t size) {
+               static constexpr char zeros[16] {};
+               file.write(zeros, static_cast<std::streamsize>(offset - written));
+               file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+               written = offset + size;
+          };
+          section(0, &header, sizeof(header));
+          section(header.nodesOffset, contents.nodes.data(), sizeof(Node) * contents.nodes.size());
+          section(header.texturesOffset, contents.textures.data(), sizeof(String) * contents.textures.size());
+          section(header.verticesOffset, contents.vertices.data(), sizeof(Vertex) * contents.vertices.size());
+          section(header.stringsOffset, contents.strings.data(), contents.strings.size());
+          if (!file)
+               throw std::runtime_error("failed to write " + path);
+     }
+
+     // Only the header and the pool bounds are checked; the sections are read where they are mapped.
+     SceneFile(const std::string& path)
+        : file_(path) {
+          auto bytes = file_.bytes();
+          if (bytes.size() < sizeof(Header))
+               throw std::runtime_error(path + " is not a scene file");
+          std::memcpy(&header_, bytes.data(), sizeof(Header));
+          if (header_.magic != magic || header_.version != version)
+               throw std::runtime_error(path + " is not a scene file of version " + std::to_string(version));
+          auto fits = [&](uint64_t offset, uint64_t size) { return offset % 16 == 0 && offset <= bytes.size() && size <= bytes.size() - offset; };
+          if (!fits(header_.nodesOffset, sizeof(Node) * uint64_t { header_.nodeCount }) || !fits(header_.texturesOffset, sizeof(String) * uint64_t { header_.textureCount })
+              || !fits(header_.verticesOffset, sizeof(Vertex) * uint64_t { header_.vertexCount }) || !fits(header_.stringsOffset, header_.stringsSize))
+               throw std::runtime_error(path + " is truncated or corrupt");
+          for (auto& texture : textures())
+               if (texture.offset > header_.stringsSize || texture.size > header_.stringsSize - texture.offset)
+                    throw std::runtime_error(path + " is truncated or corrupt");
+     }
+
+     std::span<const Node>   nodes() const { return { reinterpret_cast<const Node*>(file_.data() + header_.nodesOffset), header_.nodeCount }; }
+     std::span<const String> textures() const { return { reinterpret_cast<const String*>(file_.data() + header_.texturesOffset), header_.textureCount }; }
+     std::span<const Vertex> vertices() const { return { reinterpret_cast<const Vertex*>(file_.data() + header_.verticesOffset), header_.vertexCount }; }
+     uint32_t                width() const { return header_.width; }
+     uint32_t                height() const { return header_.height; }
+
+     std::string_view string(String string) const {
+          if (string.offset > header_.stringsSize || string.size > header_.stringsSize - string.offset)
+               return {};
+          return { reinterpret_cast<const char*>(file_.data() + header_.stringsOffset + string.offset), string.size };
+     }
+
+     // Index of the first node called `name`, or NONE.
+     uint32_t find(std::string_view name) const {
+          auto all = nodes();
+          for (uint32_t i = 0; i != all.size(); ++i)
+               if (all[i].name.size == name.size() && string(all[i].name) == name)
+                    return i;
+          return NONE;
+     }
+
+  private:
+     static uint64_t align(uint64_t size) { return (size + 15) & ~uint64_t { 15 }; }
+
+     MappedFile file_;
+     Header     header_ {};
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "CommandPool.hpp"
+#include "Core.hpp"
+#include "Device.hpp"
+
+#include <deque>
+#include <mutex>
+
+// One persistently mapped upload buffer handed out as a ring. Decode jobs allocate from any thread and
+// write their pixels straight into it; the render thread releases a range once the copy out of it has
+// completed. Releases may come out of order, the ring only reclaims space up to the oldest live range.
+class StagingArena {
+     struct Range {
+          VkDeviceSize offset;
+          VkDeviceSize size;
+          bool         released;
+     };
+
+  public:
+     struct Allocation {
+          VkDeviceSize offset;
+          VkDeviceSize size;
+          uint8_t*     data;
+
+          explicit operator bool() const { return data != nullptr; }
+     };
+
+     StagingArena(Core* core, Device* device, CommandPool* commandPool, VkDeviceSize capacity = 64 << 20)
+        : capacity_(capacity)
+        , buffer_(Buffer<uint8_t>::makeUpload(core, device, commandPool, capacity))
+        , mapped_(buffer_.map()) {}
+     ~StagingArena() { buffer_.unmap(); }
+     StagingArena(const StagingArena&)            = delete;
+     StagingArena(StagingArena&&)                 = delete;
+     StagingArena& operator=(const StagingArena&) = delete;
+     StagingArena& operator=(StagingArena&&)      = delete;
+
+     // Returns an empty allocation instead of waiting when the ring has no room, callers fall back to
+     // memory of their own.
+     Allocation allocate(VkDeviceSize size) {
+          size = (size + 15) & ~VkDeviceSize { 15 };
+          std::unique_lock lock(mutex_);
+          if (live_.empty())
+               head_ = 0;
+          VkDeviceSize offset;
+          VkDeviceSize tail = live_.empty() ? 0 : live_.front().offset;
+          if (live_.empty() || head_ > tail) {
+               if (capacity_ - head_ >= size)
+                    offset = head_;
+               else if (tail >= size)
+                    offset = 0;
+               else
+                    return { 0, 0, nullptr };
+          }
+          else if (tail - head_ >= size)
+               offset = head_;
+          else
+               return { 0, 0, nullptr };
+          head_ = offset + size;
+          live_.push_back({ offset, size, false });
+          return { offset, size, mapped_ + offset };
+     }
+
+     void release(const Allocation& allocation) {
+          std::unique_lock lock(mutex_);
+          for (auto& range : live_)
+               if (range.offset == allocation.offset && !range.released) {
+                    range.released = true;
+                    break;
+               }
+          while (!live_.empty() && live_.front().released)
+               live_.pop_front();
+     }
+
+     VkBuffer buffer() { return buffer_.get(); }
+
+  private:
+     VkDeviceSize      capacity_;
+     Buffer<uint8_t>   buffer_;
+     uint8_t*          mapped_;
+     std::mutex        mutex_;
+     VkDeviceSize      head_ { 0 };
+     std::deque<Range> live_;
+};
@@ -2,14 +2,27 @@
 
 #include "Core.hpp"
 #include "Device.hpp"
-#include "Surface.hpp"
+#include "ImageResource2D.hpp"
 
+#include <memory>
 #include <optional>
 #include <vector>
 
+// Without a surface (VK_NULL_HANDLE) the images are plain offscreen images, taken in turn and never
+// presented, for drawing headless; they can always be read back. The surface is only a handle here,
+// so drawing offscreen needs nothing of the window system.
 class Swapchain {
   public:
+     // one per frame in flight, so taking them in turn never reuses one a frame still draws to
+     static constexpr uint32_t OFFSCREEN_IMAGES = 2;
+
+     // Offscreen, the semaphore and fence are left alone.
      std::optional<uint32_t> tryNextImageIndex(VkSemaphore semaphore, VkFence fence) {
+          if (offscreen()) {
+               auto index = nextImage_;
+               nextImage_ = (nextImage_ + 1) % imageCount_;
+               return index;
+          }
           uint32_t index {};
           if (vkAcquireNextImageKHR(device_->logical(), swapchain_, 4000000000, semaphore, fence, &index) == VK_SUCCESS)
                return index;
@@ -33,15 +46,27 @@ class Swapchain {
      auto format() { return swapchainFormat_; }
      auto imageCount() { return imageCount_; }
      auto imageViews() { return swapchainImageViews_; }
+     auto images() { return swapchainImages_; }
+     // Whether images can be copied out of, for captures.
+     bool readable() { return imageUsage_ & VK_IMAGE_USAGE_TRANSFER_SRC_BIT; }
      auto& get() { return swapchain_; }
-     void resize() {
+     bool  offscreen() { return surface_ == VK_NULL_HANDLE; }
+     // The layout a frame leaves its image in: ready to present, or offscreen ready to copy out of.
+     VkImageLayout finalLayout() { return offscreen() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; }
+     // A surface's images take its current extent, offscreen ones `extent`.
+     void resize(VkExtent2D extent) {
+          if (offscreen()) {
+               swapchainExtent_ = extent;
+               createOffscreenImages();
+               return;
+          }
           for (auto& image_view : swapchainImageViews_)
                vkDestroyImageView(device_->logical(), image_view, core_->allocator());
           swapchainImageViews_.clear();
           vkDestroySwapchainKHR(device_->logical(), swapchain_, core_->allocator());
 
           VkSurfaceCapabilitiesKHR surfaceCapabilities;
-          if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device_->physical(), surface_->surfaceKHR(), &surfaceCapabilities) != VK_SUCCESS)
+          if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device_->physical(), surface_, &surfaceCapabilities) != VK_SUCCESS)
                throw std::runtime_error("call to vkGetPhysicalDeviceSurfaceCapabilitiesKHR failed");
 
           swapchainExtent_ = surfaceCapabilities.currentExtent;
@@ -50,12 +75,17 @@ class Swapchain {
           initializeSwapchainImages();
           createImageViews();
      }
-     Swapchain(Core* core, Surface* surface, Device* device)
+     Swapchain(Core* core, VkSurfaceKHR surface, Device* device, VkExtent2D extent = {})
         : core_(core)
         , surface_(surface)
         , device_(device) {
+          if (offscreen()) {
+               swapchainExtent_ = extent;
+               createOffscreenImages();
+               return;
+          }
           VkSurfaceCapabilitiesKHR surfaceCapabilities;
-          if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device_->physical(), surface_->surfaceKHR(), &surfaceCapabilities) != VK_SUCCESS)
+          if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device_->physical(), surface_, &surfaceCapabilities) != VK_SUCCESS)
                throw std::runtime_error("call to vkGetPhysicalDeviceSurfaceCapabilitiesKHR failed");
           fmt::print("capabilities.currentExtent: {}, {}\n", surfaceCapabilities.currentExtent.width, surfaceCapabilities.currentExtent.height);
           
@@ -66,6 +96,8 @@ class Swapchain {
           fmt::print("Swapchain image count: {}\n", imageCount_);
      }
      ~Swapchain() {
+          if (offscreen())
+               return;
           for (auto& image_view : swapchainImageViews_)
                vkDestroyImageView(device_->logical(), image_view, core_->allocator());
           swapchainImageViews_.clear();
@@ -84,17 +116,19 @@ class Swapchain {
           else
                imageCount = surfaceCapabilities.maxImageCount;
 
+          imageUsage_ = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | (surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+
           VkSwapchainCreateInfoKHR swapchainCreateInfo {
                .sType                 = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
                .pNext                 = nullptr,
                .flags                 = {},
-               .surface               = surface_->surfaceKHR(),
+               .surface               = surface_,
                .minImageCount         = imageCount,
                .imageFormat           = swapchainFormat_,
                .imageColorSpace       = VK_COLORSPACE_SRGB_NONLINEAR_KHR,
                .imageExtent           = swapchainExtent_,
                .imageArrayLayers      = 1,
-               .imageUsage            = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+               .imageUsage            = imageUsage_,
                .imageSharingMode      = VK_SHARING_MODE_EXCLUSIVE,
                .queueFamilyIndexCount = 1,
                .pQueueFamilyIndices   = &comboQueueIndex,
@@ -142,20 +176,47 @@ class Swapchain {
           return imageView;
      }
 
+     void createOffscreenImages() {
+          offscreenImages_.clear();
+          swapchainImages_.clear();
+          swapchainImageViews_.clear();
+          imageUsage_ = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+          imageCount_ = OFFSCREEN_IMAGES;
+          nextImage_  = 0;
+          for (uint32_t i = 0; i != imageCount_; ++i) {
+               auto& image = offscreenImages_.emplace_back(std::make_unique<ImageResource2D>(core_, device_,
+                    ImageResource2D::ImageConf {
+                         .format           = swapchainFormat_,
+                         .extent           = swapchainExtent_,
+                         .mipLevels        = 1,
+                         .msaa             = VK_SAMPLE_COUNT_1_BIT,
+                         .tiling           = VK_IMAGE_TILING_OPTIMAL,
+                         .usage            = imageUsage_,
+                         .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT },
+                    ImageResource2D::ViewConf { .aspect = VK_IMAGE_ASPECT_COLOR_BIT }));
+               swapchainImages_.push_back(image->image());
+               swapchainImageViews_.push_back(image->view());
+          }
+     }
+
      void createImageViews() {
           swapchainImageViews_.reserve(imageCount_);
           for (size_t i = 0; i != imageCount_; ++i)
                swapchainImageViews_.push_back(createImageView(swapchainImages_[i], swapchainFormat_, VK_IMAGE_ASPECT_COLOR_BIT));
      }
 
-     Core*    core_;
-     Surface* surface_;
-     Device*  device_;
+     Core*        core_;
+     VkSurfaceKHR surface_;
+     Device*      device_;
 
      VkExtent2D               swapchainExtent_;
      VkFormat                 swapchainFormat_ {VK_FORMAT_B8G8R8A8_SRGB};
-     VkSwapchainKHR           swapchain_;
+     VkImageUsageFlags        imageUsage_ {};
+     VkSwapchainKHR           swapchain_ { VK_NULL_HANDLE };
      uint32_t                 imageCount_;
      std::vector<VkImage>     swapchainImages_;
      std::vector<VkImageView> swapchainImageViews_;
+
+     std::vector<std::unique_ptr<ImageResource2D>> offscreenImages_;
+     uint32_t                                      nextImage_ { 0 };
 };
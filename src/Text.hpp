@@ -0,0 +1,496 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "CommandPool.hpp"
+#include "Core.hpp"
+#include "Device.hpp"
+#include "DrawList.hpp"
+#include "GlyphSource.hpp"
+#include "ImageResource2D.hpp"
+#include "TextureTable.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Text drawn from signed distance field glyphs. Glyphs are rasterized once, at one base size, from the
+// platform's outline (see GlyphSource) into cells of single channel atlas pages; every size is the same cell scaled, the
+// fragment shader keeps edges a pixel wide. Pages are added as glyphs arrive and each is its own
+// texture slot, so growing never moves a glyph. Once the last page is full the least recently drawn
+// glyph no frame in flight still samples gives up its cell; a draw list kept across frames should be
+// recorded again when evictions() changes. Shaped runs are cached by string and font; layout scales
+// linearly with size, so one run serves every size the string is drawn at. Drawing, prepare() and
+// publish() belong to the thread that builds frame packets; apply() and record() to the one that
+// draws them, which copies the glyphs into the pages.
+class Text {
+     static constexpr uint32_t NONE = ~0u;
+     // em height glyphs are rasterized at, and distance covered by the field either side of the edge
+     static constexpr int      BASE   = 32;
+     static constexpr int      SPREAD = 4;
+     static constexpr int      CELL   = 48;
+     static constexpr uint32_t PAGE   = 1024;
+     static constexpr uint32_t ROW    = PAGE / CELL;
+     static constexpr uint32_t CELLS  = ROW * ROW;
+     static constexpr size_t   PAGES  = 4;
+     static constexpr size_t   RUNS   = 4096;
+
+     struct Glyph {
+          uint32_t  font;
+          wchar_t   codepoint;
+          float     advance;
+          glm::vec2 offset {}; // of the cell's corner from the pen, in base pixels
+          uint32_t  cell { NONE };
+          uint64_t  used { 0 };
+          bool      empty { false };
+     };
+
+     struct RunGlyph {
+          uint32_t  glyph;
+          glm::vec2 pen;
+     };
+     struct Run {
+          std::vector<RunGlyph> glyphs;
+          glm::vec2             size;
+          uint64_t              used;
+     };
+     // lookups by string_view without building a key
+     struct Hash {
+          using is_transparent = void;
+          size_t operator()(std::wstring_view text) const { return std::hash<std::wstring_view> {}(text); }
+     };
+
+     struct FontData {
+          GlyphSource::Metrics                                         metrics;
+          std::unordered_map<wchar_t, uint32_t>                        glyphs;
+          std::unordered_map<std::wstring, Run, Hash, std::equal_to<>> runs;
+     };
+
+     struct Page {
+          std::unique_ptr<ImageResource2D> image;
+          uint32_t                         slot;
+     };
+
+     struct Upload {
+          uint32_t cell;
+          size_t   offset;
+     };
+
+     struct Staging {
+          std::optional<Buffer<uint8_t>> buffer;
+          uint8_t*                       mapped { nullptr };
+          size_t                         capacity { 0 };
+     };
+
+  public:
+     using Font = uint32_t;
+
+     // Glyphs rasterized since the last publish(), as a frame packet carries them to the thread that
+     // draws, with the image of every page.
+     struct Uploads {
+          std::vector<Upload>  cells;
+          std::vector<uint8_t> pixels;
+          std::vector<VkImage> pages;
+
+          void clear() {
+               cells.clear();
+               pixels.clear();
+               pages.clear();
+          }
+     };
+
+     struct Stats {
+          size_t   glyphs;
+          size_t   resident;
+          size_t   pages;
+          size_t   runs;
+          uint64_t rasterized;
+          uint64_t evicted;
+          uint64_t dropped;
+          uint64_t runHits;
+          uint64_t runMisses;
+     };
+
+     Text(Core* core, Device* device, CommandPool* commandPool, TextureTable* textureTable, size_t maxFramesInFlight)
+        : core_(core)
+        , device_(device)
+        , commandPool_(commandPool)
+        , textureTable_(textureTable)
+        , maxFramesInFlight_(maxFramesInFlight)
+        , source_(BASE)
+        , staging_(maxFramesInFlight) {
+          createSampler();
+     }
+     ~Text() {
+          for (auto& staging : staging_)
+               if (staging.buffer)
+                    staging.buffer->unmap();
+          for (auto& page : pages_)
+               textureTable_->remove(page.slot);
+          vkDestroySampler(device_->logical(), sampler_, core_->allocator());
+     }
+     Text(const Text&)            = delete;
+     Text(Text&&)                 = delete;
+     Text& operator=(const Text&) = delete;
+     Text& operator=(Text&&)      = delete;
+
+     Font addFont(const wchar_t* family, int weight = GlyphSource::NORMAL, bool italic = false) {
+          auto& data = fonts_.emplace_back();
+          return source_.add(family, weight, italic, data.metrics);
+     }
+
+     float lineHeight(Font font, float size) { return fonts_.at(font).metrics.lineHeight * size / BASE; }
+
+     // Size of the laid out string, lines broken at '\n'.
+     glm::vec2 measure(std::wstring_view text, Font font, float size) { return shape(text, font).size * (size / BASE); }
+
+     // `size` is the em height in pixels, `position` the top left corner of the first line.
+     void draw(DrawList& list, std::wstring_view text, Font font, float size, glm::vec2 position, DrawList::Color color) {
+          auto& run      = shape(text, font);
+          auto  scale    = size / BASE;
+          auto  baseline = position + glm::vec2 { 0.f, fonts_[font].metrics.ascent * scale };
+          quads_.clear();
+          for (auto& placed : run.glyphs) {
+               auto& glyph = glyphs_[placed.glyph];
+               if (glyph.empty || !resident(placed.glyph))
+                    continue;
+               glyph.used  = frame_;
+               auto page   = glyph.cell / CELLS;
+               auto local  = glyph.cell % CELLS;
+               auto corner = glm::vec2 { static_cast<float>(local % ROW * CELL), static_cast<float>(local / ROW * CELL) };
+               auto low    = baseline + (placed.pen + glyph.offset) * scale;
+               quads_.push_back(DrawList::Glyph {
+                    .low     = low,
+                    .high    = low + glm::vec2 { CELL * scale },
+                    .uvLow   = corner / static_cast<float>(PAGE),
+                    .uvHigh  = (corner + glm::vec2 { static_cast<float>(CELL) }) / static_cast<float>(PAGE),
+                    .texture = pages_[page].slot });
+          }
+          list.glyphs(quads_, color);
+     }
+
+     uint64_t evictions() { return evicted_; }
+
+     // Called once per packet, after publish().
+     void prepare() {
+          ++frame_;
+          if (runs_ > RUNS)
+               for (auto& font : fonts_)
+                    runs_ -= std::erase_if(font.runs, [this](const auto& entry) { return entry.second.used < frame_ - 1; });
+     }
+
+     // Hands the glyphs rasterized since the last call to `uploads`, whose vectors are swapped
+     // rather than copied.
+     void publish(Uploads& uploads) {
+          std::swap(uploads.cells, uploads_);
+          std::swap(uploads.pixels, pixels_);
+          uploads_.clear();
+          pixels_.clear();
+          uploads.pages.clear();
+          for (auto& page : pages_)
+               uploads.pages.push_back(page.image->image());
+     }
+
+     // On the thread that draws: queues a packet's glyphs for the next record().
+     void apply(const Uploads& uploads) {
+          auto base = queuedPixels_.size();
+          for (auto upload : uploads.cells)
+               queued_.push_back({ upload.cell, base + upload.offset });
+          queuedPixels_.insert(queuedPixels_.end(), uploads.pixels.begin(), uploads.pixels.end());
+          images_ = uploads.pages;
+          written_.resize(images_.size(), false);
+     }
+
+     // Writes the queued glyphs into their pages, outside any render pass.
+     void record(size_t frame, CommandBuffer* commandBuffer) {
+          if (queued_.empty())
+               return;
+          auto& staging = staging_[frame];
+          if (staging.capacity < queuedPixels_.size()) {
+               if (staging.buffer)
+                    staging.buffer->unmap();
+               staging.capacity = std::max(queuedPixels_.size(), staging.capacity * 2);
+               staging.buffer.emplace(Buffer<uint8_t>::makeUpload(core_, device_, commandPool_, staging.capacity));
+               staging.mapped = staging.buffer->map();
+          }
+          std::memcpy(staging.mapped, queuedPixels_.data(), queuedPixels_.size());
+
+          VkImageSubresourceRange subresource {
+               .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+               .baseMipLevel   = 0,
+               .levelCount     = 1,
+               .baseArrayLayer = 0,
+               .layerCount     = 1
+          };
+          for (uint32_t p = 0; p != images_.size(); ++p) {
+               std::vector<VkBufferImageCopy> regions;
+               for (auto& upload : queued_) {
+                    if (upload.cell / CELLS != p)
+                         continue;
+                    auto local = upload.cell % CELLS;
+                    regions.push_back(VkBufferImageCopy {
+                         .bufferOffset      = upload.offset,
+                         .bufferRowLength   = 0,
+                         .bufferImageHeight = 0,
+                         .imageSubresource  = {
+                              .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                              .mipLevel       = 0,
+                              .baseArrayLayer = 0,
+                              .layerCount     = 1 },
+                         .imageOffset = { static_cast<int32_t>(local % ROW * CELL), static_cast<int32_t>(local / ROW * CELL), 0 },
+                         .imageExtent = { CELL, CELL, 1 } });
+               }
+               if (regions.empty())
+                    continue;
+               VkImageMemoryBarrier toTransfer {
+                    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .pNext               = nullptr,
+                    .srcAccessMask       = {},
+                    .dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+                    .oldLayout           = written_[p] ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+                    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .image               = images_[p],
+                    .subresourceRange    = subresource
+               };
+               vkCmdPipelineBarrier(commandBuffer->get(), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {}, 0, nullptr, 0, nullptr, 1, &toTransfer);
+               vkCmdCopyBufferToImage(commandBuffer->get(), staging.buffer->get(), images_[p], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+               VkImageMemoryBarrier toShader = toTransfer;
+               toShader.srcAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
+               toShader.dstAccessMask        = VK_ACCESS_SHADER_READ_BIT;
+               toShader.oldLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+               toShader.newLayout            = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+               vkCmdPipelineBarrier(commandBuffer->get(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, {}, 0, nullptr, 0, nullptr, 1, &toShader);
+               written_[p] = true;
+          }
+          queued_.clear();
+          queuedPixels_.clear();
+     }
+
+     Stats stats() {
+          return Stats {
+               .glyphs     = glyphs_.size(),
+               .resident   = static_cast<size_t>(std::count_if(owners_.begin(), owners_.end(), [](uint32_t owner) { return owner != NONE; })),
+               .pages      = pages_.size(),
+               .runs       = runs_,
+               .rasterized = rasterized_,
+               .evicted    = evicted_,
+               .dropped    = dropped_,
+               .runHits    = runHits_,
+               .runMisses  = runMisses_
+          };
+     }
+
+  private:
+     const Run& shape(std::wstring_view text, Font font) {
+          auto& data    = fonts_.at(font);
+          auto& metrics = data.metrics;
+          if (auto it = data.runs.find(text); it != data.runs.end()) {
+               ++runHits_;
+               it->second.used = frame_;
+               return it->second;
+          }
+          ++runMisses_;
+          Run       run { .glyphs = {}, .size = {}, .used = frame_ };
+          glm::vec2 pen { 0.f, 0.f };
+          wchar_t   previous { 0 };
+          for (auto codepoint : text) {
+               if (codepoint == L'\n') {
+                    run.size.x = std::max(run.size.x, pen.x);
+                    pen        = { 0.f, pen.y + metrics.lineHeight };
+                    previous   = 0;
+                    continue;
+               }
+               auto index = glyph(font, codepoint);
+               if (auto kerning = metrics.kerning.find(static_cast<uint32_t>(previous) << 16 | codepoint); previous && kerning != metrics.kerning.end())
+                    pen.x += kerning->second;
+               run.glyphs.push_back({ index, pen });
+               pen.x += glyphs_[index].advance;
+               previous = codepoint;
+          }
+          run.size = { std::max(run.size.x, pen.x), pen.y + metrics.ascent + metrics.descent };
+          ++runs_;
+          return data.runs.emplace(std::wstring(text), std::move(run)).first->second;
+     }
+
+     // Metrics only, the glyph is rasterized the first time it is drawn.
+     uint32_t glyph(Font font, wchar_t codepoint) {
+          auto& data = fonts_[font];
+          if (auto it = data.glyphs.find(codepoint); it != data.glyphs.end())
+               return it->second;
+          auto  index = static_cast<uint32_t>(glyphs_.size());
+          Glyph glyph { .font = font, .codepoint = codepoint, .advance = 0.f };
+          glyph.empty = !source_.advance(font, codepoint, glyph.advance);
+          glyphs_.push_back(glyph);
+          data.glyphs.emplace(codepoint, index);
+          return index;
+     }
+
+     bool resident(uint32_t index) {
+          if (glyphs_[index].cell != NONE)
+               return true;
+          auto cell = allocate();
+          if (cell == NONE) {
+               ++dropped_;
+               return false;
+          }
+          if (!rasterize(index, cell)) {
+               free_.push_back(cell);
+               return false;
+          }
+          glyphs_[index].cell = cell;
+          owners_[cell]       = index;
+          return true;
+     }
+
+     uint32_t allocate() {
+          if (free_.empty() && pages_.size() < PAGES)
+               addPage();
+          if (!free_.empty()) {
+               auto cell = free_.back();
+               free_.pop_back();
+               return cell;
+          }
+          // the least recently drawn glyph, unless a frame in flight may still sample it
+          auto cell = NONE;
+          for (uint32_t c = 0; c != owners_.size(); ++c)
+               if (owners_[c] != NONE && glyphs_[owners_[c]].used + maxFramesInFlight_ < frame_ && (cell == NONE || glyphs_[owners_[c]].used < glyphs_[owners_[cell]].used))
+                    cell = c;
+          if (cell != NONE) {
+               glyphs_[owners_[cell]].cell = NONE;
+               owners_[cell]               = NONE;
+               ++evicted_;
+          }
+          return cell;
+     }
+
+     void addPage() {
+          ImageResource2D::ImageConf conf {
+               .format           = VK_FORMAT_R8_UNORM,
+               .extent           = { PAGE, PAGE },
+               .mipLevels        = 1,
+               .msaa             = VK_SAMPLE_COUNT_1_BIT,
+               .tiling           = VK_IMAGE_TILING_OPTIMAL,
+               .usage            = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+               .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+          };
+          auto& page = pages_.emplace_back(Page { .image = std::make_unique<ImageResource2D>(core_, device_, conf, ImageResource2D::ViewConf { .aspect = VK_IMAGE_ASPECT_COLOR_BIT }), .slot = 0 });
+          page.slot  = textureTable_->add(page.image->view(), sampler_);
+          auto first = static_cast<uint32_t>(owners_.size());
+          owners_.resize(owners_.size() + CELLS, NONE);
+          for (auto cell = first + CELLS; cell-- != first;)
+               free_.push_back(cell);
+     }
+
+     // Coverage from the glyph source, then for every texel the distance to the nearest edge within the spread,
+     // stored as 0.5 on the edge, growing inwards.
+     bool rasterize(uint32_t index, uint32_t cell) {
+          auto& glyph = glyphs_[index];
+          if (!source_.rasterize(glyph.font, glyph.codepoint, bitmap_)) {
+               glyph.empty = true;
+               return false;
+          }
+          glyph.offset = { static_cast<float>(bitmap_.originX - SPREAD), static_cast<float>(bitmap_.originY - SPREAD) };
+
+          // larger glyphs lose their right and bottom
+          std::vector<float> coverage(CELL * CELL, 0.f);
+          for (uint32_t y = 0; y != std::min<uint32_t>(bitmap_.height, CELL - 2 * SPREAD); ++y)
+               for (uint32_t x = 0; x != std::min<uint32_t>(bitmap_.width, CELL - 2 * SPREAD); ++x)
+                    coverage[(y + SPREAD) * CELL + x + SPREAD] = static_cast<float>(bitmap_.coverage[y * bitmap_.pitch + x]) / 64.f;
+
+          auto offset = pixels_.size();
+          pixels_.resize(offset + CELL * CELL);
+          for (int y = 0; y != CELL; ++y)
+               for (int x = 0; x != CELL; ++x) {
+                    auto  own      = coverage[y * CELL + x];
+                    bool  inside   = own >= .5f;
+                    float distance = SPREAD;
+                    if (own > 0.f && own < 1.f)
+                         distance = std::abs(.5f - own);
+                    else
+                         for (int dy = -SPREAD; dy <= SPREAD; ++dy)
+                              for (int dx = -SPREAD; dx <= SPREAD; ++dx) {
+                                   int nx = x + dx, ny = y + dy;
+                                   if (nx < 0 || ny < 0 || nx >= CELL || ny >= CELL)
+                                        continue;
+                                   auto other = coverage[ny * CELL + nx];
+                                   // an edge lies in partially covered texels and between opposite ones
+                                   if ((other > 0.f && other < 1.f) || (other >= .5f) != inside) {
+                                        auto across = inside ? other - .5f : .5f - other;
+                                        distance    = std::min(distance, std::max(0.f, std::sqrt(static_cast<float>(dx * dx + dy * dy)) + across));
+                                   }
+                              }
+                    auto value                     = std::clamp(.5f + (inside ? distance : -distance) / (2.f * SPREAD), 0.f, 1.f);
+                    pixels_[offset + y * CELL + x] = static_cast<uint8_t>(std::lround(value * 255.f));
+               }
+          uploads_.push_back({ cell, offset });
+          ++rasterized_;
+          return true;
+     }
+
+     void createSampler() {
+          VkSamplerCreateInfo samplerCreateInfo {
+               .sType                   = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+               .pNext                   = nullptr,
+               .flags                   = {},
+               .magFilter               = VK_FILTER_LINEAR,
+               .minFilter               = VK_FILTER_LINEAR,
+               .mipmapMode              = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+               .addressModeU            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+               .addressModeV            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+               .addressModeW            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+               .mipLodBias              = 0.f,
+               .anisotropyEnable        = VK_FALSE,
+               .maxAnisotropy           = 1.f,
+               .compareEnable           = VK_FALSE,
+               .compareOp               = VK_COMPARE_OP_ALWAYS,
+               .minLod                  = 0.f,
+               .maxLod                  = 0.f,
+               .borderColor             = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+               .unnormalizedCoordinates = VK_FALSE
+          };
+          if (vkCreateSampler(device_->logical(), &samplerCreateInfo, core_->allocator(), &sampler_) != VK_SUCCESS)
+               throw std::runtime_error("call to vkCreateSampler failed");
+     }
+
+     Core*         core_;
+     Device*       device_;
+     CommandPool*  commandPool_;
+     TextureTable* textureTable_;
+     size_t        maxFramesInFlight_;
+     GlyphSource   source_;
+     VkSampler     sampler_;
+     uint64_t      frame_ { 0 };
+     size_t        runs_ { 0 };
+     uint64_t      rasterized_ { 0 };
+     uint64_t      evicted_ { 0 };
+     uint64_t      dropped_ { 0 };
+     uint64_t      runHits_ { 0 };
+     uint64_t      runMisses_ { 0 };
+
+     std::vector<FontData>        fonts_;
+     std::vector<Glyph>           glyphs_;
+     std::vector<Page>            pages_;
+     std::vector<uint32_t>        owners_; // glyph in each cell
+     std::vector<uint32_t>        free_;
+     std::vector<Upload>          uploads_;
+     std::vector<uint8_t>         pixels_;
+     std::vector<DrawList::Glyph> quads_;
+     GlyphSource::Bitmap          bitmap_ {};
+
+     // on the thread that draws
+     std::vector<Upload>  queued_;
+     std::vector<uint8_t> queuedPixels_;
+     std::vector<VkImage> images_;
+     std::vector<bool>    written_;
+     std::vector<Staging> staging_;
+};
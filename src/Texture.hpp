@@ -5,6 +5,9 @@
 #include "Core.hpp"
 #include "Device.hpp"
 #include "Data.hpp"
+#include "TextureData.hpp"
+
+#include <string>
 
 const auto TEXTURE_PATH = "textures\\texture.jpg";
 class Texture {
@@ -12,6 +15,9 @@ class Texture {
      Device*        device_;
      CommandPool*   commandPool_;
      VkExtent2D     extent_;
+     VkFormat       format_;
+     uint32_t       mipLevels_;
+     VkDeviceSize   memorySize_;
      VkDeviceMemory textureImageMemory_;
      VkImage        textureImage_;
      VkImageView    textureImageView_;
@@ -29,25 +35,80 @@ class Texture {
      }
      
   public:
-     Texture(Core* core, Device* device, CommandPool* commandPool)
+     // Format capabilities import() depends on, queried once so decoding can run away from the device.
+     struct FormatSupport {
+          bool bc1;
+          bool bc7;
+          bool blitRGBA;
+
+          bool samples(VkFormat format) const {
+               return format == VK_FORMAT_R8G8B8A8_SRGB || (format == VK_FORMAT_BC1_RGB_SRGB_BLOCK && bc1) || (format == VK_FORMAT_BC7_SRGB_BLOCK && bc7);
+          }
+     };
+
+     static FormatSupport formatSupport(Device* device) {
+          constexpr VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+          bool                           bc       = device->features().textureCompressionBC;
+          return FormatSupport {
+               .bc1      = bc && device->supportsFormat(VK_FORMAT_BC1_RGB_SRGB_BLOCK, required),
+               .bc7      = bc && device->supportsFormat(VK_FORMAT_BC7_SRGB_BLOCK, required),
+               .blitRGBA = device->supportsFormat(VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+          };
+     }
+
+     // Picks the smallest format the device can sample for the image: BC1 for opaque images, BC7 when
+     // alpha has to survive, RGBA8 otherwise.
+     static VkFormat chooseFormat(const FormatSupport& support, bool opaque) {
+          if (opaque && support.bc1)
+               return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+          if (support.bc7)
+               return VK_FORMAT_BC7_SRGB_BLOCK;
+          return VK_FORMAT_R8G8B8A8_SRGB;
+     }
+
+     // Safe to call from any thread, it only touches the file and the CPU encoders. skipMips halves the
+     // image that many times before the chain is built, for residency under memory pressure.
+     static TextureData import(const FormatSupport& support, const std::string& path, bool compress = true, uint32_t skipMips = 0) {
+          return import(support, path, compress, skipMips, [](size_t) -> uint8_t* { return nullptr; });
+     }
+
+     // Writes the levels into the memory `allocate` hands out, see TextureData::fromRGBA.
+     template <typename Allocate>
+     static TextureData import(const FormatSupport& support, const std::string& path, bool compress, uint32_t skipMips, Allocate allocate) {
+          VkExtent2D extent {};
+          auto       rgba   = TextureData::decode(path, extent);
+          for (uint32_t i = 0; i != skipMips && std::max(extent.width, extent.height) > 1; ++i)
+               rgba = TextureData::downsample(rgba, extent, extent);
+          auto       opaque = BlockCompression::isOpaque(rgba.data(), static_cast<size_t>(extent.width) * extent.height);
+          auto       format = compress ? chooseFormat(support, opaque) : VK_FORMAT_R8G8B8A8_SRGB;
+          return TextureData::fromRGBA(std::move(rgba), extent, format, true, !support.blitRGBA, allocate);
+     }
+
+     static TextureData import(Device* device, const std::string& path, bool compress = true) {
+          return import(formatSupport(device), path, compress);
+     }
+
+     Texture(Core* core, Device* device, CommandPool* commandPool, const std::string& path = TEXTURE_PATH)
+        : Texture(core, device, commandPool, import(device, path)) {}
+
+     // Allocates the image, view and sampler only. The contents are undefined until a command buffer
+     // holding recordUpload() has executed.
+     Texture(Core* core, Device* device, CommandPool* commandPool, VkExtent2D extent, VkFormat format, uint32_t mipLevels)
         : core_(core)
         , device_(device)
-        , commandPool_(commandPool) {
-          int      textureWidth {};
-          int      textureHeight {};
-          int      textureChannels {};
-          stbi_uc* pixels        = stbi_load(TEXTURE_PATH, &textureWidth, &textureHeight, &textureChannels, STBI_rgb_alpha);
-          VkDeviceSize imageSize = textureWidth * textureHeight * 4;
-          
-          if (pixels == nullptr)
-               throw std::runtime_error("failed to load texture image");
-          
-          for (size_t i = 0; i != 100; ++i) {
-               fmt::print("pixel: {}, value: {}\n", i, pixels[i]);
-          }
-          extent_.width  = static_cast<uint32_t>(textureWidth);
-          extent_.height = static_cast<uint32_t>(textureHeight);
-          
+        , commandPool_(commandPool)
+        , extent_(extent)
+        , format_(format)
+        , mipLevels_(mipLevels) {
+          createImage();
+          createImageView();
+          createTextureSampler();
+     }
+
+     Texture(Core* core, Device* device, CommandPool* commandPool, const TextureData& data)
+        : Texture(core, device, commandPool, data.extent, data.format, data.mipLevels) {
+          VkDeviceSize imageSize = data.bytes.size();
+
           VkBuffer           buffer;
           VkDeviceMemory     bufferMemory;
           VkBufferCreateInfo vkBufferCreateInfo {
@@ -75,39 +136,17 @@ class Texture {
                throw std::runtime_error("call to vkAllocateMemory failed to allocate buffer memory");
 
           vkBindBufferMemory(device->logical(), buffer, bufferMemory, 0);
-          
-          void* data;
-          vkMapMemory(device_->logical(), bufferMemory, 0, imageSize, 0, &data);
-               memcpy(data, pixels, static_cast<size_t>(imageSize));
+
+          void* mapped;
+          vkMapMemory(device_->logical(), bufferMemory, 0, imageSize, 0, &mapped);
+               memcpy(mapped, data.bytes.data(), static_cast<size_t>(imageSize));
           vkUnmapMemory(device_->logical(), bufferMemory);
-          stbi_image_free(pixels);
 
-          createImage();
-          
-          transitionUndefinedToDst();
-          
-          commandPool_->singleTimeCommand([this, buffer](auto commandBuffer) {
-               VkBufferImageCopy region {
-                    .bufferOffset      = 0,
-                    .bufferRowLength   = 0,
-                    .bufferImageHeight = 0,
-                    .imageSubresource  = {
-                        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-                        .mipLevel       = 0,
-                        .baseArrayLayer = 0,
-                        .layerCount     = 1 },
-                    .imageOffset = { .x = 0, .y = 0, .z = 0 },
-                    .imageExtent = { .width = extent_.width, .height = extent_.height, .depth = 1 },
-               };
-               vkCmdCopyBufferToImage(commandBuffer, buffer, textureImage_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-          }, Device::QueuePriority::TRANSFER_MEDIUM);
+          commandPool_->singleTimeCommand([this, buffer, &data](auto commandBuffer) {
+               recordUpload(commandBuffer, buffer, 0, data);
+          }, Device::QueuePriority::GRAPHICS_MEDIUM);
           vkDestroyBuffer(device_->logical(), buffer, core_->allocator());
           vkFreeMemory(device_->logical(), bufferMemory, core_->allocator());
-          
-          transitionDstToShader();
-          
-          createImageView();
-          createTextureSampler();
      }
 
      ~Texture() {
@@ -119,6 +158,56 @@ class Texture {
 
      auto& sampler() { return textureImageSampler_; }
      auto& view() { return textureImageView_; }
+     auto  format() { return format_; }
+     auto  mipLevels() { return mipLevels_; }
+     auto  extent() { return extent_; }
+     auto  memorySize() { return memorySize_; }
+
+     // Records the whole upload into one command buffer: every level present in `data` is copied from
+     // `staging`, the rest of the chain is blitted level by level, and all levels end up shader readable.
+     void recordUpload(VkCommandBuffer commandBuffer, VkBuffer staging, VkDeviceSize stagingOffset, const TextureData& data) {
+          barrier(commandBuffer, 0, mipLevels_, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_NONE, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+          std::vector<VkBufferImageCopy> regions;
+          for (uint32_t i = 0; i != data.levels.size(); ++i)
+               regions.push_back(VkBufferImageCopy {
+                  .bufferOffset      = stagingOffset + data.levels[i].offset,
+                  .bufferRowLength   = 0,
+                  .bufferImageHeight = 0,
+                  .imageSubresource  = {
+                      .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                      .mipLevel       = i,
+                      .baseArrayLayer = 0,
+                      .layerCount     = 1 },
+                  .imageOffset = { .x = 0, .y = 0, .z = 0 },
+                  .imageExtent = { .width = data.levels[i].extent.width, .height = data.levels[i].extent.height, .depth = 1 },
+               });
+          vkCmdCopyBufferToImage(commandBuffer, staging, textureImage_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+          if (!data.generateMips) {
+               barrier(commandBuffer, 0, mipLevels_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+               return;
+          }
+
+          auto width  = static_cast<int32_t>(extent_.width);
+          auto height = static_cast<int32_t>(extent_.height);
+          for (uint32_t i = 1; i != mipLevels_; ++i) {
+               barrier(commandBuffer, i - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+               VkImageBlit blit {
+                    .srcSubresource = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = i - 1, .baseArrayLayer = 0, .layerCount = 1 },
+                    .srcOffsets     = { { 0, 0, 0 }, { width, height, 1 } },
+                    .dstSubresource = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = i, .baseArrayLayer = 0, .layerCount = 1 },
+                    .dstOffsets     = { { 0, 0, 0 }, { width > 1 ? width / 2 : 1, height > 1 ? height / 2 : 1, 1 } },
+               };
+               vkCmdBlitImage(commandBuffer, textureImage_, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, textureImage_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+               barrier(commandBuffer, i - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+               if (width > 1)
+                    width /= 2;
+               if (height > 1)
+                    height /= 2;
+          }
+          barrier(commandBuffer, mipLevels_ - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+     }
 
   private:
      uint32_t findMemoryIndex(uint32_t typeBits, VkMemoryPropertyFlags memoryPropertyFlags) {
@@ -138,17 +227,16 @@ class Texture {
                .pNext     = nullptr,
                .flags     = {},
                .imageType = VK_IMAGE_TYPE_2D,
-               .format    = VK_FORMAT_R8G8B8A8_SRGB,
+               .format    = format_,
                .extent    = {
                      .width  = extent_.width,
                      .height = extent_.height,
                      .depth  = 1 },
-               .mipLevels             = 1,
+               .mipLevels             = mipLevels_,
                .arrayLayers           = 1,
                .samples               = VK_SAMPLE_COUNT_1_BIT,
                .tiling                = VK_IMAGE_TILING_OPTIMAL,
-               .usage                 = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-               // .usage                 = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+               .usage                 = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
                .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
                .queueFamilyIndexCount = 0,
                .pQueueFamilyIndices   = nullptr,
@@ -167,7 +255,7 @@ class Texture {
                .allocationSize  = memoryRequirements.size,
                .memoryTypeIndex = findMemoryIndex(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
           };
-          fmt::print("memoryRequirements.size: {}\n", memoryRequirements.size);
+          memorySize_ = memoryRequirements.size;
 
           if (vkAllocateMemory(device_->logical(), &memoryAllocateInfo, core_->allocator(), &textureImageMemory_) != VK_SUCCESS)
                throw std::runtime_error("call to vkAllocateMemory failed");
@@ -175,137 +263,27 @@ class Texture {
                throw std::runtime_error("call to vkBindImageMemory failed");
      }
 
-     void transitionUndefinedToDst() {
-          commandPool_->singleTimeCommand([this](auto commandBuffer) {
-               VkImageMemoryBarrier imageMemoryBarrier {
-                    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                    .pNext               = nullptr,
-                    .srcAccessMask       = VK_ACCESS_NONE,
-                    .dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
-                    .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
-                    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                    .image               = textureImage_,
-                    .subresourceRange    = {
-                          .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-                          .baseMipLevel   = 0,
-                          .levelCount     = 1,
-                          .baseArrayLayer = 0,
-                          .layerCount     = 1 },
-               };
-
-               vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {}, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-          },
-             Device::QueuePriority::TRANSFER_MEDIUM);
-     }
-     void transitionDstToShader() {
-          commandPool_->singleTimeCommand([this](auto commandBuffer) {
-               VkImageMemoryBarrier imageMemoryBarrier {
-                    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                    .pNext               = nullptr,
-                    .srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
-                    .dstAccessMask       = VK_ACCESS_SHADER_READ_BIT,
-                    .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                    .newLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                    .image               = textureImage_,
-                    .subresourceRange    = {
-                          .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-                          .baseMipLevel   = 0,
-                          .levelCount     = 1,
-                          .baseArrayLayer = 0,
-                          .layerCount     = 1 },
-               };
-
-               vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, {}, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-          },
-             Device::QueuePriority::TRANSFER_MEDIUM);
-     }
-
-     void copyBufferToImage(VkBuffer buffer) {
-          commandPool_->singleTimeCommand([this, buffer](auto commandBuffer) {
-               VkBufferImageCopy region {
-                    .bufferOffset      = 0,
-                    .bufferRowLength   = 0,
-                    .bufferImageHeight = 0,
-                    .imageSubresource  = {
-                        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-                        .mipLevel       = 0,
-                        .baseArrayLayer = 0,
-                        .layerCount     = 1 },
-                    .imageOffset = { .x = 0, .y = 0, .z = 0 },
-                    .imageExtent = { .width = extent_.width, .height = extent_.height, .depth = 1 },
-               };
-               vkCmdCopyBufferToImage(commandBuffer, buffer, textureImage_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-          },
-             Device::QueuePriority::TRANSFER_MEDIUM);
+     void barrier(VkCommandBuffer commandBuffer, uint32_t baseMipLevel, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage) {
+          VkImageMemoryBarrier imageMemoryBarrier {
+               .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+               .pNext               = nullptr,
+               .srcAccessMask       = srcAccess,
+               .dstAccessMask       = dstAccess,
+               .oldLayout           = oldLayout,
+               .newLayout           = newLayout,
+               .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+               .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+               .image               = textureImage_,
+               .subresourceRange    = {
+                     .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                     .baseMipLevel   = baseMipLevel,
+                     .levelCount     = levelCount,
+                     .baseArrayLayer = 0,
+                     .layerCount     = 1 },
+          };
+          vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, {}, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
      }
 
-     // void generateMipmaps() {
-     //      VkFormatProperties properties {};
-     //      vkGetPhysicalDeviceFormatProperties(device_->physical(), VK_FORMAT_R8G8B8A8_SRGB, &properties);
-     //      if (!(properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
-     //           throw std::runtime_error("texture image format does not support linear blitting in generateMipmaps");
-
-     //      commandPool_->singleTimeCommand([this](auto commandBuffer) {
-     //           VkImageMemoryBarrier barrier {
-     //                .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-     //                .pNext               = nullptr,
-     //                .srcAccessMask       = {},
-     //                .dstAccessMask       = {},
-     //                .oldLayout           = {},
-     //                .newLayout           = {},
-     //                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-     //                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-     //                .image               = textureImage_,
-     //                .subresourceRange    = VkImageSubresourceRange {
-     //                      .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-     //                      .baseMipLevel   = 0,
-     //                      .levelCount     = 1,
-     //                      .baseArrayLayer = 0,
-     //                      .layerCount     = 1 }
-     //           };
-
-     //           int32_t width  = extent_.width;
-     //           int32_t height = extent_.height;
-
-     //           for (uint32_t i = 1; i != mipLevels_; ++i) {
-     //                barrier.subresourceRange.baseMipLevel = i - 1;
-     //                barrier.oldLayout                     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-     //                barrier.newLayout                     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-     //                barrier.srcAccessMask                 = VK_ACCESS_TRANSFER_WRITE_BIT;
-     //                barrier.dstAccessMask                 = VK_ACCESS_TRANSFER_READ_BIT;
-     //                vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-     //                VkImageBlit blit {
-     //                     .srcSubresource = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = i - 1, .baseArrayLayer = 0, .layerCount = 1 },
-     //                     .srcOffsets     = { { 0, 0, 0 }, { width, height, 1 } },
-     //                     .dstSubresource = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = i, .baseArrayLayer = 0, .layerCount = 1 },
-     //                     .dstOffsets     = { { 0, 0, 0 }, { width > 1 ? width / 2 : 1, height > 1 ? height / 2 : 1, 1 } },
-     //                };
-     //                vkCmdBlitImage(commandBuffer, textureImage_, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, textureImage_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
-     //                barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-     //                barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-     //                barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-     //                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-     //                vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-     //                if (width > 1)
-     //                     width /= 2;
-     //                if (height > 1)
-     //                     height /= 2;
-     //           }
-     //           barrier.subresourceRange.baseMipLevel = mipLevels_ - 1;
-     //           barrier.oldLayout                     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-     //           barrier.newLayout                     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-     //           barrier.srcAccessMask                 = VK_ACCESS_TRANSFER_WRITE_BIT;
-     //           barrier.dstAccessMask                 = VK_ACCESS_SHADER_READ_BIT;
-     //           vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-     //      },
-     //         Device::QueuePriority::GRAPHICS_MEDIUM);
-     // }
-
      void createImageView() {
           VkImageViewCreateInfo imageViewCreateInfo {
                .sType      = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
@@ -313,13 +291,13 @@ class Texture {
                .flags      = {},
                .image      = textureImage_,
                .viewType   = VK_IMAGE_VIEW_TYPE_2D,
-               .format     = VK_FORMAT_R8G8B8A8_SRGB,
+               .format     = format_,
                .components = {
                   .r = VK_COMPONENT_SWIZZLE_IDENTITY,
                   .g = VK_COMPONENT_SWIZZLE_IDENTITY,
                   .b = VK_COMPONENT_SWIZZLE_IDENTITY,
                   .a = VK_COMPONENT_SWIZZLE_IDENTITY },
-               .subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .baseMipLevel = 0, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1 }
+               .subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .baseMipLevel = 0, .levelCount = mipLevels_, .baseArrayLayer = 0, .layerCount = 1 }
           };
           if (vkCreateImageView(device_->logical(), &imageViewCreateInfo, core_->allocator(), &textureImageView_) != VK_SUCCESS)
                throw std::runtime_error("call to vkCreateImageView failed");
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "Device.hpp"
+#include "TextureStreamer.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Keeps streamed textures resident under a device memory budget. Every asset keeps its table slot for
+// as long as it is cached, so shaders can hold on to the index: when memory runs short the least
+// recently used images are evicted to the placeholder, or lose their largest mip while still on
+// screen, and come back through the streamer the next time they are used.
+class TextureCache {
+     struct Entry {
+          uint32_t slot;
+          uint64_t lastUsed;
+     };
+
+  public:
+     struct Stats {
+          uint64_t     hits;
+          uint64_t     misses;
+          uint64_t     evictions;
+          uint64_t     trims;
+          size_t       textures;
+          VkDeviceSize residentBytes;
+          VkDeviceSize budget;
+     };
+
+     TextureCache(TextureStreamer* streamer, size_t maxFramesInFlight, VkDeviceSize budget)
+        : streamer_(streamer)
+        , maxFramesInFlight_(maxFramesInFlight)
+        , budget_(budget) {}
+
+     // Half of the largest device local heap, the rest is left to attachments, buffers and the driver.
+     static VkDeviceSize defaultBudget(Device* device) {
+          VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties;
+          vkGetPhysicalDeviceMemoryProperties(device->physical(), &physicalDeviceMemoryProperties);
+          VkDeviceSize largest { 0 };
+          for (uint32_t i = 0; i != physicalDeviceMemoryProperties.memoryHeapCount; ++i)
+               if (physicalDeviceMemoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+                    largest = std::max(largest, physicalDeviceMemoryProperties.memoryHeaps[i].size);
+          return largest / 2;
+     }
+
+     // Returns the asset's slot and counts as a use this frame.
+     uint32_t acquire(const std::string& asset) {
+          auto entry = assets_.find(asset);
+          if (entry == assets_.end()) {
+               ++misses_;
+               auto slot = streamer_->request(asset);
+               assets_.emplace(asset, Entry { .slot = slot, .lastUsed = frame_ });
+               slots_.emplace(slot, asset);
+               return slot;
+          }
+          if (touch(entry->second))
+               ++hits_;
+          else
+               ++misses_;
+          return entry->second.slot;
+     }
+
+     // Marks a slot as drawn this frame, slots the cache does not own are ignored.
+     void use(uint32_t slot) {
+          auto asset = slots_.find(slot);
+          if (asset != slots_.end() && !touch(assets_.at(asset->second)))
+               ++misses_;
+     }
+
+     void release(const std::string& asset) {
+          auto entry = assets_.find(asset);
+          if (entry == assets_.end())
+               return;
+          streamer_->release(entry->second.slot);
+          trimming_.erase(entry->second.slot);
+          slots_.erase(entry->second.slot);
+          assets_.erase(entry);
+     }
+
+     // Called once per frame before the streamer is pumped.
+     void collect() {
+          ++frame_;
+          std::erase_if(trimming_, [this](const auto& trimming) { return !streamer_->loading(trimming.first); });
+
+          VkDeviceSize projected = streamer_->residentBytes();
+          for (auto& [slot, saving] : trimming_)
+               projected -= std::min(saving, projected);
+
+          std::vector<Entry*> candidates;
+          for (auto& [asset, entry] : assets_)
+               if (streamer_->resident(entry.slot) && !streamer_->loading(entry.slot))
+                    candidates.push_back(&entry);
+          std::sort(candidates.begin(), candidates.end(), [](auto* a, auto* b) { return a->lastUsed < b->lastUsed; });
+
+          if (projected <= budget_) {
+               // regain detail one texture per frame, most recently used first, while well under budget
+               for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+                    auto skipMips = streamer_->skipMips((*it)->slot);
+                    if (skipMips != 0 && (*it)->lastUsed == frame_ - 1 && projected + 3 * streamer_->bytes((*it)->slot) <= budget_ / 4 * 3) {
+                         streamer_->reload((*it)->slot, skipMips - 1);
+                         break;
+                    }
+               }
+               return;
+          }
+
+          for (auto* entry : candidates) {
+               if (projected <= budget_)
+                    break;
+               auto bytes = streamer_->bytes(entry->slot);
+               if (entry->lastUsed + maxFramesInFlight_ < frame_) {
+                    streamer_->evict(entry->slot);
+                    ++evictions_;
+                    projected -= bytes;
+               }
+               else if (streamer_->mipLevels(entry->slot) > 1) {
+                    // each level is a quarter of the one above, dropping the top one frees about 3/4
+                    streamer_->reload(entry->slot, streamer_->skipMips(entry->slot) + 1);
+                    trimming_[entry->slot] = bytes / 4 * 3;
+                    ++trims_;
+                    projected -= bytes / 4 * 3;
+               }
+          }
+     }
+
+     void setBudget(VkDeviceSize budget) { budget_ = budget; }
+
+     Stats stats() {
+          return Stats {
+               .hits          = hits_,
+               .misses        = misses_,
+               .evictions     = evictions_,
+               .trims         = trims_,
+               .textures      = assets_.size(),
+               .residentBytes = streamer_->residentBytes(),
+               .budget        = budget_
+          };
+     }
+
+     void report() {
+          auto s       = stats();
+          auto lookups = s.hits + s.misses;
+          fmt::print("texture cache: {} textures, {:.1f}% hits, {} evictions, {} trims, {:.1f} / {:.1f} MiB resident\n",
+             s.textures, lookups ? 100. * static_cast<double>(s.hits) / static_cast<double>(lookups) : 100., s.evictions, s.trims,
+             static_cast<double>(s.residentBytes) / (1 << 20), static_cast<double>(s.budget) / (1 << 20));
+     }
+
+  private:
+     // An evicted asset is loaded again the first time it is used. Returns whether it was still cached,
+     // assets that failed to load count as cached so a missing file is not retried every frame.
+     bool touch(Entry& entry) {
+          entry.lastUsed = frame_;
+          if (streamer_->resident(entry.slot) || streamer_->loading(entry.slot) || streamer_->failed(entry.slot))
+               return true;
+          streamer_->reload(entry.slot, streamer_->skipMips(entry.slot));
+          return false;
+     }
+
+     TextureStreamer* streamer_;
+     size_t           maxFramesInFlight_;
+     VkDeviceSize     budget_;
+     uint64_t         frame_ { 0 };
+     uint64_t         hits_ { 0 };
+     uint64_t         misses_ { 0 };
+     uint64_t         evictions_ { 0 };
+     uint64_t         trims_ { 0 };
+
+     std::unordered_map<std::string, Entry>     assets_;
+     std::unordered_map<uint32_t, std::string>  slots_;
+     std::unordered_map<uint32_t, VkDeviceSize> trimming_;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "TextureData.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+// Engine texture container (.ctex): a GPU-ready mip chain in its final Vulkan format.
+//
+//   Header | Level[levelCount] | padding | data
+//
+// The data block starts 16 byte aligned and every level offset inside it is too, a multiple of every
+// texel and block size in use, so levels go from the file mapping to staging memory with one memcpy
+// and from there to the image with one buffer to image copy per level.
+class TextureContainer {
+  public:
+     static constexpr uint32_t magic   = 0x58455443; // "CTEX"
+     static constexpr uint32_t version = 1;
+
+     enum Flags : uint32_t {
+          FLAG_OPAQUE        = 1,
+          FLAG_GENERATE_MIPS = 2
+     };
+
+     struct Header {
+          uint32_t magic;
+          uint32_t version;
+          uint32_t format;
+          uint32_t width;
+          uint32_t height;
+          uint32_t mipLevels;
+          uint32_t levelCount;
+          uint32_t flags;
+          uint64_t dataOffset;
+          uint64_t dataSize;
+     };
+     struct Level {
+          uint64_t offset;
+          uint64_t size;
+          uint32_t width;
+          uint32_t height;
+     };
+
+     static void write(const std::string& path, const TextureData& data) {
+          Header header {
+               .magic      = magic,
+               .version    = version,
+               .format     = static_cast<uint32_t>(data.format),
+               .width      = data.extent.width,
+               .height     = data.extent.height,
+               .mipLevels  = data.mipLevels,
+               .levelCount = static_cast<uint32_t>(data.levels.size()),
+               .flags      = (data.opaque ? FLAG_OPAQUE : 0u) | (data.generateMips ? FLAG_GENERATE_MIPS : 0u),
+               .dataOffset = align(sizeof(Header) + sizeof(Level) * data.levels.size()),
+               .dataSize   = align(data.bytes.size())
+          };
+          std::ofstream file(path, std::ios::binary | std::ios::trunc);
+          if (!file)
+               throw std::runtime_error("failed to open " + path + " for writing");
+          file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+          for (auto& level : data.levels) {
+               Level entry { .offset = level.offset, .size = level.size, .width = level.extent.width, .height = level.extent.height };
+               file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+          }
+          static constexpr char zeros[16] {};
+          file.write(zeros, static_cast<std::streamsize>(header.dataOffset - sizeof(Header) - sizeof(Level) * data.levels.size()));
+          file.write(reinterpret_cast<const char*>(data.bytes.data()), static_cast<std::streamsize>(data.bytes.size()));
+          file.write(zeros, static_cast<std::streamsize>(header.dataSize - data.bytes.size()));
+          if (!file)
+               throw std::runtime_error("failed to write " + path);
+     }
+
+     TextureContainer(const std::string& path)
+        : file_(path) {
+          auto bytes = file_.bytes();
+          if (bytes.size() < sizeof(Header))
+               throw std::runtime_error(path + " is not a texture container");
+          std::memcpy(&header_, bytes.data(), sizeof(Header));
+          if (header_.magic != magic || header_.version != version)
+               throw std::runtime_error(path + " is not a texture container of version " + std::to_string(version));
+          if (header_.levelCount == 0 || header_.levelCount > header_.mipLevels || sizeof(Header) + sizeof(Level) * header_.levelCount > header_.dataOffset || header_.dataOffset % 16 != 0 || header_.dataOffset + header_.dataSize > bytes.size())
+               throw std::runtime_error(path + " is truncated or corrupt");
+
+          layout_ = TextureData {
+               .format       = static_cast<VkFormat>(header_.format),
+               .extent       = { header_.width, header_.height },
+               .mipLevels    = header_.mipLevels,
+               .generateMips = (header_.flags & FLAG_GENERATE_MIPS) != 0,
+               .opaque       = (header_.flags & FLAG_OPAQUE) != 0,
+               .levels       = {},
+               .bytes        = {}
+          };
+          for (uint32_t i = 0; i != header_.levelCount; ++i) {
+               Level level;
+               std::memcpy(&level, bytes.data() + sizeof(Header) + sizeof(Level) * i, sizeof(Level));
+               if (level.offset % 16 != 0 || level.offset + level.size > header_.dataSize)
+                    throw std::runtime_error(path + " is truncated or corrupt");
+               layout_.levels.push_back({ .offset = level.offset, .size = level.size, .extent = { level.width, level.height } });
+          }
+     }
+
+     // Level offsets in the layout are relative to payload(), the layout itself carries no bytes.
+     const TextureData&       layout() const { return layout_; }
+     std::span<const uint8_t> payload() const { return file_.bytes().subspan(header_.dataOffset, header_.dataSize); }
+
+  private:
+     static uint64_t align(uint64_t size) { return (size + 15) & ~uint64_t { 15 }; }
+
+     MappedFile  file_;
+     Header      header_ {};
+     TextureData layout_ {};
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "BlockCompression.hpp"
+#include "MappedFile.hpp"
+#include "PixelConvert.hpp"
+#include "volk.hpp"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Host side image: every mip level the upload needs, laid out back to back in their final Vulkan format.
+// When generateMips is set only level 0 is present and the rest of the chain is blitted on the GPU.
+struct TextureData {
+     struct Level {
+          VkDeviceSize offset;
+          VkDeviceSize size;
+          VkExtent2D   extent;
+     };
+     VkFormat             format { VK_FORMAT_R8G8B8A8_SRGB };
+     VkExtent2D           extent {};
+     uint32_t             mipLevels { 1 };
+     bool                 generateMips { false };
+     bool                 opaque { true };
+     std::vector<Level>   levels {};
+     std::vector<uint8_t> bytes {};
+
+     static uint32_t mipCount(VkExtent2D extent) {
+          return static_cast<uint32_t>(std::bit_width(std::max(extent.width, extent.height)));
+     }
+
+     static bool isBlockCompressed(VkFormat format) {
+          return format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK;
+     }
+
+     static std::vector<uint8_t> decode(const std::string& path, VkExtent2D& extent) {
+          std::vector<uint8_t> rgba;
+          bool                 opaque;
+          decode(path, extent, opaque, [&rgba](size_t size) {
+               rgba.resize(size);
+               return rgba.data();
+          });
+          return rgba;
+     }
+
+     // Decodes at the file's own channel count and expands to RGBA8 straight into the memory `allocate`
+     // hands out for the whole image, which may be mapped staging memory. Returns false without decoding
+     // when `allocate` declines with nullptr.
+     template <typename Allocate>
+     static bool decode(const std::string& path, VkExtent2D& extent, bool& opaque, Allocate allocate) {
+          MappedFile file(path);
+          int        width {};
+          int        height {};
+          int        channels {};
+          if (!stbi_info_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels))
+               throw std::runtime_error("failed to load texture image " + path + ": " + stbi_failure_reason());
+          extent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+
+          auto     texels = static_cast<size_t>(width) * height;
+          uint8_t* out    = allocate(texels * 4);
+          if (out == nullptr)
+               return false;
+          stbi_uc* pixels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, 0);
+          if (pixels == nullptr)
+               throw std::runtime_error("failed to load texture image " + path + ": " + stbi_failure_reason());
+          opaque = PixelConvert::isOpaque(pixels, channels, texels);
+          PixelConvert::expandToRGBA(pixels, channels, out, texels);
+          stbi_image_free(pixels);
+          return true;
+     }
+
+     // sRGB aware 2x2 box filter, odd edges fold the last row / column into the previous one.
+     static std::vector<uint8_t> downsample(const std::vector<uint8_t>& rgba, VkExtent2D extent, VkExtent2D& next) {
+          next = { std::max(extent.width / 2, 1u), std::max(extent.height / 2, 1u) };
+          std::vector<uint8_t> out(static_cast<size_t>(next.width) * next.height * 4);
+          // a row pair is decoded to linear at a time, averaged, and encoded back as one output row
+          size_t             row = static_cast<size_t>(extent.width) * 4;
+          std::vector<float> linear0(row), linear1(row), average(static_cast<size_t>(next.width) * 4);
+          for (uint32_t y = 0; y != next.height; ++y) {
+               uint32_t y0 = std::min(2 * y, extent.height - 1), y1 = std::min(2 * y + 1, extent.height - 1);
+               auto*    src0 = &rgba[y0 * row];
+               auto*    src1 = &rgba[y1 * row];
+               PixelConvert::toLinear(src0, linear0.data(), row);
+               PixelConvert::toLinear(src1, linear1.data(), row);
+               for (uint32_t x = 0; x != next.width; ++x) {
+                    size_t x0 = std::min(2 * x, extent.width - 1) * size_t { 4 }, x1 = std::min(2 * x + 1, extent.width - 1) * size_t { 4 };
+                    for (size_t c = 0; c != 4; ++c)
+                         average[x * 4 + c] = (linear0[x0 + c] + linear0[x1 + c] + linear1[x0 + c] + linear1[x1 + c]) * .25f;
+               }
+               auto* dst = &out[static_cast<size_t>(y) * next.width * 4];
+               PixelConvert::toSrgb(average.data(), dst, average.size());
+               // alpha is linear already, average the stored values
+               for (uint32_t x = 0; x != next.width; ++x) {
+                    size_t x0 = std::min(2 * x, extent.width - 1) * size_t { 4 } + 3, x1 = std::min(2 * x + 1, extent.width - 1) * size_t { 4 } + 3;
+                    dst[x * 4 + 3] = static_cast<uint8_t>((src0[x0] + src0[x1] + src1[x0] + src1[x1] + 2) / 4);
+               }
+          }
+          return out;
+     }
+
+     // Drops the `count` largest levels so a smaller copy can be uploaded out of the same bytes. Only
+     // chains stored in full can be trimmed; at least the smallest level is always kept. Returns where
+     // the first kept level starts, the remaining level offsets are made relative to it.
+     static VkDeviceSize dropLevels(TextureData& data, uint32_t count) {
+          count = std::min(count, static_cast<uint32_t>(data.levels.size()) - 1);
+          if (data.generateMips || count == 0)
+               return 0;
+          data.levels.erase(data.levels.begin(), data.levels.begin() + count);
+          auto first = data.levels.front().offset;
+          for (auto& level : data.levels)
+               level.offset -= first;
+          data.extent    = data.levels.front().extent;
+          data.mipLevels = static_cast<uint32_t>(data.levels.size());
+          return first;
+     }
+
+     // Builds the upload image in `format` from decoded RGBA8 pixels. Block-compressed formats need the
+     // whole chain encoded on the CPU, plain RGBA8 only needs it when the GPU cannot blit it (cpuMips).
+     static TextureData fromRGBA(std::vector<uint8_t> rgba, VkExtent2D extent, VkFormat format, bool mips, bool cpuMips) {
+          return fromRGBA(std::move(rgba), extent, format, mips, cpuMips, [](size_t) -> uint8_t* { return nullptr; });
+     }
+
+     // Same, but the levels are written straight into the memory `allocate` hands out for all of them,
+     // which may be mapped staging memory. When it declines with nullptr they go to `bytes` instead.
+     template <typename Allocate>
+     static TextureData fromRGBA(std::vector<uint8_t> rgba, VkExtent2D extent, VkFormat format, bool mips, bool cpuMips, Allocate allocate) {
+          TextureData data {
+               .format       = format,
+               .extent       = extent,
+               .mipLevels    = mips ? mipCount(extent) : 1,
+               .generateMips = mips && !cpuMips && !isBlockCompressed(format),
+               .opaque       = BlockCompression::isOpaque(rgba.data(), static_cast<size_t>(extent.width) * extent.height)
+          };
+          uint32_t storedLevels = data.generateMips ? 1 : data.mipLevels;
+          auto     codec        = format == VK_FORMAT_BC1_RGB_SRGB_BLOCK ? BlockCompression::BC1 : BlockCompression::BC7;
+
+          // the layout is known before any level exists, so the destination is allocated once
+          VkDeviceSize total { 0 };
+          for (auto size = extent; data.levels.size() != storedLevels; size = { std::max(size.width / 2, 1u), std::max(size.height / 2, 1u) }) {
+               VkDeviceSize bytes = isBlockCompressed(format) ? BlockCompression::compressedSize(codec, size.width, size.height) : VkDeviceSize { size.width } * size.height * 4;
+               data.levels.push_back({ .offset = total, .size = bytes, .extent = size });
+               // keep every level offset 16 byte aligned, a multiple of both texel and block sizes
+               total = (total + bytes + 15) & ~VkDeviceSize { 15 };
+          }
+          uint8_t* out = allocate(total);
+          if (out == nullptr) {
+               data.bytes.resize(total);
+               out = data.bytes.data();
+          }
+
+          auto level = std::move(rgba);
+          auto size  = extent;
+          for (auto& entry : data.levels) {
+               if (&entry != &data.levels.front())
+                    level = downsample(level, size, size);
+               if (isBlockCompressed(format))
+                    BlockCompression::compress(codec, level.data(), size.width, size.height, out + entry.offset);
+               else
+                    std::memcpy(out + entry.offset, level.data(), level.size());
+               std::memset(out + entry.offset + entry.size, 0, ((entry.size + 15) & ~VkDeviceSize { 15 }) - entry.size);
+          }
+          return data;
+     }
+};
@@ -0,0 +1,386 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "CommandPool.hpp"
+#include "Core.hpp"
+#include "Device.hpp"
+#include "StagingArena.hpp"
+#include "Texture.hpp"
+#include "TextureContainer.hpp"
+#include "TextureTable.hpp"
+#include "JobSystem.hpp"
+
+#include <fmt/core.h>
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Loads textures without blocking the render thread. request() hands out a table slot right away that
+// samples a placeholder; decoding and mip / block encoding run on the job system, and pump() batches
+// the finished images into one fenced upload per frame. Once that upload's fence has signalled the slot
+// is repointed through the texture table, so shaders see either the placeholder or the full image.
+// Jobs write their upload straight into a persistently mapped staging arena; only when it is full do
+// they keep the bytes in memory of their own and the render thread copies them into a staging buffer of
+// the batch. Either way the job has read the file, so the render thread never faults in a mapping.
+class TextureStreamer {
+     // The upload lives in `staging` when the arena had room, otherwise in `data`.
+     struct Decoded {
+          uint32_t                 slot;
+          uint64_t                 ticket;
+          TextureData              data;
+          StagingArena::Allocation staging;
+
+          // as laid out in staging memory, each upload starting 16 byte aligned
+          VkDeviceSize size() const { return align(staging ? staging.size : data.bytes.size()); }
+     };
+     // Shared with the decode jobs so a job finishing after the streamer is gone has somewhere to go.
+     // Jobs that start after closing return without touching the arena, running ones are waited for.
+     struct Inbox {
+          std::mutex              mutex;
+          std::condition_variable idle;
+          std::vector<Decoded>    decoded;
+          size_t                  running { 0 };
+          bool                    closed { false };
+     };
+     struct Entry {
+          std::string              path;
+          uint64_t                 ticket;
+          uint32_t                 skipMips;
+          bool                     loading;
+          bool                     failed;
+          std::unique_ptr<Texture> texture;
+     };
+     struct Batch {
+          VkFence                                                                fence;
+          CommandBuffer                                                          commandBuffer;
+          std::optional<Buffer<uint8_t>>                                         staging;
+          std::vector<StagingArena::Allocation>                                  arena;
+          std::vector<std::tuple<uint32_t, uint64_t, std::unique_ptr<Texture>>> textures;
+     };
+
+  public:
+     TextureStreamer(Core* core, Device* device, CommandPool* commandPool, TextureTable* textureTable, JobSystem* jobs, size_t maxFramesInFlight, VkDeviceSize uploadBudget = 32 << 20)
+        : core_(core)
+        , device_(device)
+        , commandPool_(commandPool)
+        , textureTable_(textureTable)
+        , jobs_(jobs)
+        , maxFramesInFlight_(maxFramesInFlight)
+        , uploadBudget_(uploadBudget)
+        , formatSupport_(Texture::formatSupport(device))
+        , placeholder_(core, device, commandPool, placeholderData())
+        , arena_(core, device, commandPool) {}
+
+     ~TextureStreamer() {
+          {
+               std::unique_lock lock(inbox_->mutex);
+               inbox_->closed = true;
+               inbox_->idle.wait(lock, [this] { return inbox_->running == 0; });
+          }
+          for (auto& batch : batches_) {
+               vkWaitForFences(device_->logical(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+               vkDestroyFence(device_->logical(), batch.fence, core_->allocator());
+          }
+     }
+     TextureStreamer(const TextureStreamer&)            = delete;
+     TextureStreamer(TextureStreamer&&)                 = delete;
+     TextureStreamer& operator=(const TextureStreamer&) = delete;
+     TextureStreamer& operator=(TextureStreamer&&)      = delete;
+
+     uint32_t request(const std::string& path, uint32_t skipMips = 0) {
+          auto slot = textureTable_->add(&placeholder_);
+          entries_[slot] = Entry { .path = path, .ticket = 0, .skipMips = 0, .loading = false, .failed = false, .texture = nullptr };
+          reload(slot, skipMips);
+          return slot;
+     }
+
+     // Loads the slot's image again without its `skipMips` largest levels. Whatever is resident keeps
+     // being sampled until the new copy lands, a load already in flight is superseded.
+     void reload(uint32_t slot, uint32_t skipMips) {
+          auto& entry    = entries_.at(slot);
+          auto  ticket   = ++tickets_;
+          entry.ticket   = ticket;
+          entry.skipMips = skipMips;
+          entry.loading  = true;
+          entry.failed   = false;
+          jobs_->submit([inbox = inbox_, arena = &arena_, support = formatSupport_, path = entry.path, slot, ticket, skipMips] {
+               {
+                    std::unique_lock lock(inbox->mutex);
+                    if (inbox->closed)
+                         return;
+                    ++inbox->running;
+               }
+               Decoded decoded { .slot = slot, .ticket = ticket, .data = {}, .staging = {} };
+               try {
+                    load(decoded, *arena, support, path, skipMips);
+               }
+               catch (const std::exception& e) {
+                    fmt::print("failed to stream {}: {}\n", path, e.what());
+                    // no levels marks the failure, so the slot stops waiting for it
+                    if (decoded.staging)
+                         arena->release(decoded.staging);
+                    decoded = Decoded { .slot = slot, .ticket = ticket, .data = {}, .staging = {} };
+               }
+               std::unique_lock lock(inbox->mutex);
+               if (!inbox->closed)
+                    inbox->decoded.push_back(std::move(decoded));
+               --inbox->running;
+               inbox->idle.notify_all();
+          });
+     }
+
+     // Drops the image but keeps the slot, which samples the placeholder until reload() is called.
+     void evict(uint32_t slot) {
+          auto& entry = entries_.at(slot);
+          entry.ticket  = ++tickets_;
+          entry.loading = false;
+          if (entry.texture) {
+               textureTable_->set(slot, &placeholder_);
+               retire(std::move(entry.texture));
+          }
+     }
+
+     // The texture is kept alive until every frame that could still sample it has finished.
+     void release(uint32_t slot) {
+          auto entry = entries_.find(slot);
+          if (entry == entries_.end())
+               return;
+          if (entry->second.texture)
+               retire(std::move(entry->second.texture));
+          entries_.erase(entry);
+          textureTable_->remove(slot);
+     }
+
+     bool resident(uint32_t slot) {
+          auto entry = entries_.find(slot);
+          return entry != entries_.end() && entry->second.texture != nullptr;
+     }
+     bool loading(uint32_t slot) {
+          auto entry = entries_.find(slot);
+          return entry != entries_.end() && entry->second.loading;
+     }
+     bool failed(uint32_t slot) {
+          auto entry = entries_.find(slot);
+          return entry != entries_.end() && entry->second.failed;
+     }
+     uint32_t     skipMips(uint32_t slot) { return entries_.at(slot).skipMips; }
+     uint32_t     mipLevels(uint32_t slot) {
+          auto& entry = entries_.at(slot);
+          return entry.texture ? entry.texture->mipLevels() : 0;
+     }
+     VkDeviceSize bytes(uint32_t slot) {
+          auto& entry = entries_.at(slot);
+          return entry.texture ? entry.texture->memorySize() : 0;
+     }
+     VkDeviceSize residentBytes() { return residentBytes_; }
+
+     // Called once per frame on the render thread, never waits on the GPU.
+     void pump() {
+          ++pumps_;
+          std::erase_if(retired_, [this](const auto& retired) { return retired.second <= pumps_; });
+
+          // one queue, so batches complete in submission order
+          while (!batches_.empty() && vkGetFenceStatus(device_->logical(), batches_.front().fence) == VK_SUCCESS) {
+               auto& batch = batches_.front();
+               for (auto& [slot, ticket, texture] : batch.textures) {
+                    auto entry = entries_.find(slot);
+                    if (entry == entries_.end() || entry->second.ticket != ticket)
+                         continue;
+                    textureTable_->set(slot, texture.get());
+                    if (entry->second.texture)
+                         retire(std::move(entry->second.texture));
+                    residentBytes_ += texture->memorySize();
+                    entry->second.texture = std::move(texture);
+                    entry->second.loading = false;
+               }
+               for (auto& allocation : batch.arena)
+                    arena_.release(allocation);
+               vkDestroyFence(device_->logical(), batch.fence, core_->allocator());
+               batches_.pop_front();
+          }
+
+          {
+               std::unique_lock lock(inbox_->mutex);
+               for (auto& decoded : inbox_->decoded)
+                    queued_.push_back(std::move(decoded));
+               inbox_->decoded.clear();
+          }
+          std::erase_if(queued_, [this](const Decoded& decoded) {
+               auto entry = entries_.find(decoded.slot);
+               if (entry == entries_.end() || entry->second.ticket != decoded.ticket) {
+                    if (decoded.staging)
+                         arena_.release(decoded.staging);
+                    return true;
+               }
+               if (decoded.data.levels.empty()) {
+                    entry->second.loading = false;
+                    entry->second.failed  = true;
+                    return true;
+               }
+               return false;
+          });
+          if (queued_.empty())
+               return;
+
+          // always take at least one image so one larger than the budget still gets through
+          size_t       count { 0 };
+          VkDeviceSize total { 0 };
+          VkDeviceSize fallback { 0 };
+          while (count != queued_.size() && (count == 0 || total + queued_[count].size() <= uploadBudget_)) {
+               total += queued_[count].size();
+               if (!queued_[count].staging)
+                    fallback += queued_[count].size();
+               ++count;
+          }
+
+          Batch batch {
+               .fence         = VK_NULL_HANDLE,
+               .commandBuffer = commandPool_->createCommandBuffer(),
+               .staging       = std::nullopt,
+               .arena         = {},
+               .textures      = {}
+          };
+          if (fallback != 0)
+               batch.staging.emplace(Buffer<uint8_t>::makeUpload(core_, device_, commandPool_, fallback));
+
+          batch.commandBuffer.begin();
+          VkDeviceSize offset { 0 };
+          for (size_t i = 0; i != count; ++i) {
+               auto& decoded = queued_[i];
+               auto& layout  = decoded.data;
+               auto  texture = std::make_unique<Texture>(core_, device_, commandPool_, layout.extent, layout.format, layout.mipLevels);
+               if (decoded.staging) {
+                    texture->recordUpload(batch.commandBuffer.get(), arena_.buffer(), decoded.staging.offset, layout);
+                    batch.arena.push_back(decoded.staging);
+               }
+               else {
+                    batch.staging->write(layout.bytes.data(), layout.bytes.size(), offset);
+                    texture->recordUpload(batch.commandBuffer.get(), batch.staging->get(), offset, layout);
+                    offset += decoded.size();
+               }
+               batch.textures.emplace_back(decoded.slot, decoded.ticket, std::move(texture));
+          }
+          batch.commandBuffer.end();
+          queued_.erase(queued_.begin(), queued_.begin() + static_cast<std::ptrdiff_t>(count));
+
+          VkFenceCreateInfo vkFenceCreateInfo {
+               .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+               .pNext = nullptr,
+               .flags = {}
+          };
+          if (vkCreateFence(device_->logical(), &vkFenceCreateInfo, core_->allocator(), &batch.fence) != VK_SUCCESS)
+               throw std::runtime_error("call to vkCreateFence failed");
+
+          VkSubmitInfo submitInfo {
+               .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+               .pNext                = nullptr,
+               .waitSemaphoreCount   = 0,
+               .pWaitSemaphores      = nullptr,
+               .pWaitDstStageMask    = nullptr,
+               .commandBufferCount   = 1,
+               .pCommandBuffers      = &batch.commandBuffer.get(),
+               .signalSemaphoreCount = 0,
+               .pSignalSemaphores    = nullptr
+          };
+          if (vkQueueSubmit(device_->graphics(), 1, &submitInfo, batch.fence) != VK_SUCCESS)
+               throw std::runtime_error("call to vkQueueSubmit failed");
+
+          batches_.push_back(std::move(batch));
+     }
+
+     auto& placeholder() { return placeholder_; }
+
+  private:
+     // A pre-transcoded container next to the source image wins over decoding it, as long as the
+     // device can sample the format it was transcoded to.
+     // When nothing can be encoded and the GPU builds the mips, the image is decoded straight into the
+     // arena. Everything else is copied in once complete, still on the worker.
+     static void load(Decoded& out, StagingArena& arena, const Texture::FormatSupport& support, const std::string& path, uint32_t skipMips) {
+          auto packed = std::filesystem::path(path).replace_extension(".ctex");
+          if (std::filesystem::exists(packed)) {
+               TextureContainer container(packed.string());
+               if (support.samples(container.layout().format)) {
+                    out.data   = container.layout();
+                    auto first = TextureData::dropLevels(out.data, skipMips);
+                    keep(out, arena, container.payload().subspan(first, out.data.levels.back().offset + out.data.levels.back().size));
+                    return;
+               }
+               if (packed == path)
+                    throw std::runtime_error(path + " holds a format the device cannot sample");
+          }
+
+          if (!support.bc1 && !support.bc7 && support.blitRGBA && skipMips == 0) {
+               VkExtent2D extent {};
+               bool       opaque {};
+               auto       direct = TextureData::decode(path, extent, opaque, [&out, &arena](size_t size) {
+                    out.staging = arena.allocate(size);
+                    return out.staging.data;
+               });
+               if (direct) {
+                    out.data = TextureData {
+                         .format       = VK_FORMAT_R8G8B8A8_SRGB,
+                         .extent       = extent,
+                         .mipLevels    = TextureData::mipCount(extent),
+                         .generateMips = true,
+                         .opaque       = opaque,
+                         .levels       = { { .offset = 0, .size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4, .extent = extent } },
+                         .bytes        = {}
+                    };
+                    return;
+               }
+          }
+          out.data = Texture::import(support, path, true, skipMips, [&out, &arena](size_t size) {
+               out.staging = arena.allocate(size);
+               return out.staging.data;
+          });
+     }
+
+     // Copies a container's levels out of its mapping, into the arena if there is room and into the
+     // upload's own memory otherwise, so the mapping can be closed here.
+     static void keep(Decoded& out, StagingArena& arena, std::span<const uint8_t> bytes) {
+          out.staging = arena.allocate(bytes.size());
+          if (out.staging)
+               std::memcpy(out.staging.data, bytes.data(), bytes.size());
+          else
+               out.data.bytes.assign(bytes.begin(), bytes.end());
+     }
+
+     void retire(std::unique_ptr<Texture> texture) {
+          residentBytes_ -= texture->memorySize();
+          retired_.push_back({ std::move(texture), pumps_ + maxFramesInFlight_ });
+     }
+
+     static VkDeviceSize align(VkDeviceSize size) { return (size + 15) & ~VkDeviceSize { 15 }; }
+
+     // A single mid grey texel, close enough to most content to keep the first frames calm.
+     static TextureData placeholderData() {
+          return TextureData::fromRGBA({ 128, 128, 128, 255 }, { 1, 1 }, VK_FORMAT_R8G8B8A8_SRGB, false, true);
+     }
+
+     Core*                      core_;
+     Device*                    device_;
+     CommandPool*               commandPool_;
+     TextureTable*              textureTable_;
+     JobSystem*                 jobs_;
+     size_t                     maxFramesInFlight_;
+     VkDeviceSize               uploadBudget_;
+     Texture::FormatSupport     formatSupport_;
+     Texture                    placeholder_;
+     StagingArena               arena_;
+     std::shared_ptr<Inbox>     inbox_ { std::make_shared<Inbox>() };
+     uint64_t                   tickets_ { 0 };
+     VkDeviceSize               residentBytes_ { 0 };
+     size_t                     pumps_ { 0 };
+
+     std::unordered_map<uint32_t, Entry>                    entries_;
+     std::deque<Decoded>                                    queued_;
+     std::deque<Batch>                                      batches_;
+     std::vector<std::pair<std::unique_ptr<Texture>, size_t>> retired_;
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "DescriptorSets.hpp"
+#include "Texture.hpp"
+
+#include <mutex>
+#include <vector>
+
+// Slot allocator over the bindless texture array. Every frame in flight owns its own descriptor set;
+// writes are queued per frame and applied in flush() once that frame's fence has been waited on, so a
+// set is never modified while the GPU may still read it and repointing a slot is seen atomically.
+// Slots may be added, set and removed from any thread; flush() and setStorage() are the drawing
+// thread's.
+class TextureTable {
+  public:
+     TextureTable(Core* core, Device* device, DescriptorPool* descriptorPool, size_t maxFramesInFlight, uint32_t capacity)
+        : core_(core)
+        , device_(device)
+        , capacity_(capacity)
+        , descriptorSets_(descriptorPool->createDescriptorSets(maxFramesInFlight))
+        , pending_(maxFramesInFlight)
+        , storage_(maxFramesInFlight, VK_NULL_HANDLE) {}
+
+     uint32_t add(Texture* texture) { return add(texture->view(), texture->sampler()); }
+
+     uint32_t add(VkImageView view, VkSampler sampler) {
+          std::lock_guard lock(mutex_);
+          uint32_t        slot;
+          if (!free_.empty()) {
+               slot = free_.back();
+               free_.pop_back();
+          }
+          else if (next_ != capacity_)
+               slot = next_++;
+          else
+               throw std::runtime_error("texture table is full");
+          write(slot, view, sampler);
+          return slot;
+     }
+
+     void set(uint32_t slot, Texture* texture) { set(slot, texture->view(), texture->sampler()); }
+
+     void set(uint32_t slot, VkImageView view, VkSampler sampler) {
+          std::lock_guard lock(mutex_);
+          write(slot, view, sampler);
+     }
+
+     // Bumped whenever a slot is pointed at another image, so anything that baked a slot's contents
+     // (layers, for one) can tell it is stale.
+     uint32_t generation(uint32_t slot) {
+          std::lock_guard lock(mutex_);
+          return slot < generations_.size() ? generations_[slot] : 0;
+     }
+
+     // Points binding 1 of frame `frame`'s set at `buffer`, for a frame whose fence has been waited on.
+     void setStorage(size_t frame, VkBuffer buffer) {
+          if (storage_[frame] == buffer)
+               return;
+          VkDescriptorBufferInfo descriptorBufferInfo {
+               .buffer = buffer,
+               .offset = 0,
+               .range  = VK_WHOLE_SIZE
+          };
+          VkWriteDescriptorSet writeDescriptorSet {
+               .sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+               .pNext            = nullptr,
+               .dstSet           = descriptorSets_[frame],
+               .dstBinding       = 1,
+               .dstArrayElement  = 0,
+               .descriptorCount  = 1,
+               .descriptorType   = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+               .pImageInfo       = nullptr,
+               .pBufferInfo      = &descriptorBufferInfo,
+               .pTexelBufferView = nullptr
+          };
+          vkUpdateDescriptorSets(device_->logical(), 1, &writeDescriptorSet, 0, nullptr);
+          storage_[frame] = buffer;
+     }
+
+     // The slot becomes reusable once every frame that could still sample it has been flushed again.
+     void remove(uint32_t slot) {
+          std::lock_guard lock(mutex_);
+          retiring_.push_back({ slot, flushes_ + pending_.size() });
+     }
+
+     VkDescriptorSet flush(size_t frame) {
+          std::lock_guard lock(mutex_);
+          auto&           writes = pending_[frame];
+          if (!writes.empty()) {
+               std::vector<VkWriteDescriptorSet> writeDescriptorSets;
+               writeDescriptorSets.reserve(writes.size());
+               for (auto& [slot, descriptorImageInfo] : writes)
+                    writeDescriptorSets.push_back(VkWriteDescriptorSet {
+                       .sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                       .pNext            = nullptr,
+                       .dstSet           = descriptorSets_[frame],
+                       .dstBinding       = 0,
+                       .dstArrayElement  = slot,
+                       .descriptorCount  = 1,
+                       .descriptorType   = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                       .pImageInfo       = &descriptorImageInfo,
+                       .pBufferInfo      = nullptr,
+                       .pTexelBufferView = nullptr });
+               vkUpdateDescriptorSets(device_->logical(), static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+               writes.clear();
+          }
+
+          ++flushes_;
+          std::erase_if(retiring_, [this](const auto& retiring) {
+               if (retiring.second > flushes_)
+                    return false;
+               free_.push_back(retiring.first);
+               return true;
+          });
+          return descriptorSets_[frame];
+     }
+
+     auto capacity() { return capacity_; }
+     auto size() {
+          std::lock_guard lock(mutex_);
+          return next_ - static_cast<uint32_t>(free_.size() + retiring_.size());
+     }
+
+  private:
+     void write(uint32_t slot, VkImageView view, VkSampler sampler) {
+          VkDescriptorImageInfo descriptorImageInfo {
+               .sampler     = sampler,
+               .imageView   = view,
+               .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+          };
+          for (auto& writes : pending_)
+               writes.push_back({ slot, descriptorImageInfo });
+          if (slot >= generations_.size())
+               generations_.resize(slot + 1);
+          ++generations_[slot];
+     }
+
+     Core*    core_;
+     Device*  device_;
+     uint32_t capacity_;
+     uint32_t next_ { 0 };
+     size_t   flushes_ { 0 };
+
+     std::vector<VkDescriptorSet>                                          descriptorSets_;
+     std::vector<std::vector<std::pair<uint32_t, VkDescriptorImageInfo>>> pending_;
+     std::vector<std::pair<uint32_t, size_t>>                              retiring_;
+     std::vector<uint32_t>                                                 free_;
+     std::vector<uint32_t>                                                 generations_;
+     std::vector<VkBuffer>                                                 storage_;
+     std::mutex                                                            mutex_;
+};
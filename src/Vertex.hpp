@@ -11,6 +11,7 @@ struct Vertex {
      glm::vec3 position;
      glm::vec3 color;
      glm::vec2 textureCoordinate;
+     uint32_t  texture;
 
      static VkVertexInputBindingDescription bindingDescription() {
           VkVertexInputBindingDescription bindingDescription {
@@ -37,7 +38,55 @@ struct Vertex {
                   .location = 2,
                   .binding  = 0,
                   .format   = VK_FORMAT_R32G32_SFLOAT,
-                  .offset   = offsetof(Vertex, textureCoordinate) }
+                  .offset   = offsetof(Vertex, textureCoordinate) },
+               VkVertexInputAttributeDescription {
+                  .location = 3,
+                  .binding  = 0,
+                  .format   = VK_FORMAT_R32_UINT,
+                  .offset   = offsetof(Vertex, texture) }
+          };
+          return attributeDescriptions;
+     }
+};
+
+// 2D draw list vertex, in NDC like Vertex. The colour is packed RGBA, sRGB encoded.
+struct Vertex2D {
+     glm::vec2 position;
+     glm::vec2 textureCoordinate;
+     uint32_t  color;
+     uint32_t  texture;
+
+     static VkVertexInputBindingDescription bindingDescription() {
+          VkVertexInputBindingDescription bindingDescription {
+               .binding   = 0,
+               .stride    = sizeof(Vertex2D),
+               .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+          };
+          return bindingDescription;
+     }
+
+     static auto attributeDescriptions() {
+          std::array attributeDescriptions {
+               VkVertexInputAttributeDescription {
+                  .location = 0,
+                  .binding  = 0,
+                  .format   = VK_FORMAT_R32G32_SFLOAT,
+                  .offset   = offsetof(Vertex2D, position) },
+               VkVertexInputAttributeDescription {
+                  .location = 1,
+                  .binding  = 0,
+                  .format   = VK_FORMAT_R32G32_SFLOAT,
+                  .offset   = offsetof(Vertex2D, textureCoordinate) },
+               VkVertexInputAttributeDescription {
+                  .location = 2,
+                  .binding  = 0,
+                  .format   = VK_FORMAT_R8G8B8A8_UNORM,
+                  .offset   = offsetof(Vertex2D, color) },
+               VkVertexInputAttributeDescription {
+                  .location = 3,
+                  .binding  = 0,
+                  .format   = VK_FORMAT_R32_UINT,
+                  .offset   = offsetof(Vertex2D, texture) }
           };
           return attributeDescriptions;
      }
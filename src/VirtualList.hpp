@@ -0,0 +1,377 @@
+#pragma once
+
+#include "DrawList.hpp"
+#include "Text.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Row offsets as multiples of the estimate, plus what the rows that differ from it add. Only those
+// rows are stored, in a map, and their additions are summed per block of BLOCK rows in a Fenwick tree
+// over the blocks: the top of a row and the row at an offset cost O(log n) and a walk through the
+// differing rows of one block, and so does changing one height. Beyond the rows that differ the
+// index holds one double per block, and nothing at all until a row differs.
+class RowIndex {
+     static constexpr size_t BLOCK = 256;
+
+  public:
+     explicit RowIndex(float estimate)
+        : estimate_(estimate) {}
+
+     void resize(size_t rows) {
+          rows_ = rows;
+          heights_.erase(heights_.lower_bound(rows), heights_.end());
+          if (heights_.empty())
+               tree_.clear();
+          else
+               build();
+     }
+
+     void set(size_t row, float height) {
+          auto   found = heights_.find(row);
+          double delta = static_cast<double>(height) - (found == heights_.end() ? estimate_ : found->second);
+          if (delta == 0.)
+               return;
+          if (height == estimate_)
+               heights_.erase(found);
+          else
+               heights_.insert_or_assign(row, height);
+          if (tree_.empty())
+               build();
+          else
+               for (auto i = row / BLOCK + 1; i < tree_.size(); i += lowBit(i))
+                    tree_[i] += delta;
+     }
+
+     size_t rows() const { return rows_; }
+     float  height(size_t row) const {
+          auto found = heights_.find(row);
+          return found == heights_.end() ? estimate_ : found->second;
+     }
+
+     // Top of `row`, rows() gives the total height.
+     double offset(size_t row) const {
+          double sum = static_cast<double>(row) * estimate_;
+          if (tree_.empty())
+               return sum;
+          for (auto i = row / BLOCK; i != 0; i -= lowBit(i))
+               sum += tree_[i];
+          for (auto it = heights_.lower_bound(row / BLOCK * BLOCK); it != heights_.end() && it->first < row; ++it)
+               sum += static_cast<double>(it->second) - estimate_;
+          return sum;
+     }
+
+     // Row whose span holds `y`, clamped to the rows there are.
+     size_t find(double y) const {
+          if (rows_ == 0)
+               return 0;
+          if (tree_.empty())
+               return std::min(rows_ - 1, static_cast<size_t>(std::max(0., y / estimate_)));
+          // the block holding y, each tree node covering `bit` whole blocks
+          size_t blocks = tree_.size() - 1, block { 0 };
+          for (auto bit = std::bit_floor(blocks); bit != 0; bit /= 2) {
+               if (block + bit > blocks)
+                    continue;
+               if (auto span = tree_[block + bit] + static_cast<double>(bit * BLOCK) * estimate_; span <= y) {
+                    block += bit;
+                    y -= span;
+               }
+          }
+          // then the runs of estimated rows and the differing rows between them
+          size_t row = block * BLOCK, end = std::min(rows_, row + BLOCK);
+          for (auto it = heights_.lower_bound(row); row < end; ++it) {
+               auto next = it != heights_.end() && it->first < end ? it->first : end;
+               auto run  = static_cast<double>(next - row) * estimate_;
+               if (y < run)
+                    return std::min(next - 1, row + static_cast<size_t>(std::max(0., y / estimate_)));
+               y -= run;
+               row = next;
+               if (row == end || y < it->second)
+                    break;
+               y -= it->second;
+               ++row;
+          }
+          return std::min(row, rows_ - 1);
+     }
+
+  private:
+     static size_t lowBit(size_t i) { return i & (~i + 1); }
+
+     void build() {
+          tree_.assign((rows_ + BLOCK - 1) / BLOCK + 1, 0.);
+          for (auto [row, height] : heights_)
+               tree_[row / BLOCK + 1] += static_cast<double>(height) - estimate_;
+          for (size_t i = 1; i < tree_.size(); ++i)
+               if (auto parent = i + lowBit(i); parent < tree_.size())
+                    tree_[parent] += tree_[i];
+     }
+
+     float                   estimate_;
+     size_t                  rows_ { 0 };
+     std::map<size_t, float> heights_;
+     std::vector<double>     tree_;
+};
+
+// Scrolling table over rows a provider hands out on demand. Only the rows in view and OVERSCAN rows
+// past either edge are materialized, into slots that are recycled as rows scroll out, and only the
+// cells of visible columns are fetched; the text itself is shaped once by Text's run cache. Rows
+// keep their place when heights above them change: scrolling is tracked as a row and an offset
+// into it. Draws into a DrawList, so whoever owns the list redraws it after scroll() or a change.
+class VirtualList {
+     static constexpr uint32_t NONE32 = ~0u;
+     // rows materialized past each edge of the viewport
+     static constexpr size_t OVERSCAN = 8;
+
+     struct Slot {
+          size_t                    row { NONE };
+          std::vector<std::wstring> cells;
+          std::vector<uint8_t>      fetched;
+     };
+
+  public:
+     static constexpr size_t NONE = ~size_t { 0 };
+
+     struct Provider {
+          std::function<size_t()> rows;
+          // called for cells that come into view
+          std::function<void(size_t row, size_t column, std::wstring& text)> cell;
+          // called for rows that come into view; without it every row is Style::rowHeight high
+          std::function<float(size_t row)> height;
+     };
+
+     struct Style {
+          Text::Font      font;
+          float           fontSize { 14.f };
+          float           rowHeight { 20.f };
+          float           padding { 6.f };
+          DrawList::Color text { DrawList::rgba(220, 220, 220) };
+          DrawList::Color background { DrawList::rgba(32, 32, 36) };
+          DrawList::Color stripe { DrawList::rgba(40, 40, 46) };
+          DrawList::Color selection { DrawList::rgba(60, 90, 140) };
+     };
+
+     struct Stats {
+          size_t rows;
+          size_t first;
+          size_t last;
+          size_t slots;
+          size_t fetched;
+          size_t recycled;
+     };
+
+     VirtualList(Text* text, Provider provider, const Style& style)
+        : text_(text)
+        , provider_(std::move(provider))
+        , style_(style)
+        , index_(style.rowHeight) {
+          index_.resize(provider_.rows());
+     }
+     VirtualList(const VirtualList&)            = delete;
+     VirtualList(VirtualList&&)                 = delete;
+     VirtualList& operator=(const VirtualList&) = delete;
+     VirtualList& operator=(VirtualList&&)      = delete;
+
+     // In window pixels.
+     void setViewport(glm::vec2 position, glm::vec2 size) {
+          position_ = position;
+          size_     = size;
+     }
+
+     // Without columns the one column spans the viewport.
+     void setColumns(std::vector<float> widths) {
+          widths_ = std::move(widths);
+          for (auto& slot : slots_)
+               slot.row = NONE;
+     }
+
+     void scroll(glm::vec2 delta) {
+          anchorOffset_ += delta.y;
+          scrollX_ += delta.x;
+     }
+     void scrollToRow(size_t row) {
+          anchor_       = std::min(row, index_.rows());
+          anchorOffset_ = 0.;
+     }
+
+     // The provider's rows changed, all of them are fetched again.
+     void refresh() {
+          auto top = index_.offset(anchor_) + anchorOffset_;
+          index_.resize(provider_.rows());
+          for (auto& slot : slots_)
+               slot.row = NONE;
+          anchor_       = index_.find(top);
+          anchorOffset_ = top - index_.offset(anchor_);
+     }
+     // One row changed; it is fetched again if it is materialized.
+     void invalidate(size_t row) {
+          if (row >= rangeFirst_ && row - rangeFirst_ < range_.size())
+               slots_[range_[row - rangeFirst_]].row = NONE;
+     }
+
+     void   select(size_t row) { selected_ = row; }
+     size_t selected() { return selected_; }
+
+     // Row under `point`, or NONE outside the rows.
+     size_t rowAt(glm::vec2 point) {
+          if (point.x < position_.x || point.y < position_.y || point.x >= position_.x + size_.x || point.y >= position_.y + size_.y)
+               return NONE;
+          auto y = top() + (point.y - position_.y);
+          return y < index_.offset(index_.rows()) ? index_.find(y) : NONE;
+     }
+
+     void draw(DrawList& list) {
+          update();
+          if (range_.empty())
+               return;
+          auto   top   = this->top();
+          auto   first = index_.find(top);
+          size_t last  = first;
+          while (last + 1 < index_.rows() && index_.offset(last + 1) < top + size_.y)
+               ++last;
+
+          list.pushClip(position_, size_);
+          for (auto row = first; row <= last; ++row) {
+               auto color = row == selected_ ? style_.selection : row % 2 ? style_.stripe : style_.background;
+               list.rect({ position_.x, position_.y + static_cast<float>(index_.offset(row) - top) }, { size_.x, index_.height(row) }, color);
+          }
+          // a clip per column rather than per cell, so each column's text is one batch
+          float x     = position_.x - scrollX_;
+          auto  lines = text_->lineHeight(style_.font, style_.fontSize);
+          for (size_t column = 0; column != columns(); ++column) {
+               auto width = columnWidth(column);
+               if (x + width > position_.x && x < position_.x + size_.x) {
+                    list.pushClip({ x, position_.y }, { width, size_.y });
+                    for (auto row = first; row <= last; ++row) {
+                         auto& text = cell(row, column);
+                         if (text.empty())
+                              continue;
+                         auto y = position_.y + static_cast<float>(index_.offset(row) - top) + (index_.height(row) - lines) / 2.f;
+                         text_->draw(list, text, style_.font, style_.fontSize, { x + style_.padding, y }, style_.text);
+                    }
+                    list.popClip();
+               }
+               x += width;
+          }
+          list.popClip();
+          stats_.first = first;
+          stats_.last  = last;
+     }
+
+     Stats stats() {
+          stats_.rows  = index_.rows();
+          stats_.slots = slots_.size();
+          return stats_;
+     }
+
+  private:
+     size_t columns() { return widths_.empty() ? 1 : widths_.size(); }
+     float  columnWidth(size_t column) { return widths_.empty() ? size_.x : widths_[column]; }
+
+     // Clamps the scroll position and re-anchors it to the row now at the top.
+     double top() {
+          auto height = index_.offset(index_.rows());
+          auto top    = std::clamp(index_.offset(anchor_) + anchorOffset_, 0., std::max(0., height - size_.y));
+          float width { 0.f };
+          for (size_t column = 0; column != columns(); ++column)
+               width += columnWidth(column);
+          scrollX_      = std::clamp(scrollX_, 0.f, std::max(0.f, width - size_.x));
+          anchor_       = index_.find(top);
+          anchorOffset_ = top - index_.offset(anchor_);
+          return top;
+     }
+
+     // Moves the materialized range over the rows in view. Heights of rows above are asked first,
+     // since they move the anchor, then of rows down to OVERSCAN past the bottom; rows that stay in
+     // range keep their slot, the others take the slots of rows that left.
+     void update() {
+          auto first = index_.find(top());
+          auto begin = first - std::min(first, OVERSCAN);
+          for (auto row = begin; row != first; ++row)
+               measure(row);
+          auto   top = this->top();
+          auto   end = index_.find(top);
+          size_t below { 0 };
+          for (; end < index_.rows() && below != OVERSCAN; ++end) {
+               measure(end);
+               below += index_.offset(end) >= top + size_.y;
+          }
+
+          next_.assign(end - begin, NONE32);
+          for (size_t i = 0; i != range_.size(); ++i) {
+               auto row = rangeFirst_ + i;
+               if (row >= begin && row < end)
+                    next_[row - begin] = range_[i];
+               else {
+                    free_.push_back(range_[i]);
+                    ++stats_.recycled;
+               }
+          }
+          range_.swap(next_);
+          rangeFirst_ = begin;
+          for (size_t i = 0; i != range_.size(); ++i) {
+               auto& slot = range_[i];
+               if (slot == NONE32) {
+                    if (free_.empty()) {
+                         free_.push_back(static_cast<uint32_t>(slots_.size()));
+                         slots_.emplace_back();
+                    }
+                    slot = free_.back();
+                    free_.pop_back();
+                    slots_[slot].row = NONE;
+               }
+               auto& s = slots_[slot];
+               if (s.row != begin + i) {
+                    s.row = begin + i;
+                    s.cells.resize(columns());
+                    s.fetched.assign(columns(), 0);
+               }
+          }
+     }
+
+     // Asks the height of a row that is not materialized yet, or was invalidated.
+     void measure(size_t row) {
+          if (!provider_.height)
+               return;
+          if (row >= rangeFirst_ && row - rangeFirst_ < range_.size() && slots_[range_[row - rangeFirst_]].row == row)
+               return;
+          index_.set(row, provider_.height(row));
+     }
+
+     const std::wstring& cell(size_t row, size_t column) {
+          auto& slot = slots_[range_[row - rangeFirst_]];
+          if (!slot.fetched[column]) {
+               slot.cells[column].clear();
+               provider_.cell(row, column, slot.cells[column]);
+               slot.fetched[column] = 1;
+               ++stats_.fetched;
+          }
+          return slot.cells[column];
+     }
+
+     Text*    text_;
+     Provider provider_;
+     Style    style_;
+     RowIndex index_;
+
+     glm::vec2 position_ { 0.f, 0.f };
+     glm::vec2 size_ { 0.f, 0.f };
+     size_t    anchor_ { 0 };
+     double    anchorOffset_ { 0. };
+     float     scrollX_ { 0.f };
+     size_t    selected_ { NONE };
+     Stats     stats_ {};
+
+     std::vector<float>    widths_;
+     std::vector<Slot>     slots_;
+     std::vector<uint32_t> free_;
+     std::vector<uint32_t> range_; // slots of rows rangeFirst_ onwards
+     std::vector<uint32_t> next_;
+     size_t                rangeFirst_ { 0 };
+};
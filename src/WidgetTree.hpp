@@ -0,0 +1,704 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "CommandPool.hpp"
+#include "Core.hpp"
+#include "Device.hpp"
+#include "HitGrid.hpp"
+#include "SceneFile.hpp"
+#include "Vertex.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Retained UI tree. Every widget is a rectangle placed relative to its parent, and owns a fixed run
+// of the geometry stream all widgets are drawn from with one draw call. Setters only mark widgets
+// dirty and flag their ancestors, so update() walks just the paths down to what changed and rewrites
+// those runs; publish() hands only the rewritten runs to the thread that draws, whose WidgetBuffers
+// keep the stream on the GPU. Removed and hidden widgets leave degenerate runs behind, the slots are
+// reused by the next widgets created. Shown widgets are also kept in a hit grid, moved along as their
+// runs are rewritten. A small motion record per widget, read by the vertex shader, moves, scales and
+// tints the run without touching it; animations only ever rewrite those.
+class WidgetTree {
+     friend class WidgetBuffers;
+
+     static constexpr uint32_t NONE = ~0u;
+     // a strip run per widget: the corners between two repeated vertices, so neighbouring runs only
+     // form zero area triangles, and ordered so the quad keeps the winding of a lone 4 vertex strip
+     static constexpr size_t RUN = 6;
+
+     struct Node {
+          uint32_t  parent { NONE };
+          uint32_t  firstChild { NONE };
+          uint32_t  lastChild { NONE };
+          uint32_t  next { NONE };
+          uint32_t  previous { NONE };
+          glm::vec2 position {};
+          glm::vec2 size {};
+          glm::vec3 color {};
+          uint32_t  texture { 0 };
+          glm::vec2 offset { 0.f, 0.f };
+          glm::vec2 scale { 1.f, 1.f };
+          glm::vec4 tint { 1.f, 1.f, 1.f, 1.f };
+          bool      visible { true };
+          bool      alive { false };
+          // derived in update()
+          glm::vec2 absolute {};
+          uint32_t  depth { 0 };
+          bool      shown { false };
+          // own run is stale / something below is stale / position, depth or visibility changed, which
+          // the whole subtree follows
+          bool dirty { false };
+          bool subtreeDirty { false };
+          bool transformDirty { false };
+     };
+
+     // std430 element of widget.vert's motion buffer, in NDC
+     struct Motion {
+          glm::vec2 translate;
+          glm::vec2 scale;
+          glm::vec2 pivot;
+          glm::vec2 padding;
+          glm::vec4 tint;
+     };
+
+     // what is waiting for publish()
+     static constexpr uint8_t RUN_QUEUED    = 1;
+     static constexpr uint8_t MOTION_QUEUED = 2;
+
+  public:
+     using Id = uint32_t;
+
+     struct Stats {
+          size_t widgets;
+          size_t regenerated;
+     };
+
+     // Runs and motion records rewritten since the last publish(), each once, as a frame packet
+     // carries them to the thread that draws.
+     struct Changes {
+          size_t              slots; // widgets the stream has room for
+          std::vector<Id>     runs;
+          std::vector<Vertex> vertices; // RUN per entry of runs
+          std::vector<Id>     motions;
+          std::vector<Motion> records;
+
+          void clear() {
+               runs.clear();
+               vertices.clear();
+               motions.clear();
+               records.clear();
+          }
+     };
+
+     explicit WidgetTree(VkExtent2D window)
+        : window_(window) {
+          nodes_.push_back(Node { .size = { static_cast<float>(window.width), static_cast<float>(window.height) }, .alive = true, .shown = true });
+          queued_.push_back(0);
+          stream_.resize(RUN);
+          motions_.resize(1);
+          writeMotion(root());
+     }
+     WidgetTree(const WidgetTree&)            = delete;
+     WidgetTree(WidgetTree&&)                 = delete;
+     WidgetTree& operator=(const WidgetTree&) = delete;
+     WidgetTree& operator=(WidgetTree&&)      = delete;
+
+     // Covers the window and draws nothing itself.
+     Id root() { return 0; }
+
+     // `position` and `size` are in pixels, `position` relative to the parent's corner. Children draw
+     // above their parent; where widgets of the same depth overlap the one with the lower id stays on
+     // top, as runs are drawn in id order and the depth test only passes strictly nearer fragments.
+     // Ids of destroyed widgets are handed out again, so that is not creation order.
+     Id create(Id parent, glm::vec2 position, glm::vec2 size, glm::vec3 color, uint32_t texture = 0) {
+          Id id;
+          if (!free_.empty()) {
+               id = free_.back();
+               free_.pop_back();
+          }
+          else {
+               id = static_cast<Id>(nodes_.size());
+               nodes_.emplace_back();
+               queued_.push_back(0);
+               stream_.resize(stream_.size() + RUN);
+               motions_.emplace_back();
+          }
+          auto& node = nodes_[id];
+          node       = Node { .parent = parent, .position = position, .size = size, .color = color, .texture = texture, .alive = true };
+          link(parent, id);
+          reference(texture, 1);
+          ++widgets_;
+          markTransform(id);
+          return id;
+     }
+
+     // Removes the widget and everything below it.
+     void destroy(Id id) {
+          if (id == root() || !nodes_.at(id).alive)
+               return;
+          unlink(id);
+          std::vector<Id> stack { id };
+          while (!stack.empty()) {
+               auto current = stack.back();
+               stack.pop_back();
+               for (auto child = nodes_[current].firstChild; child != NONE; child = nodes_[child].next)
+                    stack.push_back(child);
+               auto& node = nodes_[current];
+               reference(node.texture, -1);
+               node = Node {};
+               write(current);
+               writeMotion(current);
+               free_.push_back(current);
+               --widgets_;
+          }
+     }
+
+     void setRect(Id id, glm::vec2 position, glm::vec2 size) {
+          auto& node = nodes_.at(id);
+          if (node.position != position) {
+               node.position = position;
+               markTransform(id);
+          }
+          if (node.size != size) {
+               node.size = size;
+               markDirty(id);
+          }
+     }
+     void setColor(Id id, glm::vec3 color) {
+          nodes_.at(id).color = color;
+          markDirty(id);
+     }
+     void setTexture(Id id, uint32_t texture) {
+          auto& node = nodes_.at(id);
+          reference(node.texture, -1);
+          reference(texture, 1);
+          node.texture = texture;
+          markDirty(id);
+     }
+     // Moves the drawn widget by `offset` pixels, scales it by `scale` about its centre and multiplies
+     // its colour by `tint`, alpha being the opacity. Only the motion record is rewritten; hit testing
+     // still sees the widget where its rectangle is.
+     void setMotion(Id id, glm::vec2 offset, glm::vec2 scale, glm::vec4 tint) {
+          auto& node = nodes_.at(id);
+          if (!node.alive)
+               return;
+          node.offset = offset;
+          node.scale  = scale;
+          node.tint   = tint;
+          writeMotion(id);
+     }
+
+     void setVisible(Id id, bool visible) {
+          auto& node = nodes_.at(id);
+          if (node.visible == visible)
+               return;
+          node.visible = visible;
+          markTransform(id);
+     }
+
+     // The stream is in NDC, so every widget is regenerated.
+     void resize(VkExtent2D window) {
+          window_          = window;
+          nodes_[0].size   = { static_cast<float>(window.width), static_cast<float>(window.height) };
+          markTransform(root());
+     }
+
+     // Regenerates the runs of dirty widgets. Returns how many were regenerated.
+     size_t update() {
+          regenerated_ = 0;
+          if (!nodes_[0].subtreeDirty && !nodes_[0].transformDirty)
+               return 0;
+          std::vector<std::pair<Id, bool>> stack { { root(), false } };
+          while (!stack.empty()) {
+               auto [id, parentMoved] = stack.back();
+               stack.pop_back();
+               auto& node  = nodes_[id];
+               bool  moved = parentMoved || node.transformDirty;
+               if (moved && id != root()) {
+                    auto& parent  = nodes_[node.parent];
+                    node.absolute = parent.absolute + node.position;
+                    node.depth    = parent.depth + 1;
+                    node.shown    = parent.shown && node.visible;
+                    node.dirty    = true;
+               }
+               if (node.dirty) {
+                    write(id);
+                    ++regenerated_;
+               }
+               for (auto child = node.firstChild; child != NONE; child = nodes_[child].next) {
+                    auto& c = nodes_[child];
+                    if (moved || c.dirty || c.subtreeDirty || c.transformDirty)
+                         stack.emplace_back(child, moved);
+               }
+               node.dirty          = false;
+               node.subtreeDirty   = false;
+               node.transformDirty = false;
+          }
+          return regenerated_;
+     }
+
+     // Regenerates what is dirty and appends every run and motion record rewritten since the last
+     // call to `changes`.
+     void publish(Changes& changes) {
+          update();
+          changes.slots = nodes_.size();
+          for (auto id : runQueue_) {
+               changes.runs.push_back(id);
+               changes.vertices.insert(changes.vertices.end(), stream_.begin() + id * RUN, stream_.begin() + (id + 1) * RUN);
+               queued_[id] &= ~RUN_QUEUED;
+          }
+          for (auto id : motionQueue_) {
+               changes.motions.push_back(id);
+               changes.records.push_back(motions_[id]);
+               queued_[id] &= ~MOTION_QUEUED;
+          }
+          runQueue_.clear();
+          motionQueue_.clear();
+     }
+
+     // Writes every widget below the root to a scene file. `textureName` names the texture in a slot,
+     // for whoever loads the file to resolve again; `name` optionally names widgets, for
+     // SceneFile::find().
+     void save(const std::string& path, const std::function<std::string(uint32_t texture)>& textureName, const std::function<std::string(Id)>& name = {}) {
+          update();
+          SceneFile::Contents contents { .width = window_.width, .height = window_.height, .nodes = {}, .textures = {}, .vertices = {}, .strings = {} };
+          // depth first, so every parent is written before its children
+          std::vector<Id> order;
+          std::vector<Id> stack;
+          if (nodes_[0].firstChild != NONE)
+               stack.push_back(nodes_[0].firstChild);
+          while (!stack.empty()) {
+               auto id = stack.back();
+               stack.pop_back();
+               order.push_back(id);
+               if (nodes_[id].next != NONE)
+                    stack.push_back(nodes_[id].next);
+               if (nodes_[id].firstChild != NONE)
+                    stack.push_back(nodes_[id].firstChild);
+          }
+          std::vector<uint32_t> index(nodes_.size(), SceneFile::NONE);
+          for (uint32_t i = 0; i != order.size(); ++i)
+               index[order[i]] = i;
+          auto map = [&](Id id) { return id == NONE ? SceneFile::NONE : index[id]; };
+
+          std::unordered_map<uint32_t, uint32_t> textures;
+          contents.nodes.reserve(order.size());
+          contents.vertices.reserve(order.size() * RUN);
+          for (auto id : order) {
+               auto& node             = nodes_[id];
+               auto [entry, inserted] = textures.try_emplace(node.texture, static_cast<uint32_t>(contents.textures.size()));
+               if (inserted)
+                    contents.textures.push_back(contents.add(textureName(node.texture)));
+               contents.nodes.push_back(SceneFile::Node {
+                  .parent     = map(node.parent),
+                  .firstChild = map(node.firstChild),
+                  .next       = map(node.next),
+                  .previous   = map(node.previous),
+                  .position   = node.position,
+                  .size       = node.size,
+                  .color      = node.color,
+                  .texture    = entry->second,
+                  .absolute   = node.absolute,
+                  .depth      = node.depth,
+                  .flags      = (node.visible ? SceneFile::FLAG_VISIBLE : 0u) | (node.shown ? SceneFile::FLAG_SHOWN : 0u),
+                  .name       = name ? contents.add(name(id)) : SceneFile::String { 0, 0 } });
+               auto* run = stream_.data() + id * RUN;
+               for (size_t v = 0; v != RUN; ++v) {
+                    contents.vertices.push_back(run[v]);
+                    contents.vertices.back().texture = node.alive && node.shown ? entry->second : 0;
+               }
+          }
+          SceneFile::write(path, contents);
+     }
+
+     // Adds the widgets of a scene file below `parent`; `textures` holds the slot of every texture
+     // table entry of the file. Node i of the file becomes widget returned + i: the widgets take new
+     // ids in one block, so their runs are one block too. Loaded below the root into a window the
+     // size the file was saved at, the saved vertices are copied in as they are and nothing is
+     // regenerated; anywhere else the widgets are regenerated by the next update().
+     Id load(const SceneFile& file, Id parent, std::span<const uint32_t> textures) {
+          auto nodes = file.nodes();
+          auto count = static_cast<uint32_t>(nodes.size());
+          if (!nodes_.at(parent).alive || textures.size() < file.textures().size() || file.vertices().size() != nodes.size() * RUN)
+               throw std::runtime_error("scene file does not match the widget tree");
+          auto inside = [count](uint32_t i) { return i == SceneFile::NONE || i < count; };
+          for (uint32_t i = 0; i != count; ++i) {
+               auto& record = nodes[i];
+               if (record.texture >= file.textures().size() || !inside(record.firstChild) || !inside(record.next) || !inside(record.previous) || (record.parent != SceneFile::NONE && record.parent >= i))
+                    throw std::runtime_error("scene file is corrupt");
+          }
+          // every sibling chain ends, links back and names its parent, and together they reach every
+          // node once, so the links form the tree the parents describe
+          std::vector<bool> seen(count, false);
+          auto              chain = [&](uint32_t first, uint32_t parent) {
+               for (auto i = first, previous = SceneFile::NONE; i != SceneFile::NONE; previous = i, i = nodes[i].next) {
+                    if (seen[i] || nodes[i].parent != parent || nodes[i].previous != previous)
+                         return false;
+                    seen[i] = true;
+               }
+               return true;
+          };
+          bool linked = count == 0 || chain(0, SceneFile::NONE);
+          for (uint32_t i = 0; i != count && linked; ++i)
+               linked = chain(nodes[i].firstChild, i);
+          if (!linked || std::find(seen.begin(), seen.end(), false) != seen.end())
+               throw std::runtime_error("scene file is corrupt");
+
+          auto base   = static_cast<Id>(nodes_.size());
+          bool placed = parent == root() && file.width() == window_.width && file.height() == window_.height;
+          auto map    = [base](uint32_t i) { return i == SceneFile::NONE ? NONE : base + i; };
+          nodes_.resize(base + count);
+          queued_.resize(base + count, 0);
+          motions_.resize(base + count);
+          stream_.resize(stream_.size() + nodes.size() * RUN);
+          std::memcpy(stream_.data() + base * RUN, file.vertices().data(), file.vertices().size_bytes());
+
+          std::vector<int> uses(file.textures().size(), 0);
+          for (uint32_t i = 0; i != count; ++i) {
+               auto& record = nodes[i];
+               auto  id     = base + i;
+               nodes_[id]   = Node {
+                      .parent     = map(record.parent),
+                      .firstChild = map(record.firstChild),
+                      .next       = map(record.next),
+                      .previous   = map(record.previous),
+                      .position   = record.position,
+                      .size       = record.size,
+                      .color      = record.color,
+                      .texture    = textures[record.texture],
+                      .visible    = (record.flags & SceneFile::FLAG_VISIBLE) != 0,
+                      .alive      = true,
+                      .absolute   = record.absolute,
+                      .depth      = record.depth,
+                      .shown      = (record.flags & SceneFile::FLAG_SHOWN) != 0 };
+               auto& node   = nodes_[id];
+               ++uses[record.texture];
+               if (record.parent == SceneFile::NONE) {
+                    // top level widgets are appended to the parent's children one after the other
+                    node.parent   = parent;
+                    node.next     = NONE;
+                    node.previous = NONE;
+                    link(parent, id);
+                    if (!placed)
+                         markTransform(id);
+               }
+               else if (record.next == SceneFile::NONE)
+                    nodes_[node.parent].lastChild = id;
+               if (placed) {
+                    auto* run = stream_.data() + id * RUN;
+                    for (size_t v = 0; v != RUN; ++v)
+                         run[v].texture = node.shown ? node.texture : 0;
+                    if (node.shown)
+                         hits_.set(id, node.absolute, node.absolute + node.size, static_cast<uint64_t>(node.depth) << 32 | (~id));
+                    queueRun(id);
+                    writeMotion(id);
+               }
+          }
+          for (size_t t = 0; t != uses.size(); ++t)
+               if (uses[t] != 0)
+                    reference(textures[t], uses[t]);
+          widgets_ += count;
+          return base;
+     }
+
+     // The widget drawn on top at `point`, in window pixels, or the root when there is none.
+     Id hit(glm::vec2 point) {
+          update();
+          auto id = hits_.at(point);
+          return id == HitGrid::NONE ? root() : id;
+     }
+     // Widgets under `point`, topmost first.
+     void hitStack(glm::vec2 point, std::vector<Id>& out) {
+          update();
+          hits_.stack(point, out);
+     }
+     // Widgets overlapping the rectangle, topmost first.
+     void hitRect(glm::vec2 position, glm::vec2 size, std::vector<Id>& out) {
+          update();
+          hits_.overlapping(position, position + size, out);
+     }
+
+     // Texture slots any widget samples, for the texture cache.
+     const std::vector<uint32_t>& textures() {
+          if (texturesChanged_) {
+               textures_.clear();
+               for (auto& [texture, count] : textureReferences_)
+                    textures_.push_back(texture);
+               texturesChanged_ = false;
+          }
+          return textures_;
+     }
+
+     Stats stats() {
+          return Stats {
+               .widgets     = widgets_,
+               .regenerated = regenerated_
+          };
+     }
+
+  private:
+     void link(Id parent, Id id) {
+          auto& p = nodes_.at(parent);
+          if (p.lastChild == NONE)
+               p.firstChild = id;
+          else {
+               nodes_[p.lastChild].next = id;
+               nodes_[id].previous      = p.lastChild;
+          }
+          p.lastChild = id;
+     }
+
+     void unlink(Id id) {
+          auto& node = nodes_[id];
+          auto& p    = nodes_[node.parent];
+          (node.previous == NONE ? p.firstChild : nodes_[node.previous].next) = node.next;
+          (node.next == NONE ? p.lastChild : nodes_[node.next].previous)      = node.previous;
+     }
+
+     void markDirty(Id id) {
+          nodes_[id].dirty = true;
+          markAncestors(id);
+     }
+     void markTransform(Id id) {
+          nodes_[id].transformDirty = true;
+          markAncestors(id);
+     }
+     // stops at the first ancestor already flagged, everything above it is flagged too
+     void markAncestors(Id id) {
+          for (auto parent = nodes_[id].parent; parent != NONE && !nodes_[parent].subtreeDirty; parent = nodes_[parent].parent)
+               nodes_[parent].subtreeDirty = true;
+     }
+
+     void reference(uint32_t texture, int count) {
+          auto& references = textureReferences_[texture];
+          references += count;
+          if (references == 0)
+               textureReferences_.erase(texture);
+          texturesChanged_ = true;
+     }
+
+     void write(Id id) {
+          auto* run  = stream_.data() + id * RUN;
+          auto& node = nodes_[id];
+          if (!node.alive || !node.shown || id == root()) {
+               std::fill(run, run + RUN, Vertex {});
+               hits_.remove(id);
+          }
+          else {
+               auto toNdc = [this](glm::vec2 p) { return glm::vec2 { 2.f * p.x / static_cast<float>(window_.width) - 1.f, 2.f * p.y / static_cast<float>(window_.height) - 1.f }; };
+               auto low   = toNdc(node.absolute);
+               auto high  = toNdc(node.absolute + node.size);
+               // deeper widgets nearer, the depth test keeps children above their parents
+               auto z = std::max(0.f, 1.f - static_cast<float>(node.depth) / 256.f);
+               auto corner = [&](float x, float y, glm::vec2 uv) { return Vertex { .position = { x, y, z }, .color = node.color, .textureCoordinate = uv, .texture = node.texture }; };
+               run[0] = run[1] = corner(low.x, low.y, { 0.f, 0.f });
+               run[2]          = corner(high.x, low.y, { 1.f, 0.f });
+               run[3]          = corner(low.x, high.y, { 0.f, 1.f });
+               run[4] = run[5] = corner(high.x, high.y, { 1.f, 1.f });
+               // the order the depth test resolves: deeper first, then lower ids, drawn earlier
+               hits_.set(id, node.absolute, node.absolute + node.size, static_cast<uint64_t>(node.depth) << 32 | (~id));
+          }
+          queueRun(id);
+          // the pivot follows the rectangle
+          writeMotion(id);
+     }
+
+     void writeMotion(Id id) {
+          auto& node   = nodes_[id];
+          auto  extent = glm::vec2 { static_cast<float>(window_.width), static_cast<float>(window_.height) };
+          auto  centre = node.absolute + node.size / 2.f;
+          motions_[id] = Motion {
+               .translate = node.offset * 2.f / extent,
+               .scale     = node.scale,
+               .pivot     = glm::vec2 { 2.f * centre.x / extent.x - 1.f, 2.f * centre.y / extent.y - 1.f },
+               .padding   = { 0.f, 0.f },
+               .tint      = node.tint
+          };
+          if (!(queued_[id] & MOTION_QUEUED)) {
+               queued_[id] |= MOTION_QUEUED;
+               motionQueue_.push_back(id);
+          }
+     }
+
+     void queueRun(Id id) {
+          if (!(queued_[id] & RUN_QUEUED)) {
+               queued_[id] |= RUN_QUEUED;
+               runQueue_.push_back(id);
+          }
+     }
+
+     VkExtent2D window_;
+     size_t     widgets_ { 0 };
+     size_t     regenerated_ { 0 };
+     bool       texturesChanged_ { false };
+
+     std::vector<Node>                 nodes_;
+     std::vector<Id>                   free_;
+     std::vector<Vertex>               stream_;
+     std::vector<Motion>               motions_;
+     std::vector<uint8_t>              queued_;
+     std::vector<Id>                   runQueue_;
+     std::vector<Id>                   motionQueue_;
+     HitGrid                           hits_;
+     std::unordered_map<uint32_t, int> textureReferences_;
+     std::vector<uint32_t>             textures_;
+};
+
+// The widget stream and motion records on the thread that draws: a copy of each, brought up to date
+// from the changes a frame packet carries, and per frame in flight a mapped buffer of each that
+// receives only what changed since that frame last drew.
+class WidgetBuffers {
+     static constexpr size_t RUN = WidgetTree::RUN;
+     using Motion                = WidgetTree::Motion;
+
+     struct Copy {
+          std::optional<Buffer<Vertex>> buffer;
+          Vertex*                       mapped { nullptr };
+          size_t                        capacity { 0 };
+          std::vector<uint32_t>         pending;
+          bool                          full { true };
+     };
+     struct MotionCopy {
+          std::optional<Buffer<Motion>> buffer;
+          Motion*                       mapped { nullptr };
+          size_t                        capacity { 0 };
+          std::vector<uint32_t>         pending;
+          bool                          full { true };
+     };
+
+  public:
+     struct Stats {
+          size_t uploadedVertices;
+          size_t uploadedMotions;
+     };
+
+     WidgetBuffers(Core* core, Device* device, CommandPool* commandPool, size_t maxFramesInFlight)
+        : core_(core)
+        , device_(device)
+        , commandPool_(commandPool)
+        , copies_(maxFramesInFlight)
+        , motionCopies_(maxFramesInFlight) {}
+     ~WidgetBuffers() {
+          for (auto& copy : copies_)
+               if (copy.buffer)
+                    copy.buffer->unmap();
+          for (auto& copy : motionCopies_)
+               if (copy.buffer)
+                    copy.buffer->unmap();
+     }
+     WidgetBuffers(const WidgetBuffers&)            = delete;
+     WidgetBuffers(WidgetBuffers&&)                 = delete;
+     WidgetBuffers& operator=(const WidgetBuffers&) = delete;
+     WidgetBuffers& operator=(WidgetBuffers&&)      = delete;
+
+     // Slots the stream grows by are in the changes of the widgets created in them.
+     void apply(const WidgetTree::Changes& changes) {
+          if (motions_.size() < changes.slots) {
+               stream_.resize(changes.slots * RUN);
+               motions_.resize(changes.slots);
+          }
+          for (size_t i = 0; i != changes.runs.size(); ++i) {
+               auto id = changes.runs[i];
+               std::memcpy(stream_.data() + id * RUN, changes.vertices.data() + i * RUN, RUN * sizeof(Vertex));
+               for (auto& copy : copies_)
+                    if (!copy.full)
+                         copy.pending.push_back(id);
+          }
+          for (size_t i = 0; i != changes.motions.size(); ++i) {
+               auto id      = changes.motions[i];
+               motions_[id] = changes.records[i];
+               for (auto& copy : motionCopies_)
+                    if (!copy.full)
+                         copy.pending.push_back(id);
+          }
+     }
+
+     // Brings frame `frame`'s copy of the motion buffer up to date and returns it, before the frame's
+     // descriptor set is flushed; the buffer is replaced when it grows. The frame's fence must have
+     // been waited on.
+     VkBuffer motions(size_t frame) {
+          auto& copy       = motionCopies_[frame];
+          uploadedMotions_ = 0;
+          if (copy.capacity < std::max<size_t>(motions_.size(), 1)) {
+               if (copy.buffer)
+                    copy.buffer->unmap();
+               copy.capacity = std::max({ motions_.size(), copy.capacity * 2, size_t { 1 } });
+               copy.buffer.emplace(Buffer<Motion>::makeDynamicStorage(core_, device_, commandPool_, copy.capacity));
+               copy.mapped = copy.buffer->map();
+               copy.full   = true;
+          }
+          if (copy.full) {
+               std::memcpy(copy.mapped, motions_.data(), motions_.size() * sizeof(Motion));
+               uploadedMotions_ = motions_.size();
+          }
+          else
+               for (auto id : copy.pending) {
+                    copy.mapped[id] = motions_[id];
+                    ++uploadedMotions_;
+               }
+          copy.pending.clear();
+          copy.full = false;
+          return copy.buffer->get();
+     }
+
+     // Brings frame `frame`'s copy of the stream up to date and draws it, inside the render pass with
+     // the pipeline bound. The frame's fence must have been waited on.
+     void record(size_t frame, CommandBuffer* commandBuffer) {
+          auto& copy        = copies_[frame];
+          uploadedVertices_ = 0;
+          if (stream_.empty())
+               return;
+          if (copy.capacity < stream_.size()) {
+               if (copy.buffer)
+                    copy.buffer->unmap();
+               copy.capacity = std::max(stream_.size(), copy.capacity * 2);
+               copy.buffer.emplace(Buffer<Vertex>::makeDynamicVertex(core_, device_, commandPool_, copy.capacity));
+               copy.mapped = copy.buffer->map();
+               copy.full   = true;
+          }
+          if (copy.full) {
+               std::memcpy(copy.mapped, stream_.data(), stream_.size() * sizeof(Vertex));
+               uploadedVertices_ = stream_.size();
+          }
+          else
+               for (auto id : copy.pending) {
+                    std::memcpy(copy.mapped + id * RUN, stream_.data() + id * RUN, RUN * sizeof(Vertex));
+                    uploadedVertices_ += RUN;
+               }
+          copy.pending.clear();
+          copy.full = false;
+
+          VkBuffer     vertexBuffers[]     = { copy.buffer->get() };
+          VkDeviceSize deviceSizeOffsets[] = { 0 };
+          vkCmdBindVertexBuffers(commandBuffer->get(), 0, 1, vertexBuffers, deviceSizeOffsets);
+          vkCmdDraw(commandBuffer->get(), static_cast<uint32_t>(stream_.size()), 1, 0, 0);
+     }
+
+     Stats stats() {
+          return Stats {
+               .uploadedVertices = uploadedVertices_,
+               .uploadedMotions  = uploadedMotions_
+          };
+     }
+
+  private:
+     Core*        core_;
+     Device*      device_;
+     CommandPool* commandPool_;
+     size_t       uploadedVertices_ { 0 };
+     size_t       uploadedMotions_ { 0 };
+
+     std::vector<Vertex>     stream_;
+     std::vector<Copy>       copies_;
+     std::vector<Motion>     motions_;
+     std::vector<MotionCopy> motionCopies_;
+};
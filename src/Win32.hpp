@@ -9,10 +9,20 @@
 
 class Win32 {
   public:
-     Win32() { hInstance_ = GetModuleHandleW(0); }
+     Win32() {
+          hInstance_ = GetModuleHandleW(0);
+          thread_    = GetCurrentThreadId();
+     }
      HINSTANCE instance() const { return hInstance_; }
 
      void processMessages();
+     // Blocks until a message arrives, then handles every queued one.
+     void waitMessages() {
+          WaitMessage();
+          processMessages();
+     }
+     // Any thread. Ends a waitMessages() on the thread that created this.
+     void wake() { PostThreadMessageW(thread_, WM_NULL, 0, 0); }
 
      using frame_handle = HWND;
 
@@ -23,6 +33,7 @@ class Win32 {
      static LRESULT CALLBACK messageHandler(HWND hWnd, uint32_t uMsg, WPARAM wParam, LPARAM lParam);
 
      HINSTANCE hInstance_;
+     DWORD     thread_;
 };
 
 void Win32::processMessages() {
@@ -68,11 +79,14 @@ LRESULT CALLBACK Win32::messageHandler(HWND hWnd, uint32_t uMsg, WPARAM wParam,
      else
           eventSystem = reinterpret_cast<EventSystem*>(GetWindowLongPtrW(hWnd, GWLP_USERDATA));
 
+     auto push = [&](InputEvent::Kind kind, int x, int y, int value, bool down = false) {
+          eventSystem->queue.push({ .kind = kind, .time = static_cast<uint32_t>(GetMessageTime()), .x = x, .y = y, .value = value, .down = down });
+     };
      switch (uMsg) {
           case WM_ERASEBKGND:
                return 1;
           case WM_CLOSE:
-               eventSystem->closeDispatcher.signal();
+               push(InputEvent::Kind::CLOSE, 0, 0, 0);
                return 0;
           case WM_DESTROY:
                PostQuitMessage(0);
@@ -80,7 +94,7 @@ LRESULT CALLBACK Win32::messageHandler(HWND hWnd, uint32_t uMsg, WPARAM wParam,
           case WM_SIZE: {
                RECT r;
                GetClientRect(hWnd, &r);
-               eventSystem->resizeDispatcher.signal(r.right - r.left, r.bottom - r.top);
+               push(InputEvent::Kind::RESIZE, r.right - r.left, r.bottom - r.top, 0);
           } break;
           case WM_KEYDOWN:
           case WM_SYSKEYDOWN:
@@ -91,19 +105,23 @@ LRESULT CALLBACK Win32::messageHandler(HWND hWnd, uint32_t uMsg, WPARAM wParam,
                return 0;
 
           case WM_MOUSEMOVE:
-               eventSystem->mouseMoveDispatcher.signal(GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+               push(InputEvent::Kind::MOUSE_MOVE, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), 0);
                break;
           case WM_MOUSEWHEEL:
+               push(InputEvent::Kind::MOUSE_WHEEL, 0, 0, GET_WHEEL_DELTA_WPARAM(wParam));
                break;
           case WM_LBUTTONDOWN:
           case WM_MBUTTONDOWN:
           case WM_RBUTTONDOWN:
           case WM_LBUTTONUP:
           case WM_MBUTTONUP:
-          case WM_RBUTTONUP:
-               eventSystem->mouseButtonDispatcher.signal(EventSystem::MouseButton::LEFT, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
-               // WM_LBUTTONDOWN || msg == WM_RBUTTONDOWN || msg == WM_MBUTTONDOWN;
-               break;
+          case WM_RBUTTONUP: {
+               auto button = uMsg == WM_LBUTTONDOWN || uMsg == WM_LBUTTONUP ? EventSystem::MouseButton::LEFT
+                           : uMsg == WM_MBUTTONDOWN || uMsg == WM_MBUTTONUP ? EventSystem::MouseButton::MIDDLE
+                                                                            : EventSystem::MouseButton::RIGHT;
+               bool down   = uMsg == WM_LBUTTONDOWN || uMsg == WM_MBUTTONDOWN || uMsg == WM_RBUTTONDOWN;
+               push(InputEvent::Kind::MOUSE_BUTTON, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), button, down);
+          } break;
      }
      return DefWindowProcW(hWnd, uMsg, wParam, lParam);
 }
@@ -1,10 +1,21 @@
 #include "GUI.hpp"
 
 #include <stdexcept>
+#include <string_view>
+
+// main [--record <log>]   records the session's input, tools/replay draws it back offscreen
+int main(int argc, char* argv[]) {
+     std::string_view record;
+     for (int i = 1; i < argc; ++i) {
+          std::string_view argument { argv[i] };
+          if (argument == "--record" && i + 1 < argc)
+               record = argv[++i];
+     }
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
-     GUI gui;
      try {
+          GUI gui;
+          if (!record.empty())
+               gui.record(std::string(record));
           gui.run();
           /* code */
      }
@@ -1,11 +1,13 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout(location = 0) in vec3 color;
+layout(location = 0) in vec4 color;
 layout(location = 1) in vec2 texCoord;
+layout(location = 2) flat in uint slot;
 layout(location = 0) out vec4 outColor;
 
-layout(binding = 0) uniform sampler2D texSampler;
+layout(set = 0, binding = 0) uniform sampler2D textures[];
 
 void main() {
-    outColor = vec4(color * texture(texSampler, texCoord).rgb, 1.0);
+    outColor = vec4(color.rgb * texture(textures[nonuniformEXT(slot)], texCoord).rgb, color.a);
 }
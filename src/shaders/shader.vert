@@ -3,11 +3,14 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
 layout(location = 2) in vec2 texCoord;
-layout(location = 0) out vec3 fragColor;
+layout(location = 3) in uint slot;
+layout(location = 0) out vec4 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragTexture;
 
 void main() {
-    fragColor = color;
+    fragColor = vec4(color, 1.0);
     fragTexCoord = texCoord;
+    fragTexture = slot;
     gl_Position = vec4(position, 1.0);
 }
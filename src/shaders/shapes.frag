@@ -0,0 +1,17 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec4 color;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) flat in uint slot;
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+
+const uint NONE = 0xFFFFFFFFu;
+
+void main() {
+    // sampled outside the branch, untextured shapes read slot 0 and ignore it
+    vec4 texel = texture(textures[nonuniformEXT(slot == NONE ? 0u : slot)], texCoord);
+    outColor = slot == NONE ? color : color * texel;
+}
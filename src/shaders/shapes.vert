@@ -0,0 +1,17 @@
+#version 450
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 color;
+layout(location = 3) in uint texture;
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragTexture;
+
+void main() {
+    // colours are given sRGB encoded, blending happens in linear space
+    fragColor = vec4(pow(color.rgb, vec3(2.2)), color.a);
+    fragTexCoord = texCoord;
+    fragTexture = texture;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
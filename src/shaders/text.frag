@@ -0,0 +1,18 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec4 color;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) flat in uint slot;
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+
+void main() {
+    // the atlas stores distance to the glyph edge, 0.5 on the edge and above inside
+    float distance = texture(textures[nonuniformEXT(slot)], texCoord).r;
+    // about one screen pixel of antialiasing whatever the glyph is scaled to
+    float width = fwidth(distance) * 0.7;
+    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+    outColor = vec4(color.rgb, color.a * alpha);
+}
@@ -0,0 +1,30 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec2 texCoord;
+layout(location = 3) in uint slot;
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragTexture;
+
+struct Motion {
+    vec2 translate;
+    vec2 scale;
+    vec2 pivot;
+    vec2 padding;
+    vec4 tint;
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer Motions {
+    Motion motions[];
+};
+
+// every widget owns a run of 6 vertices, and the motion record of the same index
+void main() {
+    Motion motion = motions[gl_VertexIndex / 6];
+    fragColor = vec4(color, 1.0) * motion.tint;
+    fragTexCoord = texCoord;
+    fragTexture = slot;
+    gl_Position = vec4((position.xy - motion.pivot) * motion.scale + motion.pivot + motion.translate, position.z, 1.0);
+}
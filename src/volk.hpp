@@ -1,6 +1,8 @@
 #pragma once
 
+#ifdef _WIN32
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 #ifndef VS_CODE_SYNTAX_HIGHLIGHTING
 #include <volk.h>
 #else
@@ -0,0 +1,298 @@
+// Times EventDispatcher::signal against the mutex and hash map dispatcher it replaced, with 1 to
+// 1000 listeners and 1 to 8 threads signalling at once, and subscribing and unsubscribing a screen's
+// worth of listeners, counting the allocations that takes, and delivering a frame of mouse moves one
+// call per move against one span per frame through EventBus. Then subscribes and unsubscribes while
+// threads signal, checking that unsubscribed slots come back without allocating, and that listeners
+// can subscribe and unsubscribe from inside a signal.
+//
+//   event_bench [milliseconds per run]
+
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#include "EventSystem.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+     std::atomic<size_t> allocations { 0 };
+}
+
+// counts every allocation; GCC takes the malloc and free pairing below for a mismatch
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(size_t size) {
+     allocations.fetch_add(1, std::memory_order_relaxed);
+     if (auto* p = std::malloc(size ? size : 1))
+          return p;
+     throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+     // the previous implementation, for comparison
+     template <typename F, typename... ArgT>
+     class LockedDispatcher {
+       public:
+          class Subscription {
+            public:
+               Subscription(LockedDispatcher* source, const F& listener)
+                  : source_(source) { source_->add_listener(this, listener); }
+               ~Subscription() { source_->remove_listener(this); }
+
+            private:
+               LockedDispatcher* source_;
+          };
+          std::unique_ptr<Subscription> subscribe(const F& listener) { return std::make_unique<Subscription>(this, listener); }
+
+          void signal(ArgT... arguments) {
+               std::unique_lock lock(subscribers_mutex_);
+               for (const auto& [Subscription, invocable] : subscribers_)
+                    invocable(arguments...);
+          }
+
+       private:
+          std::unordered_map<Subscription*, F> subscribers_ {};
+          std::mutex                           subscribers_mutex_ {};
+
+          void add_listener(Subscription* subscriber, const F& listener) {
+               std::unique_lock lock(subscribers_mutex_);
+               subscribers_[subscriber] = listener;
+          }
+          void remove_listener(Subscription* subscriber) {
+               std::unique_lock lock(subscribers_mutex_);
+               subscribers_.erase(subscriber);
+          }
+     };
+
+     using Listener = std::function<void(int)>;
+
+     thread_local uint64_t sink { 0 };
+
+     auto listener(int i) {
+          return [i](int value) { sink += static_cast<uint64_t>(value ^ i); };
+     }
+
+     // signals per second, summed over the threads
+     template <typename Dispatcher>
+     double run(int listeners, int threads, int milliseconds) {
+          Dispatcher dispatcher;
+          std::vector<decltype(dispatcher.subscribe(listener(0)))> subscriptions;
+          for (int i = 0; i != listeners; ++i)
+               subscriptions.push_back(dispatcher.subscribe(listener(i)));
+
+          std::atomic<bool>        stop { false };
+          std::atomic<uint64_t>    signals { 0 };
+          std::vector<std::thread> workers;
+          for (int t = 0; t != threads; ++t)
+               workers.emplace_back([&] {
+                    uint64_t count { 0 };
+                    while (!stop.load(std::memory_order_relaxed)) {
+                         dispatcher.signal(static_cast<int>(count));
+                         ++count;
+                    }
+                    signals += count;
+               });
+          std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+          stop = true;
+          for (auto& worker : workers)
+               worker.join();
+          return static_cast<double>(signals.load()) * 1000. / milliseconds;
+     }
+
+     struct Churn {
+          double nanoseconds; // per subscribe and unsubscribe
+          double allocations;
+     };
+
+     // subscribes a screen of listeners and drops them again, as opening and closing a screen does
+     template <typename Dispatcher>
+     Churn screens(int listeners, int rounds) {
+          Dispatcher dispatcher;
+          std::vector<decltype(dispatcher.subscribe(listener(0)))> subscriptions;
+          subscriptions.reserve(static_cast<size_t>(listeners));
+          auto screen = [&] {
+               for (int i = 0; i != listeners; ++i)
+                    subscriptions.push_back(dispatcher.subscribe(listener(i)));
+               subscriptions.clear();
+          };
+          screen();
+          auto before = allocations.load();
+          auto start  = std::chrono::steady_clock::now();
+          for (int round = 0; round != rounds; ++round)
+               screen();
+          auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+          auto pairs   = static_cast<double>(listeners) * rounds;
+          return { elapsed / pairs, static_cast<double>(allocations.load() - before) / pairs };
+     }
+
+     struct Move {
+          int x;
+          int y;
+     };
+
+     // nanoseconds per move, delivering `moves` a frame to `listeners` that sum them
+     template <bool batched>
+     double frames(int moves, int listeners, int rounds) {
+          EventDispatcher<int, int>                            single;
+          EventBus<Move>                                       bus;
+          std::vector<EventDispatcher<int, int>::Subscription> perMove;
+          std::vector<EventBus<Move>::Subscription<Move>>      perFrame;
+          for (int i = 0; i != listeners; ++i) {
+               if constexpr (batched)
+                    perFrame.push_back(bus.subscribe<Move>([](std::span<const Move> frame) {
+                         uint64_t sum { 0 };
+                         for (auto move : frame)
+                              sum += static_cast<uint64_t>(move.x + move.y);
+                         sink += sum;
+                    }));
+               else
+                    perMove.push_back(single.subscribe([](int x, int y) { sink += static_cast<uint64_t>(x + y); }));
+          }
+          auto start = std::chrono::steady_clock::now();
+          for (int round = 0; round != rounds; ++round)
+               for (int i = 0; i != moves; ++i)
+                    if constexpr (batched) {
+                         bus.post(Move { i, round });
+                         if (i == moves - 1)
+                              bus.deliver();
+                    }
+                    else
+                         single.signal(i, round);
+          return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (static_cast<double>(moves) * rounds);
+     }
+
+     int batching() {
+          EventBus<Move, int> bus;
+          std::vector<int>    seen;
+          size_t              calls { 0 };
+          auto                moves = bus.subscribe<Move>([&](std::span<const Move> frame) {
+               ++calls;
+               for (auto move : frame)
+                    seen.push_back(move.x);
+               // posted from a listener, delivered next time
+               bus.post(Move { -1, 0 });
+          });
+          for (int i = 0; i != 5; ++i)
+               bus.post(Move { i, 0 });
+          bus.post(3);
+          auto delivered = bus.deliver();
+          if (calls != 1 || delivered != 6 || seen != std::vector<int> { 0, 1, 2, 3, 4 } || bus.deliver() != 1 || seen.back() != -1) {
+               fmt::print("FAILED: batched delivery\n");
+               return 1;
+          }
+          return 0;
+     }
+
+     int reentrancy() {
+          int                                failures { 0 };
+          EventDispatcher<int>               dispatcher;
+          EventDispatcher<int>::Subscription self, other, added;
+          int                                selfCalls { 0 }, otherCalls { 0 }, addedCalls { 0 };
+          self  = dispatcher.subscribe([&](int) {
+               ++selfCalls;
+               self.reset();
+               other.reset();
+               added = dispatcher.subscribe([&](int) { ++addedCalls; });
+          });
+          other = dispatcher.subscribe([&](int) { ++otherCalls; });
+          dispatcher.signal(0);
+          dispatcher.signal(0);
+          failures += selfCalls != 1 || otherCalls != 0 || addedCalls != 1;
+          if (failures)
+               fmt::print("FAILED: reentrant calls {} {} {}\n", selfCalls, otherCalls, addedCalls);
+          // a subscription outliving its dispatcher
+          auto early = std::make_unique<EventDispatcher<int>>();
+          auto late  = early->subscribe([](int) {});
+          early.reset();
+          if (late.is_valid()) {
+               fmt::print("FAILED: subscription valid after its dispatcher\n");
+               ++failures;
+          }
+          return failures;
+     }
+
+     // subscriptions come and go on one thread while others signal without pause; once the first
+     // rounds have grown the slots for what is retired at a time, churning allocates nothing
+     int churn() {
+          EventDispatcher<int>     dispatcher;
+          auto                     fixed = dispatcher.subscribe([](int value) { sink += static_cast<uint64_t>(value); });
+          std::atomic<bool>        stop { false };
+          std::vector<std::thread> workers;
+          for (int t = 0; t != 3; ++t)
+               workers.emplace_back([&] {
+                    for (int i = 0; !stop.load(std::memory_order_relaxed); ++i)
+                         dispatcher.signal(i);
+               });
+          auto round = [&] {
+               for (int i = 0; i != 1000; ++i) {
+                    auto subscription = dispatcher.subscribe([i](int value) { sink += static_cast<uint64_t>(value + i); });
+                    if (i % 8 == 0)
+                         std::this_thread::yield();
+               }
+          };
+          for (int i = 0; i != 5; ++i)
+               round();
+          auto before = allocations.load();
+          for (int i = 0; i != 10; ++i)
+               round();
+          auto allocated = allocations.load() - before;
+          stop           = true;
+          for (auto& worker : workers)
+               worker.join();
+          if (allocated != 0)
+               fmt::print("FAILED: churning while signalling allocated {} times\n", allocated);
+          return allocated != 0;
+     }
+}
+
+int main(int argc, char* argv[]) {
+     int  milliseconds = argc > 1 ? std::stoi(argv[1]) : 200;
+     auto hardware     = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+     fmt::print("{:>9} {:>7} {:>16} {:>16} {:>8}\n", "listeners", "threads", "locked /s", "slot map /s", "speedup");
+     for (int listeners : { 1, 10, 100, 1000 })
+          for (int threads : { 1, 2, 4, 8 }) {
+               if (threads > hardware && threads != 1)
+                    continue;
+               auto locked   = run<LockedDispatcher<Listener, int>>(listeners, threads, milliseconds);
+               auto slots    = run<EventDispatcher<int>>(listeners, threads, milliseconds);
+               fmt::print("{:>9} {:>7} {:>16.0f} {:>16.0f} {:>7.1f}x\n", listeners, threads, locked, slots, slots / locked);
+          }
+
+     fmt::print("\n{:>9} {:>16} {:>16} {:>16} {:>16}\n", "listeners", "locked ns", "allocations", "slot map ns", "allocations");
+     for (int listeners : { 10, 100, 1000, 10000 }) {
+          auto rounds = std::max(1, 200000 / listeners);
+          auto locked = screens<LockedDispatcher<Listener, int>>(listeners, rounds);
+          auto slots  = screens<EventDispatcher<int>>(listeners, rounds);
+          fmt::print("{:>9} {:>16.1f} {:>16.2f} {:>16.1f} {:>16.2f}\n", listeners, locked.nanoseconds, locked.allocations, slots.nanoseconds, slots.allocations);
+     }
+
+     fmt::print("\n{:>9} {:>9} {:>16} {:>16} {:>8}\n", "moves", "listeners", "per move ns", "per frame ns", "speedup");
+     for (int moves : { 1, 16, 256 })
+          for (int listeners : { 1, 10, 100 }) {
+               auto rounds = std::max(1, 2000000 / (moves * listeners));
+               auto single = frames<false>(moves, listeners, rounds);
+               auto batch  = frames<true>(moves, listeners, rounds);
+               fmt::print("{:>9} {:>9} {:>16.2f} {:>16.2f} {:>7.1f}x\n", moves, listeners, single, batch, single / batch);
+          }
+
+     auto failures = churn() + reentrancy() + batching();
+     if (screens<EventDispatcher<int>>(1000, 10).allocations != 0.) {
+          fmt::print("FAILED: subscribing allocated\n");
+          ++failures;
+     }
+     fmt::print("reentrant subscribe and unsubscribe {}\n", failures ? "failed" : "ok");
+     return failures == 0 ? 0 : 1;
+}
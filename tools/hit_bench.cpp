@@ -0,0 +1,88 @@
+// Times HitGrid point queries, rectangle queries and moves over a canvas of small rectangles, after
+// checking query results against a linear scan.
+//
+//   hit_bench [rectangles]
+
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#include "HitGrid.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+     constexpr float CANVAS  = 8192.f;
+     constexpr int   QUERIES = 1'000'000;
+
+     struct Rect {
+          glm::vec2 low;
+          glm::vec2 high;
+          uint64_t  z;
+     };
+
+     template <typename F>
+     double nanoseconds(int n, F&& f) {
+          auto start = std::chrono::steady_clock::now();
+          for (int i = 0; i != n; ++i)
+               f(i);
+          return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+     }
+}
+
+int main(int argc, char* argv[]) {
+     int count = argc > 1 ? std::stoi(argv[1]) : 100'000;
+
+     std::mt19937                          random { 1 };
+     std::uniform_real_distribution<float> position { 0.f, CANVAS };
+     std::uniform_real_distribution<float> extent { 8.f, 64.f };
+     std::vector<Rect>                     rects(count);
+     HitGrid                               grid;
+     for (int i = 0; i != count; ++i) {
+          glm::vec2 low { position(random), position(random) };
+          rects[i] = { low, low + glm::vec2 { extent(random), extent(random) }, random() };
+          grid.set(static_cast<HitGrid::Id>(i), rects[i].low, rects[i].high, rects[i].z);
+     }
+     // a few window sized backgrounds, listed apart from the grid
+     for (int i = 0; i != 4; ++i) {
+          rects.push_back({ { 0.f, 0.f }, { CANVAS, CANVAS }, static_cast<uint64_t>(i) });
+          grid.set(static_cast<HitGrid::Id>(rects.size() - 1), rects.back().low, rects.back().high, rects.back().z);
+     }
+
+     std::vector<glm::vec2> points(QUERIES);
+     for (auto& point : points)
+          point = { position(random), position(random) };
+
+     int mismatches { 0 };
+     for (int i = 0; i != 10'000; ++i) {
+          auto        point    = points[i];
+          HitGrid::Id expected = HitGrid::NONE;
+          for (size_t r = 0; r != rects.size(); ++r) {
+               auto& rect = rects[r];
+               if (point.x >= rect.low.x && point.x < rect.high.x && point.y >= rect.low.y && point.y < rect.high.y && (expected == HitGrid::NONE || rect.z > rects[expected].z))
+                    expected = static_cast<HitGrid::Id>(r);
+          }
+          mismatches += grid.at(point) != expected;
+     }
+
+     fmt::print("{} rectangles, {} mismatches in 10000 checked point queries\n", grid.size(), mismatches);
+     HitGrid::Id sink { 0 };
+     fmt::print("{:<16} {:8.1f} ns\n", "point", nanoseconds(QUERIES, [&](int i) { sink ^= grid.at(points[i]); }));
+     std::vector<HitGrid::Id> out;
+     fmt::print("{:<16} {:8.1f} ns\n", "stack", nanoseconds(QUERIES, [&](int i) { grid.stack(points[i], out); sink ^= static_cast<HitGrid::Id>(out.size()); }));
+     fmt::print("{:<16} {:8.1f} ns\n", "rect 256x256", nanoseconds(QUERIES / 100, [&](int i) { grid.overlapping(points[i], points[i] + glm::vec2 { 256.f }, out); sink ^= static_cast<HitGrid::Id>(out.size()); }));
+     std::uniform_real_distribution<float> nudge { -4.f, 4.f };
+     fmt::print("{:<16} {:8.1f} ns\n", "move", nanoseconds(QUERIES, [&](int i) {
+                     auto  id   = static_cast<HitGrid::Id>(i % count);
+                     auto& rect = rects[id];
+                     auto  step = glm::vec2 { nudge(random), nudge(random) };
+                     rect.low += step;
+                     rect.high += step;
+                     grid.set(id, rect.low, rect.high, rect.z);
+                }));
+     fmt::print("(checksum {})\n", sink);
+     return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+// Times JobSystem on 1 to 64 worker threads: a parallel-for over an array, a fork-join tree of jobs
+// that wait on the jobs they submit, and a flood of tiny jobs from outside the workers, the last also
+// on the single shared queue pool it replaced. Prints the speedup over one worker with the steals,
+// idle time and deepest deque of each run. Then checks that a parallel-for visits every index once
+// and that jobs held back on counters run after what they depend on.
+//
+//   job_bench [most threads]
+
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+     // the previous implementation, for comparison
+     class SharedQueuePool {
+       public:
+          SharedQueuePool(size_t threads) {
+               for (size_t i = 0; i != threads; ++i)
+                    workers_.emplace_back([this](std::stop_token stop) { work(stop); });
+          }
+          ~SharedQueuePool() {
+               for (auto& worker : workers_)
+                    worker.request_stop();
+               condition_.notify_all();
+          }
+
+          void submit(std::function<void()> task) {
+               {
+                    std::unique_lock lock(tasksMutex_);
+                    tasks_.push_back(std::move(task));
+               }
+               condition_.notify_one();
+          }
+
+       private:
+          void work(std::stop_token stop) {
+               while (true) {
+                    std::function<void()> task;
+                    {
+                         std::unique_lock lock(tasksMutex_);
+                         condition_.wait(lock, stop, [this] { return !tasks_.empty(); });
+                         if (stop.stop_requested())
+                              return;
+                         task = std::move(tasks_.front());
+                         tasks_.pop_front();
+                    }
+                    task();
+               }
+          }
+
+          std::deque<std::function<void()>> tasks_ {};
+          std::mutex                        tasksMutex_ {};
+          std::condition_variable_any       condition_ {};
+          std::vector<std::jthread>         workers_ {};
+     };
+
+     constexpr size_t ELEMENTS = 1 << 22;
+     constexpr size_t GRAIN    = 1 << 12;
+     constexpr int    DEPTH    = 14;
+     constexpr int    TINY     = 100000;
+
+     // a few dozen nanoseconds of arithmetic that the compiler cannot fold away
+     uint32_t hash(uint32_t x) {
+          for (int i = 0; i != 4; ++i) {
+               x ^= x >> 16;
+               x *= 0x7FEB352Du;
+               x ^= x >> 15;
+               x *= 0x846CA68Bu;
+          }
+          return x;
+     }
+
+     template <typename F>
+     double milliseconds(F&& f) {
+          auto start = std::chrono::steady_clock::now();
+          f();
+          return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+     }
+
+     uint64_t parallelFor(JobSystem& jobs, std::vector<uint32_t>& values) {
+          std::atomic<uint64_t> total { 0 };
+          jobs.parallelFor(0, values.size(), GRAIN, [&](size_t first, size_t last) {
+               uint64_t sum { 0 };
+               for (size_t i = first; i != last; ++i)
+                    sum += values[i] = hash(static_cast<uint32_t>(i));
+               total.fetch_add(sum, std::memory_order_relaxed);
+          });
+          return total.load();
+     }
+
+     // each node submits one child, arranges the other itself and waits for both
+     uint64_t tree(JobSystem& jobs, int depth, uint32_t seed) {
+          if (depth == 0) {
+               uint64_t sum { 0 };
+               for (uint32_t i = 0; i != 256; ++i)
+                    sum += hash(seed + i);
+               return sum;
+          }
+          uint64_t           left { 0 };
+          JobSystem::Counter counter;
+          jobs.submit([&jobs, &left, depth, seed] { left = tree(jobs, depth - 1, seed * 2); }, &counter);
+          auto right = tree(jobs, depth - 1, seed * 2 + 1);
+          jobs.wait(counter);
+          return left + right;
+     }
+
+     void tiny(JobSystem& jobs) {
+          JobSystem::Counter counter;
+          for (int i = 0; i != TINY; ++i)
+               jobs.submit([] {}, &counter);
+          jobs.wait(counter);
+     }
+
+     void tiny(SharedQueuePool& pool) {
+          std::atomic<int>        left { TINY };
+          std::mutex              mutex;
+          std::condition_variable done;
+          for (int i = 0; i != TINY; ++i)
+               pool.submit([&] {
+                    if (left.fetch_sub(1) == 1) {
+                         std::unique_lock lock(mutex);
+                         done.notify_all();
+                    }
+               });
+          std::unique_lock lock(mutex);
+          done.wait(lock, [&] { return left.load() == 0; });
+     }
+
+     void report(const char* name, size_t threads, double time, double single, const JobSystem::Stats& stats) {
+          fmt::print("{:<10} {:>7} {:>10.2f} {:>7.2f}x {:>9} {:>9} {:>9.3f} {:>7}\n", name, threads, time, single / time, stats.steals, stats.failedSteals, stats.idle, stats.deepest);
+     }
+
+     int coverage() {
+          JobSystem                          jobs(4);
+          std::vector<std::atomic<uint32_t>> visits(100003);
+          jobs.parallelFor(0, visits.size(), 97, [&](size_t first, size_t last) {
+               for (size_t i = first; i != last; ++i)
+                    visits[i].fetch_add(1, std::memory_order_relaxed);
+          });
+          auto wrong = std::count_if(visits.begin(), visits.end(), [](auto& visit) { return visit.load() != 1; });
+          if (wrong != 0)
+               fmt::print("FAILED: parallel-for visited {} indices other than once\n", wrong);
+          return wrong != 0;
+     }
+
+     // a and b, then c after both, then d after c; counters reused for a second round
+     int dependencies() {
+          int                failures { 0 };
+          JobSystem          jobs(3);
+          JobSystem::Counter first, second, last;
+          for (int round = 0; round != 2; ++round) {
+               std::atomic<int>  a { 0 }, b { 0 }, c { 0 }, d { 0 };
+               std::atomic<int>  order { 0 };
+               std::atomic<bool> wrong { false };
+               jobs.submit([&] { std::this_thread::sleep_for(std::chrono::milliseconds(2)); a = ++order; }, &first);
+               jobs.submit([&] { b = ++order; }, &first);
+               jobs.submitAfter(first, [&] {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    c = ++order;
+                    wrong = wrong || a.load() == 0 || b.load() == 0;
+               }, &second);
+               jobs.submitAfter(second, [&] {
+                    d = ++order;
+                    wrong = wrong || c.load() == 0;
+               }, &last);
+               jobs.wait(first);
+               jobs.wait(second);
+               jobs.wait(last);
+               if (wrong || d != 4 || !first.done() || !second.done() || !last.done()) {
+                    fmt::print("FAILED: dependencies ran out of order in round {}\n", round);
+                    ++failures;
+               }
+          }
+          return failures;
+     }
+}
+
+int main(int argc, char* argv[]) {
+     size_t most = argc > 1 ? std::stoul(argv[1]) : 64;
+     fmt::print("{} hardware threads\n\n", std::thread::hardware_concurrency());
+
+     std::vector<uint32_t> values(ELEMENTS);
+     uint64_t              expected { 0 };
+     for (size_t i = 0; i != ELEMENTS; ++i)
+          expected += hash(static_cast<uint32_t>(i));
+     auto treeExpected = [] {
+          JobSystem jobs(1);
+          return tree(jobs, DEPTH, 1);
+     }();
+
+     int    failures { 0 };
+     double singleFor { 0. }, singleTree { 0. }, singleTiny { 0. }, singleShared { 0. };
+     fmt::print("{:<10} {:>7} {:>10} {:>8} {:>9} {:>9} {:>9} {:>7}\n", "workload", "threads", "ms", "speedup", "steals", "failed", "idle s", "deepest");
+     for (size_t threads = 1; threads <= most; threads *= 2) {
+          JobSystem jobs(threads);
+          uint64_t  sum { 0 };
+
+          jobs.resetStats();
+          auto time = milliseconds([&] { sum = parallelFor(jobs, values); });
+          singleFor = threads == 1 ? time : singleFor;
+          report("for", threads, time, singleFor, jobs.stats());
+          failures += sum != expected;
+
+          jobs.resetStats();
+          time       = milliseconds([&] { sum = tree(jobs, DEPTH, 1); });
+          singleTree = threads == 1 ? time : singleTree;
+          report("fork-join", threads, time, singleTree, jobs.stats());
+          failures += sum != treeExpected;
+
+          jobs.resetStats();
+          time       = milliseconds([&] { tiny(jobs); });
+          singleTiny = threads == 1 ? time : singleTiny;
+          report("tiny", threads, time, singleTiny, jobs.stats());
+
+          SharedQueuePool pool(threads);
+          time         = milliseconds([&] { tiny(pool); });
+          singleShared = threads == 1 ? time : singleShared;
+          fmt::print("{:<10} {:>7} {:>10.2f} {:>7.2f}x\n", "tiny fifo", threads, time, singleShared / time);
+     }
+     if (failures)
+          fmt::print("FAILED: {} sums differ from the serial ones\n", failures);
+
+     failures += coverage() + dependencies();
+     fmt::print("parallel-for and dependencies {}\n", failures ? "failed" : "ok");
+     return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+// Times Layout on a page of about 20k nodes: the first layout, a window resize, an update with
+// nothing changed and a single edited leaf, on the calling thread and on a job system. The two
+// results are compared node by node.
+//
+//   layout_bench [sections]
+
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#include "Layout.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+     constexpr int CARDS  = 50;
+     constexpr int LEAVES = 9;
+     constexpr int RUNS   = 20;
+
+     // page > sections laid out as grids > cards > leaves measured like wrapped text
+     std::vector<Layout::Id> build(Layout& layout, int sections) {
+          std::vector<Layout::Id> leaves;
+          auto page = layout.create(layout.root(), { .kind = Layout::Kind::COLUMN, .padding = { 16.f, 16.f, 16.f, 16.f }, .gap = 24.f, .align = Layout::Align::STRETCH });
+          for (int s = 0; s != sections; ++s) {
+               auto section = layout.create(page, { .kind = Layout::Kind::GRID, .padding = { 8.f, 8.f, 8.f, 8.f }, .gap = 8.f, .columns = 5 });
+               for (int c = 0; c != CARDS; ++c) {
+                    auto card = layout.create(section, { .kind = Layout::Kind::COLUMN, .padding = { 4.f, 4.f, 4.f, 4.f }, .gap = 2.f });
+                    for (int l = 0; l != LEAVES; ++l) {
+                         auto  leaf  = layout.create(card);
+                         float chars = static_cast<float>(8 + (s * 7 + c * 3 + l) % 40);
+                         layout.setMeasure(leaf, [chars](glm::vec2 available) {
+                              float width = chars * 7.f;
+                              float lines = std::max(1.f, std::ceil(width / std::max(available.x, 7.f)));
+                              return glm::vec2 { std::min(width, available.x), lines * 16.f };
+                         });
+                         leaves.push_back(leaf);
+                    }
+               }
+          }
+          return leaves;
+     }
+
+     template <typename F>
+     double microseconds(int n, F&& f) {
+          auto start = std::chrono::steady_clock::now();
+          for (int i = 0; i != n; ++i)
+               f(i);
+          return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / n;
+     }
+
+     void run(const char* name, Layout& layout, std::vector<Layout::Id>& leaves) {
+          fmt::print("{}\n", name);
+          fmt::print("  {:<12} {:10.1f} us\n", "first", microseconds(1, [&](int) { layout.update({ 1280.f, 720.f }); }));
+          auto stats = layout.stats();
+          fmt::print("  {} nodes, {} measured, {} cache hits, {} arranged, {} tasks\n", stats.nodes, stats.measured, stats.cacheHits, stats.arranged, stats.tasks);
+          fmt::print("  {:<12} {:10.1f} us\n", "resize", microseconds(RUNS, [&](int i) { layout.update({ 1280.f + static_cast<float>(i % 2 ? 40 : -40), 720.f }); }));
+          stats = layout.stats();
+          fmt::print("  {} measured, {} cache hits, {} arranged, {} changed\n", stats.measured, stats.cacheHits, stats.arranged, stats.changed);
+          fmt::print("  {:<12} {:10.1f} us\n", "unchanged", microseconds(RUNS, [&](int) { layout.update({ 1280.f + 40.f, 720.f }); }));
+          fmt::print("  {:<12} {:10.1f} us\n", "one leaf", microseconds(RUNS, [&](int i) {
+                          layout.invalidate(leaves[static_cast<size_t>(i) * 997 % leaves.size()]);
+                          layout.update({ 1280.f + 40.f, 720.f });
+                     }));
+          stats = layout.stats();
+          fmt::print("  {} measured, {} cache hits, {} arranged, {} changed\n", stats.measured, stats.cacheHits, stats.arranged, stats.changed);
+     }
+}
+
+int main(int argc, char* argv[]) {
+     int sections = argc > 1 ? std::stoi(argv[1]) : 40;
+
+     Layout serial;
+     auto   serialLeaves = build(serial, sections);
+     run("calling thread", serial, serialLeaves);
+
+     JobSystem  jobs;
+     Layout     parallel(&jobs);
+     auto       parallelLeaves = build(parallel, sections);
+     run(fmt::format("{} threads", jobs.size()).c_str(), parallel, parallelLeaves);
+
+     int mismatches { 0 };
+     serial.update({ 1000.f, 800.f });
+     parallel.update({ 1000.f, 800.f });
+     for (size_t i = 0; i != serialLeaves.size(); ++i) {
+          auto a = serialLeaves[i], b = parallelLeaves[i];
+          mismatches += serial.absolute(a) != parallel.absolute(b) || serial.size(a) != parallel.size(b);
+     }
+     fmt::print("{} mismatches in {} leaves\n", mismatches, serialLeaves.size());
+     return mismatches == 0 ? 0 : 1;
+}
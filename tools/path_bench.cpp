@@ -0,0 +1,206 @@
+// Times PathCache on a chart of thousands of cubics and a sheet of icons: tessellating them, and
+// drawing them again at the same and at a nearby scale. Checks that the vector and scalar curve
+// flattening agree, that filled areas come out right, and that a self-intersecting star overlapping
+// another contour covers what a point in polygon test says it should.
+//
+//   path_bench [curves]
+
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#include "Path.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+     constexpr int ICONS = 500;
+     constexpr int RUNS  = 20;
+
+     Path chart(int curves) {
+          Path path;
+          auto sample = [](int i) { return glm::vec2 { static_cast<float>(i) * 2.f, 100.f + 80.f * std::sin(static_cast<float>(i) * .05f) * std::cos(static_cast<float>(i) * .011f) }; };
+          path.moveTo(sample(0));
+          for (int i = 1; i <= curves; ++i) {
+               auto p0 = sample(i - 1), p1 = sample(i);
+               path.cubicTo(p0 + glm::vec2 { .7f, 0.f }, p1 - glm::vec2 { .7f, 0.f }, p1);
+          }
+          return path;
+     }
+
+     // a ring with a star cut out of it, in a 24 unit box
+     Path icon(int i) {
+          Path path;
+          path.circle({ 12.f, 12.f }, 11.f);
+          path.circle({ 12.f, 12.f }, 9.f);
+          for (int k = 0; k != 10; ++k) {
+               auto angle  = static_cast<float>(k) * .6283185f + static_cast<float>(i) * .01f;
+               auto radius = k % 2 ? 3.f : 7.f;
+               glm::vec2 point { 12.f + radius * std::cos(angle), 12.f + radius * std::sin(angle) };
+               if (k == 0)
+                    path.moveTo(point);
+               else
+                    path.quadTo((point + glm::vec2 { 12.f, 12.f }) / 2.f, point);
+          }
+          path.close();
+          return path;
+     }
+
+     // a pentagram, whose edges cross each other, overlapping a diamond
+     std::vector<std::vector<glm::vec2>> star() {
+          std::vector<glm::vec2> pentagram;
+          for (int k = 0; k != 5; ++k) {
+               auto angle = static_cast<float>(k * 2) * 1.2566371f - 1.5707963f;
+               pentagram.push_back({ 50.f + 40.f * std::cos(angle), 50.f + 40.f * std::sin(angle) });
+          }
+          return { pentagram, { { 70.f, 20.f }, { 95.f, 50.f }, { 70.f, 80.f }, { 45.f, 50.f } } };
+     }
+
+     // winding number of `point` against closed polygons, the reference a fill is checked against
+     int winding(const std::vector<std::vector<glm::vec2>>& polygons, glm::vec2 point) {
+          int sum { 0 };
+          for (auto& polygon : polygons)
+               for (size_t i = 0; i != polygon.size(); ++i) {
+                    auto a = polygon[i], b = polygon[(i + 1) % polygon.size()];
+                    auto side = (b.x - a.x) * (point.y - a.y) - (point.x - a.x) * (b.y - a.y);
+                    if (a.y <= point.y && b.y > point.y && side > 0.f)
+                         ++sum;
+                    else if (b.y <= point.y && a.y > point.y && side < 0.f)
+                         --sum;
+               }
+          return sum;
+     }
+
+     bool covers(const PathMesh& mesh, glm::vec2 point) {
+          auto cross = [](glm::vec2 a, glm::vec2 b, glm::vec2 p) { return (b.x - a.x) * (p.y - a.y) - (p.x - a.x) * (b.y - a.y); };
+          for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+               auto a = mesh.points[mesh.indices[i]], b = mesh.points[mesh.indices[i + 1]], c = mesh.points[mesh.indices[i + 2]];
+               auto d0 = cross(a, b, point), d1 = cross(b, c, point), d2 = cross(c, a, point);
+               if ((d0 >= 0.f && d1 >= 0.f && d2 >= 0.f) || (d0 <= 0.f && d1 <= 0.f && d2 <= 0.f))
+                    return true;
+          }
+          return false;
+     }
+
+     // points of a grid, off any edge, where the fill and the reference disagree
+     int coverage(PathCache& cache, const std::vector<std::vector<glm::vec2>>& polygons, FillRule rule) {
+          Path path;
+          for (auto& polygon : polygons) {
+               path.moveTo(polygon.front());
+               for (size_t i = 1; i != polygon.size(); ++i)
+                    path.lineTo(polygon[i]);
+               path.close();
+          }
+          auto mesh = cache.fill(path, 1.f, rule);
+          int  wrong { 0 };
+          for (int j = 0; j != 100; ++j)
+               for (int i = 0; i != 100; ++i) {
+                    glm::vec2 point { static_cast<float>(i) + .3183f, static_cast<float>(j) + .7071f };
+                    auto      turns  = winding(polygons, point);
+                    bool      inside = rule == FillRule::NON_ZERO ? turns != 0 : (turns & 1) != 0;
+                    wrong += inside != covers(*mesh, point);
+               }
+          return wrong;
+     }
+
+     double area(const PathMesh& mesh) {
+          double sum { 0. };
+          for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+               auto a = mesh.points[mesh.indices[i]], b = mesh.points[mesh.indices[i + 1]], c = mesh.points[mesh.indices[i + 2]];
+               sum += std::abs((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) / 2.;
+          }
+          return sum;
+     }
+
+     template <typename F>
+     double microseconds(int n, F&& f) {
+          auto start = std::chrono::steady_clock::now();
+          for (int i = 0; i != n; ++i)
+               f(i);
+          return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / n;
+     }
+}
+
+int main(int argc, char* argv[]) {
+     int  curves   = argc > 1 ? std::stoi(argv[1]) : 5000;
+     int  failures = 0;
+     auto check    = [&](bool ok, const std::string& what) {
+          if (!ok) {
+               fmt::print("FAILED: {}\n", what);
+               ++failures;
+          }
+     };
+
+     // flattening
+     std::vector<glm::vec2> vector, scalar;
+     glm::vec2              p0 { 0.f, 0.f }, p1 { 30.f, 90.f }, p2 { 70.f, -40.f }, p3 { 100.f, 10.f };
+     for (uint32_t n = 1; n != 64; ++n) {
+          vector.clear();
+          scalar.clear();
+          Tessellate::cubic(p0, p1, p2, p3, n, vector);
+          Tessellate::cubicScalar(p0, p1, p2, p3, n, scalar);
+          for (uint32_t i = 0; i != n; ++i)
+               check(glm::length(vector[i] - scalar[i]) < 1e-3f, fmt::format("flattening {} of {}", i, n));
+     }
+     vector.reserve(64 * 1000);
+     auto flatten = [&](auto f) {
+          return microseconds(RUNS * 10, [&](int) {
+               vector.clear();
+               for (int i = 0; i != 1000; ++i)
+                    f(p0, p1 + glm::vec2 { 0.f, static_cast<float>(i) * .01f }, p2, p3, 64, vector);
+          });
+     };
+     fmt::print("{:<24} {:10.1f} us\n", "flatten 64k, vector", flatten(Tessellate::cubic));
+     fmt::print("{:<24} {:10.1f} us\n", "flatten 64k, scalar", flatten(Tessellate::cubicScalar));
+
+     // areas
+     PathCache cache;
+     Path      disc;
+     disc.circle({ 0.f, 0.f }, 100.f);
+     check(std::abs(area(*cache.fill(disc, 1.f)) / (3.14159265 * 100. * 100.) - 1.) < 5e-3, "disc area");
+     Path frame;
+     frame.rect({ 0.f, 0.f }, { 10.f, 10.f });
+     frame.rect({ 2.f, 2.f }, { 6.f, 6.f });
+     check(std::abs(area(*cache.fill(frame, 1.f, FillRule::EVEN_ODD)) - 64.) < 1e-3, "even-odd frame area");
+     check(std::abs(area(*cache.fill(frame, 1.f, FillRule::NON_ZERO)) - 100.) < 1e-3, "non-zero frame area");
+     Path bar;
+     bar.moveTo({ 0.f, 0.f });
+     bar.lineTo({ 10.f, 0.f });
+     check(std::abs(area(*cache.stroke(bar, 1.f, { .width = 2.f, .cap = Stroke::Cap::SQUARE })) - 24.) < 1e-3, "square capped stroke area");
+     for (auto rule : { FillRule::NON_ZERO, FillRule::EVEN_ODD }) {
+          auto wrong = coverage(cache, star(), rule);
+          check(wrong == 0, fmt::format("{} star coverage, {} points wrong", rule == FillRule::NON_ZERO ? "non-zero" : "even-odd", wrong));
+     }
+
+     // chart
+     auto line  = chart(curves);
+     auto style = Stroke { .width = 1.5f, .join = Stroke::Join::ROUND };
+     fmt::print("{} curves\n", curves);
+     fmt::print("  {:<22} {:10.1f} us\n", "stroke", microseconds(1, [&](int) { cache.stroke(line, 2.f, style); }));
+     fmt::print("  {:<22} {:10.1f} us\n", "stroke again", microseconds(RUNS, [&](int) { cache.stroke(line, 2.f, style); }));
+     fmt::print("  {:<22} {:10.1f} us\n", "stroke, zoomed 5%", microseconds(RUNS, [&](int i) { cache.stroke(line, 2.f * (1.f + static_cast<float>(i % 2) * .05f), style); }));
+     auto mesh = cache.stroke(line, 2.f, style);
+     fmt::print("  {} vertices, {} triangles\n", mesh->points.size(), mesh->indices.size() / 3);
+
+     // icons
+     std::vector<Path> icons;
+     for (int i = 0; i != ICONS; ++i)
+          icons.push_back(icon(i));
+     size_t triangles { 0 };
+     fmt::print("{} icons\n", ICONS);
+     fmt::print("  {:<22} {:10.1f} us\n", "fill", microseconds(1, [&](int) {
+                     for (auto& path : icons)
+                          triangles += cache.fill(path, 1.f, FillRule::EVEN_ODD)->indices.size() / 3;
+                }));
+     fmt::print("  {:<22} {:10.1f} us\n", "fill again", microseconds(RUNS, [&](int) {
+                     for (auto& path : icons)
+                          cache.fill(path, 1.f, FillRule::EVEN_ODD);
+                }));
+     fmt::print("  {} triangles\n", triangles);
+
+     auto stats = cache.stats();
+     fmt::print("{} entries, {} hits, {} misses, {} evicted\n", stats.entries, stats.hits, stats.misses, stats.evicted);
+     return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+// Times every PixelConvert kernel on a 4K frame with each instruction set the CPU supports, after
+// checking the result against the scalar version.
+//
+//   pixel_bench [iterations]
+
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#include "PixelConvert.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+     constexpr size_t PIXELS = 3840 * 2160;
+
+     struct Kernel {
+          const char*                                             name;
+          size_t                                                  bytes; // read and written per pixel
+          std::function<void(const std::vector<uint8_t>&, std::vector<uint8_t>&)> run;
+     };
+
+     const char* isaName(PixelConvert::Isa isa) {
+          switch (isa) {
+               case PixelConvert::Isa::AVX2: return "avx2";
+               case PixelConvert::Isa::SSE2: return "sse2";
+               default: return "scalar";
+          }
+     }
+}
+
+int main(int argc, char* argv[]) {
+     int iterations = argc > 1 ? std::stoi(argv[1]) : 20;
+
+     std::vector<uint8_t> src(PIXELS * 4);
+     std::mt19937         random { 1 };
+     for (auto& byte : src)
+          byte = static_cast<uint8_t>(random());
+     // premultiplied input for unpremultiply has to have colour <= alpha
+     std::vector<uint8_t> premultiplied(src.size());
+     PixelConvert::scalar::premultiply(src.data(), premultiplied.data(), PIXELS);
+     std::vector<float> linear(PIXELS * 4);
+     PixelConvert::scalar::toLinear(src.data(), linear.data(), linear.size());
+
+     std::vector<Kernel> kernels {
+          { "expand grey", 5, [&](auto& in, auto& out) { PixelConvert::expandToRGBA(in.data(), 1, out.data(), PIXELS); } },
+          { "expand grey+alpha", 6, [&](auto& in, auto& out) { PixelConvert::expandToRGBA(in.data(), 2, out.data(), PIXELS); } },
+          { "expand rgb", 7, [&](auto& in, auto& out) { PixelConvert::expandToRGBA(in.data(), 3, out.data(), PIXELS); } },
+          { "swizzle", 8, [&](auto& in, auto& out) { PixelConvert::swizzleRB(in.data(), out.data(), PIXELS); } },
+          { "premultiply", 8, [&](auto& in, auto& out) { PixelConvert::premultiply(in.data(), out.data(), PIXELS); } },
+          { "unpremultiply", 8, [&](auto&, auto& out) { PixelConvert::unpremultiply(premultiplied.data(), out.data(), PIXELS); } },
+          { "srgb to linear", 20, [&](auto& in, auto& out) {
+                PixelConvert::toLinear(in.data(), linear.data(), PIXELS * 4);
+                std::memcpy(out.data(), linear.data(), out.size());
+           } },
+          { "linear to srgb", 20, [&](auto&, auto& out) { PixelConvert::toSrgb(linear.data(), out.data(), PIXELS * 4); } }
+     };
+
+     auto detected = PixelConvert::detect();
+     fmt::print("{} iterations of {} pixels, cpu supports {}\n", iterations, PIXELS, isaName(detected));
+     int mismatches { 0 };
+     for (auto& kernel : kernels) {
+          PixelConvert::setIsa(PixelConvert::Isa::SCALAR);
+          std::vector<uint8_t> expected(PIXELS * 4);
+          kernel.run(src, expected);
+
+          for (auto isa : { PixelConvert::Isa::SCALAR, PixelConvert::Isa::SSE2, PixelConvert::Isa::AVX2 }) {
+               if (isa > detected)
+                    continue;
+               PixelConvert::setIsa(isa);
+               std::vector<uint8_t> out(PIXELS * 4);
+               kernel.run(src, out);
+               bool match = out == expected;
+               mismatches += !match;
+
+               auto start = std::chrono::steady_clock::now();
+               for (int i = 0; i != iterations; ++i)
+                    kernel.run(src, out);
+               auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / iterations;
+               fmt::print("{:<18} {:<6} {:8.2f} ms {:8.1f} Mpix/s {:6.1f} GB/s{}\n", kernel.name, isaName(isa), seconds * 1e3,
+                  PIXELS / seconds / 1e6, static_cast<double>(PIXELS * kernel.bytes) / seconds / 1e9, match ? "" : "  MISMATCH");
+          }
+     }
+     return mismatches == 0 ? 0 : 1;
+}
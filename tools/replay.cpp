@@ -0,0 +1,56 @@
+// Draws a session recorded with `main --record <log>` offscreen and prints its frame times. Only the
+// scene is set up, on a renderer without a surface; nothing of the window system is included, so it
+// runs wherever there is a Vulkan device, a software one such as lavapipe included.
+//
+//   replay <log> [--unpaced]
+//
+// Paced it takes as long as the session did; unpaced it draws as fast as it can.
+
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define VOLK_IMPLEMENTATION
+#include "DebugMessenger.hpp"
+#include "EventSystem.hpp"
+#include "InputLog.hpp"
+#include "JobSystem.hpp"
+#include "Renderer.hpp"
+#include "Replay.hpp"
+#include "Scene.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+int main(int argc, char* argv[]) {
+     std::string path;
+     bool        paced { true };
+     for (int i = 1; i != argc; ++i) {
+          std::string_view argument { argv[i] };
+          if (argument == "--unpaced")
+               paced = false;
+          else
+               path = argument;
+     }
+     if (path.empty()) {
+          fmt::print("usage: replay <log> [--unpaced]\n");
+          return 1;
+     }
+
+     try {
+          Core           core(false);
+          DebugMessenger debug(&core);
+          JobSystem      jobs;
+          InputLog       log(path);
+          EventSystem    events;
+          Renderer       renderer(&core, VK_NULL_HANDLE, &jobs, { log.width(), log.height() });
+          Scene          scene(L"Replay", &events, &renderer);
+          Replay(&events, &renderer).run(log, paced).print();
+     }
+     catch (const std::exception& e) {
+          fmt::print("exception: {}\n", e.what());
+          return 1;
+     }
+     return 0;
+}
@@ -0,0 +1,59 @@
+// Converts JPEG / PNG images into .ctex containers next to the source, so the engine can map them
+// instead of decoding them at startup.
+//
+//   texture_import [--rgba] [--no-mips] <image>...
+//
+// Without --rgba opaque images are stored as BC1 and images with alpha as BC7, formats every desktop
+// GPU samples; the streamer falls back to the source image on devices that cannot.
+
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "TextureContainer.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+     bool                     compress { true };
+     bool                     mips { true };
+     std::vector<std::string> inputs;
+     for (int i = 1; i != argc; ++i) {
+          std::string arg = argv[i];
+          if (arg == "--rgba")
+               compress = false;
+          else if (arg == "--no-mips")
+               mips = false;
+          else
+               inputs.push_back(arg);
+     }
+     if (inputs.empty()) {
+          fmt::print("usage: {} [--rgba] [--no-mips] <image>...\n", argv[0]);
+          return 1;
+     }
+
+     int failures { 0 };
+     for (auto& input : inputs) {
+          try {
+               auto       start = std::chrono::steady_clock::now();
+               VkExtent2D extent {};
+               auto       rgba   = TextureData::decode(input, extent);
+               auto       opaque = BlockCompression::isOpaque(rgba.data(), static_cast<size_t>(extent.width) * extent.height);
+               auto       format = !compress ? VK_FORMAT_R8G8B8A8_SRGB : opaque ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC7_SRGB_BLOCK;
+               // the whole chain is stored, blitting needs a device and would undo the point of the file
+               auto data   = TextureData::fromRGBA(std::move(rgba), extent, format, mips, true);
+               auto output = std::filesystem::path(input).replace_extension(".ctex").string();
+               TextureContainer::write(output, data);
+               auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+               fmt::print("{} -> {}: {}x{}, {} levels, {} bytes, {:.1f} ms\n", input, output, extent.width, extent.height, data.levels.size(), data.bytes.size(), ms);
+          }
+          catch (const std::exception& e) {
+               fmt::print("{}: {}\n", input, e.what());
+               ++failures;
+          }
+     }
+     return failures == 0 ? 0 : 1;
+}